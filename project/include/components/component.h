@@ -20,8 +20,13 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #pragma once
 
+#include "componentstorage.h"
+
+#include "debug/stats.h"
 #include "types/rtti.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -31,6 +36,10 @@ namespace dc
 	// External Enums / Typedefs for global usage
 	// ===========================================================
 	class CGameObject;
+	class CChangeTracker;
+	
+	template<typename... Components>
+	class TScene;
 	
 	/**
 	 * \class CComponent
@@ -46,6 +55,11 @@ namespace dc
 		// ===========================================================
 		RTTI_BASE_DECLARATIONS(CComponent)
 		
+		friend class CScene;
+		
+		template<typename... Components>
+		friend class TScene;
+		
 		// ===========================================================
 		// Static fields / methods
 		// ===========================================================
@@ -61,22 +75,32 @@ namespace dc
 		// Getters / Setters
 		CGameObject*	GameObject() const					{ return mp_gameObject; }
 		void			GameObject(CGameObject* gameObject)	{ mp_gameObject = gameObject; }
+		
+		/**
+		 * Scene tick of the last change, see CScene::Tick
+		 */
+		const uint64_t	ChangedTick() const					{ return m_changedTick; }
 
 		template<typename ComponentType>
-		ComponentType*	GetComponent() const
-		{
-			return mp_gameObject->GetComponent<ComponentType>();
-		}
+		ComponentType*	GetComponent() const;
 
 		// ===========================================================
 		// Constructors
 		// ===========================================================
 	public:
 		CComponent():
-			mp_gameObject(0)
-		{}
+			mp_gameObject(0),
+			mp_changeTracker(0),
+			m_sceneIndex(0),
+			m_changedTick(0)
+		{
+			CStats::Instance().Constructed(EStatsSubsystem::Component);
+		}
 		
-		virtual ~CComponent() {}
+		virtual ~CComponent()
+		{
+			CStats::Instance().Destroyed(EStatsSubsystem::Component);
+		}
 		
 		CComponent(const CComponent& copy) = delete;
 		void operator= (const CComponent& copy) = delete;
@@ -97,15 +121,205 @@ namespace dc
 		virtual void Finish() {}
 		virtual void Sleep() {}
 		
+		/**
+		 * Returns a copy of the component for CGameObject::Instantiate, without game object.
+		 * Components that return NULL are left out of the clone.
+		 */
+		virtual CComponent* Clone() const { return 0; }
+		
+		/**
+		 * How scenes keep the components of this type, see DC_COMPONENT_STORAGE
+		 */
+		virtual const EComponentStorage StorageType() const { return EComponentStorage::PointerList; }
+		
+		/**
+		 * Awake runs on the thread pool of the scene, see CScene::ThreadPool. It may only touch
+		 * the component itself, the game object joins the scene once all its awakes are done.
+		 */
+		virtual const bool AsyncAwake() const { return false; }
+		
 		// ===========================================================
 		// Methods
 		// ===========================================================
+	public:
+		/**
+		 * Stamps the component with the current scene tick so systems looking for changes see it.
+		 * Does nothing while the component is not part of a scene.
+		 */
+		void MarkChanged();
 		
 		// ===========================================================
 		// Fields
 		// ===========================================================
 	private:
 		CGameObject*	mp_gameObject;
+		
+		CChangeTracker*	mp_changeTracker;	// Set by the scene while the component is in it
+		unsigned int	m_sceneIndex;		// Position in the scene list of its type
+		uint64_t		m_changedTick;
+	};
+	
+	/**
+	 * \class CChangeTracker
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Keeps the highest change tick of every chunk of a scene component list,
+	 * so searching for changes can skip whole chunks.
+	 */
+	class CChangeTracker
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const unsigned int CHUNK_SHIFT = 6;
+		static const unsigned int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const uint64_t		Tick()					const { return *mp_tick; }
+		const uint64_t		ChunkTick(const unsigned int chunk)	const { return m_chunkTickList[chunk]; }
+		const unsigned int	ChunkCount()			const { return m_chunkTickList.size(); }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CChangeTracker(const uint64_t* tick):
+			mp_tick(tick)
+		{}
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Mark(const unsigned int index)
+		{
+			m_chunkTickList[index >> CHUNK_SHIFT] = *mp_tick;
+		}
+		
+		/**
+		 * A component changed at tick moved to index
+		 */
+		void Raise(const unsigned int index, const uint64_t tick)
+		{
+			uint64_t& chunkTick = m_chunkTickList[index >> CHUNK_SHIFT];
+			chunkTick = std::max(chunkTick, tick);
+		}
+		
+		/**
+		 * Recomputes the chunks from firstIndex onwards, after the list has been resized or shifted
+		 */
+		template<typename ComponentList>
+		void Refresh(const ComponentList& componentList, const unsigned int firstIndex)
+		{
+			const unsigned int count = componentList.size();
+			m_chunkTickList.resize((count + CHUNK_SIZE - 1) >> CHUNK_SHIFT, 0);
+			
+			for(unsigned int chunk = firstIndex >> CHUNK_SHIFT; chunk < m_chunkTickList.size(); ++chunk)
+			{
+				uint64_t chunkTick = 0;
+				const unsigned int end = std::min(count, (chunk + 1) << CHUNK_SHIFT);
+				for(unsigned int i = chunk << CHUNK_SHIFT; i < end; ++i)
+				{
+					chunkTick = std::max(chunkTick, componentList[i]->ChangedTick());
+				}
+				m_chunkTickList[chunk] = chunkTick;
+			}
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		const uint64_t*			mp_tick;
+		std::vector<uint64_t>	m_chunkTickList;
+	};
+	
+	/**
+	 * \class CComponentSlots
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Components of a game object in the order they were added. The first few live
+	 * inside the object itself, adding more than that moves all of them to the heap.
+	 * The type name of every component is kept next to it, so looking up types doesn't
+	 * have to touch the components.
+	 */
+	class CComponentSlots
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const unsigned int INLINE_CAPACITY = 4;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int	Size() const		{ return m_size; }
+		const bool			IsInline() const	{ return mp_slots == m_inlineSlots; }
+		
+		CComponent*			operator[](const unsigned int index) const { return mp_slots[index]; }
+		const char*			Name(const unsigned int index) const { return mp_names[index]; }
+		
+		CComponent* const*	begin() const	{ return mp_slots; }
+		CComponent* const*	end() const		{ return mp_slots + m_size; }
+		
+		/**
+		 * First component of the type, NULL if there is none
+		 */
+		CComponent*			Find(const char* name) const;
+		const unsigned int	Count(const char* name) const;
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CComponentSlots():
+			mp_slots(m_inlineSlots),
+			mp_names(m_inlineNames),
+			m_size(0),
+			m_capacity(INLINE_CAPACITY)
+		{}
+		
+		~CComponentSlots()
+		{
+			if(!IsInline())
+			{
+				delete[] mp_slots;
+				delete[] mp_names;
+			}
+		}
+		
+		CComponentSlots(const CComponentSlots& copy) = delete;
+		void operator= (const CComponentSlots& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Add(CComponent* component);
+		
+		/**
+		 * Keeps the order of the rest, returns false if it wasn't there
+		 */
+		const bool Remove(CComponent* component);
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		CComponent**	mp_slots;
+		const char**	mp_names;
+		unsigned int	m_size;
+		unsigned int	m_capacity;
+		CComponent*		m_inlineSlots[INLINE_CAPACITY];
+		const char*		m_inlineNames[INLINE_CAPACITY];
 	};
 	
 	// ===========================================================
@@ -114,4 +328,81 @@ namespace dc
 	
 	using TComponentList		= std::vector<CComponent*>;
 	using TComponentListTable	= std::map<const char*, TComponentList>;
+	
+	// ===========================================================
+	// Template/Inline implementation
+	// ===========================================================
+	
+	inline CComponent* CComponentSlots::Find(const char* name) const
+	{
+		for(unsigned int i = 0; i < m_size; ++i)
+		{
+			if(mp_names[i] == name)
+			{
+				return mp_slots[i];
+			}
+		}
+		return 0;
+	}
+	
+	inline const unsigned int CComponentSlots::Count(const char* name) const
+	{
+		unsigned int count = 0;
+		for(unsigned int i = 0; i < m_size; ++i)
+		{
+			if(mp_names[i] == name)
+			{
+				++count;
+			}
+		}
+		return count;
+	}
+	
+	inline void CComponentSlots::Add(CComponent* component)
+	{
+		if(m_size == m_capacity)
+		{
+			const unsigned int capacity = m_capacity * 2;
+			CComponent** slots = new CComponent*[capacity];
+			const char** names = new const char*[capacity];
+			std::copy(mp_slots, mp_slots + m_size, slots);
+			std::copy(mp_names, mp_names + m_size, names);
+			CStats::Instance().Allocated(EStatsSubsystem::GameObject, capacity * (sizeof(CComponent*) + sizeof(const char*)));
+			
+			if(!IsInline())
+			{
+				delete[] mp_slots;
+				delete[] mp_names;
+			}
+			mp_slots = slots;
+			mp_names = names;
+			m_capacity = capacity;
+		}
+		mp_names[m_size] = component->InstanceName();
+		mp_slots[m_size++] = component;
+	}
+	
+	inline const bool CComponentSlots::Remove(CComponent* component)
+	{
+		CComponent** slotIt = std::find(mp_slots, mp_slots + m_size, component);
+		if(slotIt == mp_slots + m_size)
+		{
+			return false;
+		}
+		
+		const unsigned int index = slotIt - mp_slots;
+		std::copy(slotIt + 1, mp_slots + m_size, slotIt);
+		std::copy(mp_names + index + 1, mp_names + m_size, mp_names + index);
+		--m_size;
+		return true;
+	}
+	
+	inline void CComponent::MarkChanged()
+	{
+		if(mp_changeTracker)
+		{
+			m_changedTick = mp_changeTracker->Tick();
+			mp_changeTracker->Mark(m_sceneIndex);
+		}
+	}
 }
\ No newline at end of file
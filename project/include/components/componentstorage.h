@@ -0,0 +1,381 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  componentstorage.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "debug/stats.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	/**
+	 * How a scene keeps the components of a type
+	 */
+	enum class EComponentStorage
+	{
+		PointerList,	// In insertion order, removals keep the order. The default.
+		Dense,			// Allocated from packed per type chunks and iterated in memory order
+		Sparse			// Indexed by game object id, removals swap the last one in
+	};
+	
+	/**
+	 * Storage of the component type, PointerList unless the type declares another one with
+	 * DC_COMPONENT_STORAGE. It can also be specialized for types that can't be touched.
+	 */
+	template<typename CT, typename Enable = void>
+	struct TComponentStorage : std::integral_constant<EComponentStorage, EComponentStorage::PointerList> {};
+	
+	template<typename CT>
+	struct TComponentStorage<CT, typename std::conditional<true, void, decltype(CT::STORAGE)>::type> : std::integral_constant<EComponentStorage, CT::STORAGE> {};
+	
+	/**
+	 * \class TDenseComponentPool
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Chunks of memory for the components of type CT, so they end up next to each other
+	 * instead of scattered over the heap. Freed slots are reused before growing.
+	 * Types derived from CT don't fit in the slots and go to the heap.
+	 */
+	template<typename CT>
+	class TDenseComponentPool
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const unsigned int CHUNK_SIZE = 256;
+		
+	private:
+		union CSlot
+		{
+			CSlot*	mp_next;
+			typename std::aligned_storage<sizeof(CT), alignof(CT)>::type	m_storage;
+		};
+		
+		// ===========================================================
+		// Static fields / methods
+		// ===========================================================
+	public:
+		/**
+		 * Never destroyed, components may be deleted during static destruction
+		 */
+		static TDenseComponentPool& Instance()
+		{
+			static TDenseComponentPool* s_pool = new TDenseComponentPool();
+			return *s_pool;
+		}
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int ChunkCount()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_chunkList.size();
+		}
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	private:
+		TDenseComponentPool():
+			mp_free(0)
+		{}
+		
+	public:
+		TDenseComponentPool(const TDenseComponentPool& copy) = delete;
+		void operator= (const TDenseComponentPool& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void* Allocate(const std::size_t size)
+		{
+			if(size != sizeof(CT))
+			{
+				return ::operator new(size);
+			}
+			
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if(!mp_free)
+			{
+				Grow();
+			}
+			
+			CSlot* slot = mp_free;
+			mp_free = slot->mp_next;
+			return slot;
+		}
+		
+		void Deallocate(void* pointer, const std::size_t size)
+		{
+			if(!pointer)
+			{
+				return;
+			}
+			
+			if(size != sizeof(CT))
+			{
+				::operator delete(pointer);
+				return;
+			}
+			
+			std::lock_guard<std::mutex> lock(m_mutex);
+			CSlot* slot = static_cast<CSlot*>(pointer);
+			slot->mp_next = mp_free;
+			mp_free = slot;
+		}
+		
+	private:
+		void Grow()
+		{
+			CSlot* chunk = static_cast<CSlot*>(::operator new(CHUNK_SIZE * sizeof(CSlot)));
+			m_chunkList.push_back(chunk);
+			CStats::Instance().Allocated(EStatsSubsystem::Component, CHUNK_SIZE * sizeof(CSlot));
+			
+			// Linked backwards, so a fresh chunk hands out increasing addresses
+			for(unsigned int i = CHUNK_SIZE; i > 0; --i)
+			{
+				chunk[i - 1].mp_next = mp_free;
+				mp_free = &chunk[i - 1];
+			}
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::mutex				m_mutex;
+		CSlot*					mp_free;
+		std::vector<CSlot*>		m_chunkList;
+	};
+	
+	/**
+	 * Memory for the components of type CT, from its dense pool when the type asks for it
+	 */
+	template<typename CT, EComponentStorage Storage>
+	struct TComponentAllocator
+	{
+		static void* Allocate(const std::size_t size) { return ::operator new(size); }
+		static void Deallocate(void* pointer, const std::size_t) { ::operator delete(pointer); }
+	};
+	
+	template<typename CT>
+	struct TComponentAllocator<CT, EComponentStorage::Dense>
+	{
+		static void* Allocate(const std::size_t size) { return TDenseComponentPool<CT>::Instance().Allocate(size); }
+		static void Deallocate(void* pointer, const std::size_t size) { TDenseComponentPool<CT>::Instance().Deallocate(pointer, size); }
+	};
+	
+	/**
+	 * \class CSparseIndex
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Maps game object ids to positions in a scene component list. The ids are split
+	 * in pages that are only allocated once an id in them is used and freed once none is.
+	 * Ids are never reused, so only the pages between the lowest and highest ids in use are kept.
+	 */
+	class CSparseIndex
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const unsigned int PAGE_SHIFT = 10;
+		static const unsigned int PAGE_SIZE = 1 << PAGE_SHIFT;
+		static const unsigned int NONE = ~0u;
+		
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	private:
+		struct CPage
+		{
+			std::unique_ptr<unsigned int[]>	mp_positionList;
+			unsigned int					m_count;		// Keys set in the page
+		};
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		/**
+		 * Position of the key, NONE when it isn't there
+		 */
+		const unsigned int Get(const unsigned int key) const
+		{
+			// Keys below the first page wrap around and land past the end too
+			const unsigned int page = (key >> PAGE_SHIFT) - m_firstPage;
+			if(page >= m_pageList.size() || !m_pageList[page].mp_positionList)
+			{
+				return NONE;
+			}
+			return m_pageList[page].mp_positionList[key & (PAGE_SIZE - 1)];
+		}
+		
+		/**
+		 * Number of pages allocated
+		 */
+		const unsigned int PageCount() const
+		{
+			unsigned int count = 0;
+			for(const CPage& page : m_pageList)
+			{
+				count += page.mp_positionList != nullptr;
+			}
+			return count;
+		}
+		
+		void Set(const unsigned int key, const unsigned int index)
+		{
+			assert(index != NONE && "[CSparseIndex::Set] Use Clear to take a key out");
+			
+			const unsigned int keyPage = key >> PAGE_SHIFT;
+			if(m_pageList.empty())
+			{
+				m_firstPage = keyPage;
+			}
+			else if(keyPage < m_firstPage)
+			{
+				// The pages in use move to the back to make room below them
+				const unsigned int extraPages = m_firstPage - keyPage;
+				m_pageList.resize(m_pageList.size() + extraPages);
+				std::move_backward(m_pageList.begin(), m_pageList.end() - extraPages, m_pageList.end());
+				m_firstPage = keyPage;
+			}
+			
+			const unsigned int page = keyPage - m_firstPage;
+			if(page >= m_pageList.size())
+			{
+				m_pageList.resize(page + 1);
+			}
+			
+			CPage& keyPageEntry = m_pageList[page];
+			if(!keyPageEntry.mp_positionList)
+			{
+				keyPageEntry.mp_positionList.reset(new unsigned int[PAGE_SIZE]);
+				keyPageEntry.m_count = 0;
+				std::fill(keyPageEntry.mp_positionList.get(), keyPageEntry.mp_positionList.get() + PAGE_SIZE, (unsigned int)NONE);
+				CStats::Instance().Allocated(EStatsSubsystem::Scene, PAGE_SIZE * sizeof(unsigned int));
+			}
+			
+			unsigned int& position = keyPageEntry.mp_positionList[key & (PAGE_SIZE - 1)];
+			keyPageEntry.m_count += position == NONE;
+			position = index;
+		}
+		
+		void Clear(const unsigned int key)
+		{
+			const unsigned int page = (key >> PAGE_SHIFT) - m_firstPage;
+			if(page >= m_pageList.size() || !m_pageList[page].mp_positionList)
+			{
+				return;
+			}
+			
+			CPage& keyPageEntry = m_pageList[page];
+			unsigned int& position = keyPageEntry.mp_positionList[key & (PAGE_SIZE - 1)];
+			if(position == NONE)
+			{
+				return;
+			}
+			
+			position = NONE;
+			if(--keyPageEntry.m_count == 0)
+			{
+				FreePage(page);
+			}
+		}
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CSparseIndex():
+			m_firstPage(0)
+		{}
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	private:
+		void FreePage(const unsigned int page)
+		{
+			m_pageList[page].mp_positionList.reset();
+			
+			// Empty pages at either end aren't kept, nor any of the page list below the lowest id in use
+			unsigned int end = m_pageList.size();
+			while(end > 0 && !m_pageList[end - 1].mp_positionList)
+			{
+				--end;
+			}
+			m_pageList.resize(end);
+			
+			unsigned int begin = 0;
+			while(begin < end && !m_pageList[begin].mp_positionList)
+			{
+				++begin;
+			}
+			m_pageList.erase(m_pageList.begin(), m_pageList.begin() + begin);
+			m_firstPage += begin;
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::vector<CPage>	m_pageList;
+		unsigned int		m_firstPage;		// Page of the lowest keys in m_pageList
+	};
+}
+
+/**
+ * Declares the storage of a component type. Goes in the class body, after RTTI_DECLARATIONS.
+ */
+#define DC_COMPONENT_STORAGE(Type, Storage) \
+	public: \
+		static const dc::EComponentStorage STORAGE = dc::EComponentStorage::Storage; \
+		\
+		const dc::EComponentStorage StorageType() const override { return STORAGE; } \
+		\
+		static void* operator new(const std::size_t size) \
+		{ \
+			return dc::TComponentAllocator<Type, STORAGE>::Allocate(size); \
+		} \
+		\
+		static void operator delete(void* pointer, const std::size_t size) \
+		{ \
+			dc::TComponentAllocator<Type, STORAGE>::Deallocate(pointer, size); \
+		}
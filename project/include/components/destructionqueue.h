@@ -0,0 +1,102 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  destructionqueue.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <deque>
+
+#include "gameobject.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	/**
+	 * Work allowed per Process call, zero means no limit
+	 */
+	struct CDestructionBudget
+	{
+		unsigned int	m_maxGameObjects;
+		unsigned int	m_maxMicroseconds;
+		
+		CDestructionBudget():
+			m_maxGameObjects(256),
+			m_maxMicroseconds(1000)
+		{}
+	};
+	
+	/**
+	 * \class CDestructionQueue
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Deletes game objects a few at a time so mass despawns don't stall a frame.
+	 * Queued hierarchies are deleted children first and must not be used once queued.
+	 */
+	class CDestructionQueue
+	{
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int			Pending() const	{ return m_pendingList.size(); }
+		
+		const CDestructionBudget&	Budget() const	{ return m_budget; }
+		void						Budget(const CDestructionBudget& budget)	{ m_budget = budget; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CDestructionQueue() {}
+		~CDestructionQueue();
+		
+		CDestructionQueue(const CDestructionQueue& copy) = delete;
+		void operator= (const CDestructionQueue& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Queues the game object and its whole hierarchy. It must be out of any scene and unlinked from its parent.
+		 */
+		void Enqueue(CGameObject* root);
+		
+		/**
+		 * Deletes queued game objects until the budget runs out, returns how many were deleted
+		 */
+		const unsigned int Process();
+		
+		/**
+		 * Deletes everything regardless of the budget
+		 */
+		void Flush();
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		CDestructionBudget			m_budget;
+		std::deque<CGameObject*>	m_pendingList;
+	};
+}
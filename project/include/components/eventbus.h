@@ -0,0 +1,437 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  eventbus.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	/**
+	 * Points of the scene update where events are delivered
+	 */
+	enum class EEventPhase
+	{
+		AfterUpdate,	// After the components Update, before timers and tasks
+		EndOfFrame,		// After the removed game objects are finished
+		Count
+	};
+	
+	template<typename EventType>
+	using TEventHandler = std::function<void(const EventType* events, const unsigned int count)>;
+	
+	/**
+	 * \class CEventBus
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Typed events between components. Publishing appends the event to a queue owned by the
+	 * event type and the calling thread, so producers never share a queue and don't lock.
+	 * Subscribers get the events in batches, one per producing thread, when the scene reaches
+	 * their phase. Every subscriber sees every event once, events published while delivering
+	 * are delivered from the next phase on. The queues keep their memory, so once they have grown
+	 * publishing doesn't allocate.
+	 *
+	 * Publishing can happen from any thread, but never at the same time as Dispatch.
+	 * Subscribing happens on the thread that dispatches.
+	 */
+	class CEventBus
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const unsigned int TYPE_BITS = 6;
+		static const unsigned int MAX_EVENT_TYPES = 1 << TYPE_BITS;
+		static const unsigned int MAX_THREAD_SLOTS = 64;
+		static const unsigned int PHASE_COUNT = (unsigned int)EEventPhase::Count;
+		
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	private:
+		class CChannelBase
+		{
+		public:
+			virtual ~CChannelBase() {}
+			virtual void Dispatch(const unsigned int phase) = 0;
+			virtual void EndDispatch() = 0;
+			virtual void Recycle() = 0;
+			virtual const bool Unsubscribe(const uint64_t id) = 0;
+			virtual const unsigned int Pending() const = 0;
+		};
+		
+		template<typename EventType>
+		struct CQueue
+		{
+			std::vector<EventType>	m_eventList;
+			std::vector<EventType>	m_deferredList;		// Published while dispatching
+			unsigned int			m_cursor[PHASE_COUNT];	// Events already delivered in each phase
+			char					m_padding[64];			// Queues of other threads stay off this cache line
+			
+			CQueue() { std::fill(m_cursor, m_cursor + PHASE_COUNT, 0); }
+		};
+		
+		template<typename EventType>
+		struct CSubscriber
+		{
+			uint64_t					m_id;
+			TEventHandler<EventType>	m_handler;
+		};
+		
+		template<typename EventType>
+		class CChannel : public CChannelBase
+		{
+		public:
+			CChannel(const bool& dispatching);
+			~CChannel() override;
+			
+			CQueue<EventType>& Queue(const unsigned int slot);
+			CQueue<EventType>& CreateQueue(const unsigned int slot);
+			
+			void Subscribe(const uint64_t id, const EEventPhase phase, const TEventHandler<EventType>& handler);
+			
+			void Dispatch(const unsigned int phase) override;
+			void EndDispatch() override;
+			void Recycle() override;
+			const bool Unsubscribe(const uint64_t id) override;
+			const unsigned int Pending() const override;
+			
+		private:
+			const bool&								m_dispatching;
+			std::atomic<CQueue<EventType>*>			m_queueList[MAX_THREAD_SLOTS];
+			std::deque<CSubscriber<EventType>>		m_subscriberList[PHASE_COUNT];	// Deque, so subscribing doesn't move the running handler
+		};
+		
+		// ===========================================================
+		// Static fields / methods
+		// ===========================================================
+	public:
+		/**
+		 * Process wide index of the event type, given the first time it's asked for.
+		 * Asking for more than MAX_EVENT_TYPES types stops the process.
+		 */
+		template<typename EventType>
+		static const unsigned int TypeIndex()
+		{
+			static const unsigned int s_index = NextTypeIndex();
+			return s_index;
+		}
+		
+	private:
+		static const unsigned int NextTypeIndex();
+		
+		/**
+		 * Slot of the calling thread, returned when the thread ends.
+		 * More than MAX_THREAD_SLOTS live publishing threads stop the process.
+		 */
+		static const unsigned int ThreadSlot()
+		{
+			// Constant initialized, so reading it is a plain thread local load
+			static thread_local unsigned int tp_slot = MAX_THREAD_SLOTS;
+			if(tp_slot == MAX_THREAD_SLOTS)
+			{
+				tp_slot = AcquireThreadSlot();
+			}
+			return tp_slot;
+		}
+		
+		static const unsigned int AcquireThreadSlot();
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		/**
+		 * Events waiting to be delivered to some phase
+		 */
+		const unsigned int Pending() const;
+		
+		const bool Dispatching() const { return m_dispatching; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CEventBus();
+		~CEventBus();
+		
+		CEventBus(const CEventBus& copy) = delete;
+		void operator= (const CEventBus& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		template<typename EventType>
+		void Publish(const EventType& event);
+		
+		template<typename EventType>
+		void Publish(const EventType* events, const unsigned int count);
+		
+		/**
+		 * The handler receives the events of the type in batches when the phase is dispatched.
+		 * Returns the id to unsubscribe.
+		 */
+		template<typename EventType>
+		const uint64_t Subscribe(const EEventPhase phase, const TEventHandler<EventType>& handler);
+		
+		/**
+		 * Safe from inside a handler, the subscriber won't be called again
+		 */
+		void Unsubscribe(const uint64_t id);
+		
+		/**
+		 * Delivers to the subscribers of the phase the events they haven't seen
+		 */
+		void Dispatch(const EEventPhase phase);
+		
+		/**
+		 * Drops the events every phase has seen. The scene calls it once per update after the last phase.
+		 */
+		void Recycle();
+		
+	private:
+		template<typename EventType>
+		CChannel<EventType>& Channel();
+		
+		/**
+		 * Out of line so the lookup stays small enough to be inlined in Publish
+		 */
+		CChannelBase* CreateChannel(const unsigned int index, CChannelBase* (*factory)(const bool& dispatching));
+		
+		template<typename EventType>
+		static CChannelBase* NewChannel(const bool& dispatching) { return new CChannel<EventType>(dispatching); }
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::atomic<CChannelBase*>	m_channelList[MAX_EVENT_TYPES];
+		bool						m_dispatching;
+		uint64_t					m_nextSubscriberId;
+	};
+	
+	// ===========================================================
+	// Template/Inline implementation
+	// ===========================================================
+	
+	template<typename EventType>
+	CEventBus::CChannel<EventType>::CChannel(const bool& dispatching):
+		m_dispatching(dispatching)
+	{
+		for(auto& queue : m_queueList)
+		{
+			queue.store(0, std::memory_order_relaxed);
+		}
+	}
+	
+	template<typename EventType>
+	CEventBus::CChannel<EventType>::~CChannel()
+	{
+		for(auto& queue : m_queueList)
+		{
+			delete queue.load(std::memory_order_relaxed);
+		}
+	}
+	
+	template<typename EventType>
+	CEventBus::CQueue<EventType>& CEventBus::CChannel<EventType>::Queue(const unsigned int slot)
+	{
+		// Only the thread owning the slot writes it, relaxed is enough to read it back
+		CQueue<EventType>* queue = m_queueList[slot].load(std::memory_order_relaxed);
+		return queue ? *queue : CreateQueue(slot);
+	}
+	
+	template<typename EventType>
+	CEventBus::CQueue<EventType>& CEventBus::CChannel<EventType>::CreateQueue(const unsigned int slot)
+	{
+		CQueue<EventType>* queue = new CQueue<EventType>();
+		m_queueList[slot].store(queue, std::memory_order_release);
+		return *queue;
+	}
+	
+	template<typename EventType>
+	void CEventBus::CChannel<EventType>::Subscribe(const uint64_t id, const EEventPhase phase, const TEventHandler<EventType>& handler)
+	{
+		m_subscriberList[(unsigned int)phase].push_back(CSubscriber<EventType> { id, handler });
+	}
+	
+	template<typename EventType>
+	void CEventBus::CChannel<EventType>::Dispatch(const unsigned int phase)
+	{
+		auto& subscriberList = m_subscriberList[phase];
+		
+		for(auto& slot : m_queueList)
+		{
+			CQueue<EventType>* queue = slot.load(std::memory_order_acquire);
+			if(!queue)
+			{
+				continue;
+			}
+			
+			const unsigned int begin = queue->m_cursor[phase];
+			const unsigned int end = queue->m_eventList.size();
+			if(begin == end)
+			{
+				continue;
+			}
+			
+			// Handlers publishing now go to the deferred list, the batch doesn't move
+			const EventType* events = queue->m_eventList.data() + begin;
+			const unsigned int subscriberCount = subscriberList.size();
+			for(unsigned int i = 0; i < subscriberCount; ++i)
+			{
+				if(subscriberList[i].m_handler)
+				{
+					subscriberList[i].m_handler(events, end - begin);
+				}
+			}
+			queue->m_cursor[phase] = end;
+		}
+	}
+	
+	template<typename EventType>
+	void CEventBus::CChannel<EventType>::EndDispatch()
+	{
+		for(auto& slot : m_queueList)
+		{
+			CQueue<EventType>* queue = slot.load(std::memory_order_acquire);
+			if(queue && !queue->m_deferredList.empty())
+			{
+				queue->m_eventList.insert(queue->m_eventList.end(), queue->m_deferredList.begin(), queue->m_deferredList.end());
+				queue->m_deferredList.clear();
+			}
+		}
+	}
+	
+	template<typename EventType>
+	void CEventBus::CChannel<EventType>::Recycle()
+	{
+		for(auto& slot : m_queueList)
+		{
+			CQueue<EventType>* queue = slot.load(std::memory_order_acquire);
+			if(!queue)
+			{
+				continue;
+			}
+			
+			// Events some phase hasn't seen yet stay for the next update
+			const unsigned int seen = *std::min_element(queue->m_cursor, queue->m_cursor + PHASE_COUNT);
+			queue->m_eventList.erase(queue->m_eventList.begin(), queue->m_eventList.begin() + seen);
+			for(unsigned int& cursor : queue->m_cursor)
+			{
+				cursor -= seen;
+			}
+		}
+		
+		for(auto& subscriberList : m_subscriberList)
+		{
+			for(auto it = subscriberList.begin(); it != subscriberList.end();)
+			{
+				it = it->m_handler ? it + 1 : subscriberList.erase(it);
+			}
+		}
+	}
+	
+	template<typename EventType>
+	const bool CEventBus::CChannel<EventType>::Unsubscribe(const uint64_t id)
+	{
+		for(auto& subscriberList : m_subscriberList)
+		{
+			for(auto& subscriber : subscriberList)
+			{
+				if(subscriber.m_id == id && subscriber.m_handler)
+				{
+					// Erased in Recycle, a dispatch may be walking the list
+					subscriber.m_handler = nullptr;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	
+	template<typename EventType>
+	const unsigned int CEventBus::CChannel<EventType>::Pending() const
+	{
+		unsigned int pending = 0;
+		for(auto& slot : m_queueList)
+		{
+			const CQueue<EventType>* queue = slot.load(std::memory_order_acquire);
+			if(queue)
+			{
+				pending += queue->m_eventList.size() - *std::min_element(queue->m_cursor, queue->m_cursor + PHASE_COUNT);
+			}
+		}
+		return pending;
+	}
+	
+	template<typename EventType>
+	CEventBus::CChannel<EventType>& CEventBus::Channel()
+	{
+		// Always in range, NextTypeIndex stops the process before handing out one past the table
+		const unsigned int index = TypeIndex<EventType>();
+		CChannelBase* channel = m_channelList[index].load(std::memory_order_acquire);
+		if(!channel)
+		{
+			channel = CreateChannel(index, &NewChannel<EventType>);
+		}
+		return *static_cast<CChannel<EventType>*>(channel);
+	}
+	
+	template<typename EventType>
+	void CEventBus::Publish(const EventType& event)
+	{
+		CQueue<EventType>& queue = Channel<EventType>().Queue(ThreadSlot());
+		std::vector<EventType>& eventList = m_dispatching ? queue.m_deferredList : queue.m_eventList;
+		eventList.push_back(event);
+	}
+	
+	template<typename EventType>
+	void CEventBus::Publish(const EventType* events, const unsigned int count)
+	{
+		CQueue<EventType>& queue = Channel<EventType>().Queue(ThreadSlot());
+		std::vector<EventType>& eventList = m_dispatching ? queue.m_deferredList : queue.m_eventList;
+		eventList.insert(eventList.end(), events, events + count);
+	}
+	
+	template<typename EventType>
+	const uint64_t CEventBus::Subscribe(const EEventPhase phase, const TEventHandler<EventType>& handler)
+	{
+		assert(handler && "[CEventBus::Subscribe] The handler can't be empty");
+		assert(phase != EEventPhase::Count && "[CEventBus::Subscribe] Count isn't a phase");
+		
+		// The low bits keep the type, so Unsubscribe goes straight to the channel
+		const uint64_t id = (m_nextSubscriberId++ << TYPE_BITS) | TypeIndex<EventType>();
+		Channel<EventType>().Subscribe(id, phase, handler);
+		return id;
+	}
+}
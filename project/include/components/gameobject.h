@@ -20,7 +20,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #pragma once
 
+#include <cassert>
+
 #include "component.h"
+#include "gameobjectblock.h"
+#include "transform.h"
 
 namespace dc
 {
@@ -28,7 +32,19 @@ namespace dc
 	// External Enums / Typedefs for global usage
 	// ===========================================================
 
-	class CTransform;
+	class CGameObjectMgr;
+	class CSceneBase;
+	class CSceneRecorder;
+	
+	/**
+	 * Pending departure of a game object from its scene, carried out when the scene finishes its update
+	 */
+	enum class ESceneRemoval
+	{
+		None,
+		Remove,		// Leaves the scene
+		Destroy		// Leaves the scene and is destroyed with its hierarchy
+	};
 
 	/**
 	 * \class CGameObject
@@ -39,6 +55,8 @@ namespace dc
 	 */
 	class CGameObject
 	{
+		friend class CGameObjectMgr;
+		
 		// ===========================================================
 		// Constant / Enums / Typedefs internal usage
 		// ===========================================================
@@ -53,6 +71,17 @@ namespace dc
 			return gameObject;
 		}
 		
+		/**
+		 * Clones the game object and all its children: names, local transforms and the components
+		 * that implement CComponent::Clone. The clones are allocated in a single block but can be
+		 * deleted one by one as usual. The clone has no parent, isn't in any scene and is active.
+		 */
+		static CGameObject* Instantiate(const CGameObject* original);
+		
+		static void* operator new(std::size_t size)				{ return CGameObjectBlock::Allocate(size); }
+		static void* operator new(std::size_t, void* slot)		{ return slot; }
+		static void operator delete(void* pointer)				{ CGameObjectBlock::Deallocate(pointer); }
+		
 		// ===========================================================
 		// Inner and Anonymous Classes
 		// ===========================================================
@@ -61,16 +90,54 @@ namespace dc
 		// Getter & Setter
 		// ===========================================================
 	public:
+		/**
+		 * Unique in the process, never reused
+		 */
+		const unsigned int			Id() const						{ return m_id; }
+		
 		const char*					Name() const					{ return mp_name; }
 		void						Name(const char* name)			{ mp_name = name; }
 		
-		CTransform*					Transform() const				{ return mp_transform; }
+		/**
+		 * The transform lives inside the game object and is always its first component
+		 */
+		CTransform*					Transform() const				{ return &m_transform; }
+		
+		/**
+		 * Scene the game object has been added to, NULL when it's in none
+		 */
+		CSceneBase*					Scene() const					{ return mp_scene; }
+		void						Scene(CSceneBase* scene)		{ mp_scene = scene; }
+		
+		/**
+		 * Set by the scene on Remove and Destroy, cleared once a removed game object is out
+		 */
+		const ESceneRemoval			Removal() const					{ return m_removal; }
+		void						Removal(const ESceneRemoval removal)	{ m_removal = removal; }
+		
+		/**
+		 * Recorder of the scene, NULL when the game object isn't in a recorded scene
+		 */
+		CSceneRecorder*				Recorder() const;
+		
+		/**
+		 * Manager that owns the game object, NULL when it isn't registered
+		 */
+		CGameObjectMgr*				Manager() const					{ return mp_manager; }
+		const uint64_t				Handle() const					{ return m_handle; }
+		
+		/**
+		 * Set by the scene interest management, inactive game objects stay in the scene
+		 * but their components don't update while it is enabled
+		 */
+		const bool					Active() const					{ return m_active; }
+		void						Active(const bool active);
 		
 		const bool					HasChild(const char* name) const;
 		
 		const unsigned int			ComponentsNum(const char* compId) const;
 
-		const TComponentListTable&	ComponentsTable() const			{ return m_componentTable; }
+		const CComponentSlots&		Components() const				{ return m_components; }
 		
 		/**
 		 * Returns the first component of the specified type
@@ -83,9 +150,6 @@ namespace dc
 		 */
 		template<typename ComponentType>
 		std::vector<ComponentType*>	GetComponents() const;
-
-	private:
-		const TComponentList&		GetComponents(const char* compId) const;
 		
 		// ===========================================================
 		// Constructors
@@ -98,6 +162,12 @@ namespace dc
 		
 		CGameObject(const CGameObject& copy) = delete;
 		
+	private:
+		/**
+		 * Clone of original without its components, appended to the children of parent
+		 */
+		CGameObject(const CGameObject& original, CGameObject* parent);
+		
 		// ===========================================================
 		// Methods for/from SuperClass/Interfaces
 		// ===========================================================
@@ -117,7 +187,8 @@ namespace dc
 		ComponentType* AddComponent(Args... args);
 		
 		/**
-		 * Removes a component of the specified type from the GameObject and destroys it
+		 * Removes a component of the specified type from the GameObject and destroys it.
+		 * In a scene it sleeps now, and finishes and is destroyed when the update finishes.
 		 */
 		void RemoveComponent(const char* name);
 
@@ -130,9 +201,15 @@ namespace dc
 		// Fields
 		// ===========================================================
 	private:
+		unsigned int		m_id;
 		const char*			mp_name;
-		CTransform*			mp_transform;
-		TComponentListTable	m_componentTable;
+		CSceneBase*			mp_scene;
+		CGameObjectMgr*		mp_manager;
+		uint64_t			m_handle;
+		bool				m_active;
+		ESceneRemoval		m_removal;
+		CComponentSlots		m_components;
+		mutable CTransform	m_transform;		// Transform() hands it out from const game objects too
 	};
 	
 	// ===========================================================
@@ -147,22 +224,33 @@ namespace dc
 	template<typename ComponentType>
 	ComponentType* CGameObject::GetComponent() const
 	{
-		const TComponentList& componentList = GetComponents(ComponentType::TypeName());
-		return componentList.front()->DirectCast<ComponentType>();
+		CStats::Instance().ComponentLookups().Increment();
+		CComponent* component = m_components.Find(ComponentType::TypeName());
+		assert(component && "[CGameObject::GetComponent] You shouldn't be asking for Components that doesn't exist");
+		return component->DirectCast<ComponentType>();
+	}
+	
+	// Defined here since CGameObject is incomplete in component.h
+	template<typename ComponentType>
+	ComponentType* CComponent::GetComponent() const
+	{
+		return mp_gameObject->template GetComponent<ComponentType>();
 	}
 	
 	template<typename ComponentType>
 	std::vector<ComponentType*> CGameObject::GetComponents() const
 	{
-		const TComponentList& componentList = GetComponents(ComponentType::TypeName());
+		CStats::Instance().ComponentLookups().Increment();
+		const char* name = ComponentType::TypeName();
 		
 		std::vector<ComponentType*> castedComponentList;
-		castedComponentList.reserve(componentList.size());
-		
-		for(CComponent* component : componentList)
+		for(unsigned int i = 0; i < m_components.Size(); ++i)
 		{
-			ComponentType* castedComponent = component->DirectCast<ComponentType>();
-			castedComponentList.push_back(castedComponent);
+			if(m_components.Name(i) == name)
+			{
+				ComponentType* castedComponent = m_components[i]->DirectCast<ComponentType>();
+				castedComponentList.push_back(castedComponent);
+			}
 		}
 		
 		return castedComponentList;
@@ -172,6 +260,7 @@ namespace dc
 	ComponentType* CGameObject::AddComponent(Args... args)
 	{
 		ComponentType* component = new ComponentType(std::forward<Args>(args)...);
+		CStats::Instance().Allocated(EStatsSubsystem::Component, sizeof(ComponentType));
 		AddComponent(component);
 		return component;
 	}
@@ -179,10 +268,6 @@ namespace dc
 	template<typename ComponentType>
 	void CGameObject::RemoveComponent()
 	{
-		CComponent* component = RemoveComponent(ComponentType::TypeName());
-		if(component)
-		{
-			delete component;
-		}
+		RemoveComponent(ComponentType::TypeName());
 	}
 }
@@ -0,0 +1,102 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  gameobjectblock.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	/**
+	 * \class CGameObjectBlock
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Contiguous storage for a batch of game objects, used when cloning hierarchies.
+	 * Every game object carries a small header saying which block it lives in, if any,
+	 * so they can still be deleted one by one. The block memory is freed when its last member is deleted.
+	 */
+	class CGameObjectBlock
+	{
+		// ===========================================================
+		// Static fields / methods
+		// ===========================================================
+	public:
+		/**
+		 * Heap allocation with an empty block header, backs operator new of the game objects
+		 */
+		static void*				Allocate(const std::size_t size);
+		
+		/**
+		 * Frees a heap allocation or releases a block slot
+		 */
+		static void					Deallocate(void* pointer);
+		
+		/**
+		 * Allocates room for count game objects in one go
+		 */
+		static CGameObjectBlock*	Create(const unsigned int count);
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int	Count() const { return m_count; }
+		
+		/**
+		 * Uninitialized memory to construct the game object at index
+		 */
+		void*				Slot(const unsigned int index);
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	private:
+		CGameObjectBlock(const unsigned int count):
+			m_count(count),
+			m_references(count)
+		{}
+		
+		~CGameObjectBlock() {}
+		
+	public:
+		CGameObjectBlock(const CGameObjectBlock& copy) = delete;
+		void operator= (const CGameObjectBlock& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	private:
+		char* Slots();
+		void Release();
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		unsigned int				m_count;
+		std::atomic<unsigned int>	m_references;	// Members not deleted yet
+	};
+}
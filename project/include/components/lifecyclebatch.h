@@ -0,0 +1,243 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  lifecyclebatch.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "gameobject.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	/**
+	 * Components of one type inside a batch, from m_begin up to m_end
+	 */
+	struct CTypeRange
+	{
+		const char*		mp_name;
+		unsigned int	m_begin;
+		unsigned int	m_end;
+	};
+	
+	using TTypeRangeList = std::vector<CTypeRange>;
+	using TLifecyclePhase = void (CComponent::*)();
+	
+	/**
+	 * \class CLifecycleBatch
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Game objects going through the same life cycle phase together, with their components
+	 * grouped by type so each phase runs one type after another.
+	 * Types come in the order they are first found and the components of a type keep the
+	 * order of their game objects, so parents still go before their children.
+	 */
+	class CLifecycleBatch
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	private:
+		static const unsigned int LINEAR_TYPES = 16;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const TGOList&			GameObjects()	const { return m_goList; }
+		const TComponentList&	Components()	const { return m_componentList; }
+		const TTypeRangeList&	TypeRanges()	const { return m_typeRangeList; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CLifecycleBatch() {}
+		
+		CLifecycleBatch(const CLifecycleBatch& copy) = delete;
+		void operator= (const CLifecycleBatch& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Clear();
+		
+		/**
+		 * Adds the game object and all its descendants without recursion, in the same order
+		 * a recursive walk would: parents before children and siblings in order
+		 */
+		void AddHierarchy(CGameObject* root);
+		
+		/**
+		 * As AddHierarchy, leaving out the game objects filter rejects. Their descendants are still visited.
+		 */
+		template<typename Filter>
+		void AddHierarchy(CGameObject* root, Filter filter);
+		
+		void Add(const TGOList& gameObjectList);
+		void Add(CGameObject* gameObject);
+		
+		/**
+		 * As Add, leaving out the components filter rejects
+		 */
+		template<typename Filter>
+		void Add(CGameObject* gameObject, Filter filter);
+		
+		/**
+		 * Adds a component on its own, its game object isn't part of the batch
+		 */
+		void Add(CComponent* component);
+		
+		/**
+		 * Groups the components of the game objects by type, once all of them are added
+		 */
+		void GroupByType();
+		
+		/**
+		 * Calls the phase on every component, one type after another
+		 */
+		void Dispatch(TLifecyclePhase phase, const char* phaseName) const;
+		void Dispatch(const CTypeRange& range, TLifecyclePhase phase, const char* phaseName) const;
+		
+	private:
+		const unsigned int TypeIndex(const char* name);
+		const unsigned int LookupType(const char* name);
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		TGOList						m_goList;
+		TGOList						m_pendingList;
+		TComponentList				m_componentList;
+		TTypeRangeList				m_typeRangeList;
+		TComponentList				m_unsortedList;		// Components in game object order
+		std::vector<unsigned int>	m_typeIndexList;	// Type of every component in m_unsortedList
+		std::unordered_map<const char*, unsigned int>	m_typeTable;	// Only used with many types
+	};
+	
+	/**
+	 * \class CLifecycleBatchPool
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Batches reused by a scene. Life cycle phases can add or remove game objects, so
+	 * batches are taken and given back in nested order and keep their memory between uses.
+	 */
+	class CLifecycleBatchPool
+	{
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CLifecycleBatchPool():
+			m_depth(0)
+		{}
+		
+		CLifecycleBatchPool(const CLifecycleBatchPool& copy) = delete;
+		void operator= (const CLifecycleBatchPool& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * An empty batch, valid until the matching Release
+		 */
+		CLifecycleBatch& Acquire();
+		void Release();
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::vector<std::unique_ptr<CLifecycleBatch>>	m_batchList;
+		unsigned int	m_depth;
+	};
+	
+	// ===========================================================
+	// Template/Inline implementation
+	// ===========================================================
+	
+	inline const unsigned int CLifecycleBatch::TypeIndex(const char* name)
+	{
+		if(m_typeTable.empty())
+		{
+			for(unsigned int i = 0; i < m_typeRangeList.size(); ++i)
+			{
+				if(m_typeRangeList[i].mp_name == name)
+				{
+					return i;
+				}
+			}
+		}
+		return LookupType(name);
+	}
+	
+	template<typename Filter>
+	void CLifecycleBatch::Add(CGameObject* gameObject, Filter filter)
+	{
+		m_goList.push_back(gameObject);
+		
+		// Components are counted by type as they come, m_end holds the count until they are grouped
+		const CComponentSlots& components = gameObject->Components();
+		for(unsigned int i = 0; i < components.Size(); ++i)
+		{
+			if(filter(components[i]))
+			{
+				const unsigned int typeIndex = TypeIndex(components.Name(i));
+				++m_typeRangeList[typeIndex].m_end;
+				m_typeIndexList.push_back(typeIndex);
+				m_unsortedList.push_back(components[i]);
+			}
+		}
+	}
+	
+	template<typename Filter>
+	void CLifecycleBatch::AddHierarchy(CGameObject* root, Filter filter)
+	{
+		// Children are pushed last to first so the first one comes out next
+		m_pendingList.clear();
+		m_pendingList.push_back(root);
+		while(!m_pendingList.empty())
+		{
+			CGameObject* gameObject = m_pendingList.back();
+			m_pendingList.pop_back();
+			if(filter(gameObject))
+			{
+				Add(gameObject);
+			}
+			
+			CTransform* transform = gameObject->Transform();
+			for(auto it = transform->End(), begin = transform->Begin(); it != begin;)
+			{
+				--it;
+				m_pendingList.push_back((*it)->GameObject());
+			}
+		}
+	}
+}
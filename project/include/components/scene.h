@@ -20,15 +20,45 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #pragma once
 
+#include <memory>
+#include <ostream>
+#include <unordered_map>
 #include <vector>
 
+#include "destructionqueue.h"
+#include "eventbus.h"
 #include "gameobject.h"
+#include "lifecyclebatch.h"
+#include "scenebase.h"
+#include "taskscheduler.h"
+#include "timerwheel.h"
+#include "worldsnapshot.h"
+
+#include "debug/stats.h"
+#include "spatial/interestmanager.h"
+#include "spatial/spatialgrid.h"
+#include "threading/threadpool.h"
 
 namespace dc
 {
 	// ===========================================================
 	// External Enums / Typedefs for global usage
 	// ===========================================================
+	
+	class CSceneRecorder;
+	class CSharedSceneExporter;
+	
+	/**
+	 * How well the scene component lists follow memory and hierarchy order, see CScene::Locality
+	 */
+	struct CLocality
+	{
+		float	m_nearFraction;			// Consecutive components of a list at most NEAR_BYTES apart
+		float	m_forwardFraction;		// Consecutive components of a list at increasing addresses
+		float	m_parentFirstFraction;	// Transforms updated after their parent, of those with a parent in the scene
+		
+		static const unsigned int NEAR_BYTES = 256;
+	};
 
 	/**
 	 * \class CScene
@@ -42,7 +72,7 @@ namespace dc
 	 * - In PrepareUpdate is added to the scene and calls Start for all components.
 	 *	That way the components are initalized before the first call to Update.
 	 */
-	class CScene
+	class CScene : public CSceneBase
 	{
 		// ===========================================================
 		// Static fields / methods
@@ -55,6 +85,22 @@ namespace dc
 		// ===========================================================
 		// Inner and Anonymous Classes
 		// ===========================================================
+	private:
+		struct CSparseComponents
+		{
+			CSparseIndex	m_index;			// Game object id to position in the list
+			TComponentList*	mp_componentList;
+		};
+		
+		/**
+		 * Asynchronous awakes of the hierarchy given to one Add
+		 */
+		struct CAwakeGroup
+		{
+			CJobCounter		m_counter;
+			unsigned int	m_gameObjectCount;		// Still waiting for the group
+		};
+		
 		
 		// ===========================================================
 		// Getter & Setter
@@ -64,16 +110,183 @@ namespace dc
 		const unsigned int	RootCount()		const { return m_goList.size(); }
 		const TGOList&		GameObjects()	const { return m_goList; }
 		
+		/**
+		 * Changes every time GameObjects does
+		 */
+		const uint64_t		GameObjectsVersion() const { return m_goListVersion; }
+		
+		/**
+		 * Game objects added since the last update, they join GameObjects in the next one
+		 * unless they are still awaking
+		 */
+		const TGOList&		PendingGameObjects() const { return m_newGOList; }
+		
+		/**
+		 * Pending game objects with asynchronous awakes that have not finished yet
+		 */
+		const unsigned int	AwakingCount() const { return m_awakingMap.size(); }
+		
 		const bool			Exists(const CGameObject* gameObject);
 		
 		template<typename CT>
 		std::vector<CT*>	GetSceneComponents();
 		
+		/**
+		 * Component of type CT of the game object, NULL until it has started in this scene.
+		 * Sparse types are found by game object id, the rest through the game object.
+		 */
+		template<typename CT>
+		CT*					FindComponent(const CGameObject* gameObject) const;
+		
+		const uint64_t		Frame()			const { return m_frame; }
+		
+		/**
+		 * Change tick, starts at 1 and advances at the end of every Update.
+		 * Components changed during a tick are stamped with it.
+		 */
+		const uint64_t		Tick()			const { return m_tick; }
+		
+		/**
+		 * Calls function for every component of type CT changed at or after sinceTick.
+		 * Components entering the scene count as changed.
+		 */
+		template<typename CT, typename Function>
+		void				ForEachChanged(const uint64_t sinceTick, Function function);
+		
+		template<typename CT>
+		std::vector<CT*>	GetChangedComponents(const uint64_t sinceTick);
+		
+		/**
+		 * Copies the current counters. The lists are read without locking,
+		 * so call it from the updating thread or between updates.
+		 */
+		CStatsSnapshot		Stats() const;
+		
+		/**
+		 * Writes the stats to the output every frameInterval updates. A NULL output disables it.
+		 */
+		void				StatsReport(std::ostream* output, const unsigned int frameInterval, const EStatsFormat format = EStatsFormat::Text);
+		
+		/**
+		 * When enabled, every Update ends publishing a snapshot of all the world matrices
+		 */
+		void				PublishWorldSnapshots(const bool enabled) { m_publishSnapshots = enabled; }
+		
+		/**
+		 * Latest published snapshot, NULL until the first one. Lock free with respect to Update,
+		 * can be called from any thread and kept for as long as needed.
+		 */
+		TWorldSnapshotPtr	WorldSnapshot() const { return std::atomic_load(&mp_worldSnapshot); }
+		
+		/**
+		 * Spatial index of the world positions, NULL unless enabled.
+		 * It's refreshed at the end of every Update, only for the transforms that changed.
+		 */
+		const CSpatialGrid*	SpatialIndex() const { return mp_spatialIndex.get(); }
+		
+		void				EnableSpatialIndex(const float cellSize);
+		void				DisableSpatialIndex() { mp_spatialIndex.reset(); }
+		
+		/**
+		 * Interest management, NULL unless enabled. Once enabled only game objects
+		 * near an observer get their components updated.
+		 */
+		CInterestManager*	InterestManager() const { return mp_interestManager.get(); }
+		
+		void				EnableInterestManagement(const CInterestSettings& settings);
+		void				DisableInterestManagement();
+		
+		/**
+		 * Game objects destroyed in previous updates and still waiting to be deleted
+		 */
+		const unsigned int	PendingDestructions() const { return m_destructionQueue.Pending(); }
+		
+		const CDestructionBudget&	DestructionBudget() const { return m_destructionQueue.Budget(); }
+		void				DestructionBudget(const CDestructionBudget& budget) { m_destructionQueue.Budget(budget); }
+		
+		/**
+		 * Game objects visited per Update by the compaction, 0 turns it off. Compaction walks the
+		 * hierarchies depth first and moves their components to the same order in the scene lists,
+		 * so updating a type follows the hierarchies, parents before children. A new pass starts
+		 * whenever game objects came or went, or any parent changed, during the last one.
+		 * Dense types keep their memory order.
+		 */
+		const unsigned int	CompactionBudget() const { return m_compactionBudget; }
+		void				CompactionBudget(const unsigned int gameObjectsPerUpdate) { m_compactionBudget = gameObjectsPerUpdate; }
+		
+		const unsigned int	CompactionPasses() const { return m_compactionPasses; }
+		
+		/**
+		 * Walks all the component lists, meant for diagnostics
+		 */
+		CLocality			Locality() const;
+		
+		/**
+		 * Tasks run once per Update, after the components. The tasks of a game object are
+		 * cancelled when it leaves the scene.
+		 */
+		CTaskScheduler&		Scheduler() { return m_scheduler; }
+		
+		/**
+		 * Timers advance once per Update, right before the tasks. The timers of a game object
+		 * are dropped as soon as it is removed.
+		 */
+		CTimerWheel&		Timers() { return m_timers; }
+		
+		/**
+		 * Events published during an Update are delivered to the AfterUpdate subscribers once the
+		 * components are updated, and to the EndOfFrame ones after the removed game objects finish.
+		 */
+		CEventBus&			Events() { return m_events; }
+		
+		/**
+		 * Starts recording the scene from its current state, a NULL recorder stops it.
+		 * The recorder must outlive the recording.
+		 */
+		void				Record(CSceneRecorder* recorder);
+		
+		/**
+		 * Exports the scene at the end of every Update, a NULL exporter stops it.
+		 * The exporter must outlive the export.
+		 */
+		void				Export(CSharedSceneExporter* exporter) { mp_exporter = exporter; }
+		CSharedSceneExporter*	Exporter() const { return mp_exporter; }
+		
+		/**
+		 * Runs the awakes of components with CComponent::AsyncAwake, which run in place without one.
+		 * A hierarchy only joins the scene, and gets Start, in the first update after all its
+		 * awakes are done. The pool must outlive the scene, and can't change while AwakingCount isn't 0.
+		 */
+		CThreadPool*		ThreadPool() const { return mp_threadPool; }
+		void				ThreadPool(CThreadPool* threadPool) { mp_threadPool = threadPool; }
+		
 		// ===========================================================
 		// Constructors
 		// ===========================================================
 	public:
-		CScene(const char* name) : mp_name(name) {}
+		CScene(const char* name):
+			mp_name(name),
+			m_frame(0),
+			m_tick(1),
+			m_transformUpdatesLastFrame(0),
+			mp_statsOutput(0),
+			m_statsInterval(0),
+			m_statsFormat(EStatsFormat::Text),
+			m_publishSnapshots(false),
+			m_goListVersion(0),
+			m_spatialTick(0),
+			m_interestTick(0),
+			mp_exporter(0),
+			m_compactionBudget(0),
+			m_compactionPasses(0),
+			m_compactionVersion(~0ull),
+			m_compactionHierarchyVersion(0),
+			m_compacting(false),
+			m_compactionCursor(0),
+			mp_compactionRoot(0),
+			mp_compactionNext(0),
+			mp_threadPool(0)
+		{}
 		~CScene();
 		
 		CScene(const CScene& copy) = delete;
@@ -82,6 +295,9 @@ namespace dc
 		// ===========================================================
 		// Methods for/from SuperClass/Interfaces
 		// ===========================================================
+	public:
+		void AddComponent(CComponent* component) override;
+		void RemoveComponent(CComponent* component) override;
 		
 		// ===========================================================
 		// Methods
@@ -89,18 +305,70 @@ namespace dc
 	public:
 		void Update();
 		
+		/**
+		 * Adds the game object and its children. Their components get Awake now and Start
+		 * in the next update, both phases one component type after another, in the order
+		 * types are first found. Inside a type parents always go before their children.
+		 * Asynchronous awakes hold the whole hierarchy back until they are done.
+		 */
 		void Add(CGameObject* gameObject);
+		
+		/**
+		 * Removes the game object and its children. Sleep and Finish are grouped by type
+		 * the same way Awake and Start are.
+		 */
 		void Remove(CGameObject* gameObject);
 		
+		/**
+		 * Removes the game object and its children from the scene and deletes them afterwards.
+		 * Deletion is spread over the next updates following the destruction budget,
+		 * so don't use the game object after calling it.
+		 */
+		void Destroy(CGameObject* gameObject);
+		
 	private:
 		void PrepareUpdate();
 		void FinishUpdate();
+		
+		void StartNewComponents();
+		void FinishOldComponents();
 
-		void AddToScene(CGameObject* gameObject);
+		void RemoveHierarchy(CGameObject* gameObject);
 		void RemoveFromScene(CGameObject* gameObject);
 		
-		void AddComponents(const char* name, const TComponentList& componentList);
-		void RemoveComponents(const char* name, const TComponentList& componentList);
+		void AwakeComponents(const CLifecycleBatch& batch);
+		
+		/**
+		 * Takes the pending game objects whose awakes are done into the batch
+		 */
+		void TakeAwakeGameObjects(CLifecycleBatch& batch);
+		
+		/**
+		 * Blocks until the awakes of the game object are done and stops waiting for them
+		 */
+		void FinishAwake(const CGameObject* gameObject);
+		void ReleaseAwaking(std::unordered_map<const CGameObject*, CAwakeGroup*>::iterator awakingEntryIt);
+		
+		void AddComponents(const CLifecycleBatch& batch, const CTypeRange& range);
+		void RemoveComponents(const CLifecycleBatch& batch, const CTypeRange& range);
+		void RemoveSparseComponents(const CLifecycleBatch& batch, const CTypeRange& range, TComponentList& componentList);
+		
+		/**
+		 * Components of the type below this position are already in hierarchy order
+		 */
+		unsigned int* CompactedCount(const char* name);
+		
+		void Compact();
+		void CompactGameObject(CGameObject* gameObject);
+		void SwapComponents(const char* name, TComponentList& componentList, const unsigned int first, const unsigned int second);
+		
+		CChangeTracker& ChangeTracker(const char* name);
+		
+		void RecordFrameStats(const uint64_t frameStartNs, const int64_t transformUpdatesAtStart);
+		
+		void PublishWorldSnapshot();
+		void SyncSpatialIndex();
+		std::shared_ptr<CWorldSnapshot> RecycleWorldSnapshot();
 		
 		// ===========================================================
 		// Fields
@@ -111,8 +379,55 @@ namespace dc
 		TGOList				m_goList;
 		TGOList				m_newGOList;
 		TGOList				m_oldGOList;
+		TGOList				m_destroyGOList;
+		
+		TComponentList		m_newComponentList;		// Added to game objects already in the scene
+		TComponentList		m_oldComponentList;		// Taken out of their game objects, owned by the scene
+		
+		CDestructionQueue	m_destructionQueue;
+		CLifecycleBatchPool	m_lifecycleBatchPool;
+		CTaskScheduler		m_scheduler;
+		CTimerWheel			m_timers;
+		CEventBus			m_events;
 		
 		TComponentListTable	m_componentsMap;
+		std::map<const char*, CSparseComponents>	m_sparseComponentsMap;
+		std::map<const char*, CChangeTracker>	m_changeTrackerMap;
+		
+		uint64_t			m_frame;
+		uint64_t			m_tick;
+		CTimeHistogram		m_frameTimes;
+		int64_t				m_transformUpdatesLastFrame;
+		
+		std::ostream*		mp_statsOutput;
+		unsigned int		m_statsInterval;
+		EStatsFormat		m_statsFormat;
+		
+		bool				m_publishSnapshots;
+		uint64_t			m_goListVersion;		// Changes every time m_goList does
+		TWorldSnapshotPtr	mp_worldSnapshot;
+		std::vector<std::shared_ptr<CWorldSnapshot>>	m_snapshotPool;
+		
+		std::unique_ptr<CSpatialGrid>	mp_spatialIndex;
+		uint64_t			m_spatialTick;			// Changes from this tick on are not indexed yet
+		
+		std::unique_ptr<CInterestManager>	mp_interestManager;
+		uint64_t			m_interestTick;
+		
+		CSharedSceneExporter*	mp_exporter;
+		
+		unsigned int		m_compactionBudget;
+		unsigned int		m_compactionPasses;
+		uint64_t			m_compactionVersion;	// Game object list version when the last pass started
+		unsigned int		m_compactionHierarchyVersion;
+		bool				m_compacting;
+		unsigned int		m_compactionCursor;		// Where to look for the next root in m_goList
+		const CTransform*	mp_compactionRoot;		// Only compared, the root may be gone by now
+		CGameObject*		mp_compactionNext;
+		std::map<const char*, unsigned int>	m_compactedCountMap;
+		
+		CThreadPool*		mp_threadPool;
+		std::unordered_map<const CGameObject*, CAwakeGroup*>	m_awakingMap;
 	};
 	
 	// ===========================================================
@@ -139,4 +454,68 @@ namespace dc
 		
 		return castedComponentList;
 	}
+	
+	template<typename CT>
+	CT* CScene::FindComponent(const CGameObject* gameObject) const
+	{
+		assert(gameObject && "[CScene::FindComponent] game object can't be NULL");
+		
+		if(TComponentStorage<CT>::value == EComponentStorage::Sparse)
+		{
+			const auto sparseEntryIt = m_sparseComponentsMap.find(CT::TypeName());
+			if(sparseEntryIt == m_sparseComponentsMap.end())
+			{
+				return 0;
+			}
+			
+			const CSparseComponents& sparseComponents = sparseEntryIt->second;
+			const unsigned int index = sparseComponents.m_index.Get(gameObject->Id());
+			return index == CSparseIndex::NONE ? 0 : (*sparseComponents.mp_componentList)[index]->template DirectCast<CT>();
+		}
+		
+		CComponent* component = gameObject->Components().Find(CT::TypeName());
+		return component && component->mp_changeTracker && gameObject->Scene() == this ? component->template DirectCast<CT>() : 0;
+	}
+	
+	template<typename CT, typename Function>
+	void CScene::ForEachChanged(const uint64_t sinceTick, Function function)
+	{
+		const auto& componentsEntryIt = m_componentsMap.find(CT::TypeName());
+		if(componentsEntryIt == m_componentsMap.end())
+		{
+			return;
+		}
+		
+		const TComponentList& componentList = componentsEntryIt->second;
+		const CChangeTracker& tracker = ChangeTracker(CT::TypeName());
+		
+		for(unsigned int chunk = 0; chunk < tracker.ChunkCount(); ++chunk)
+		{
+			if(tracker.ChunkTick(chunk) < sinceTick)
+			{
+				continue;
+			}
+			
+			const unsigned int end = std::min<unsigned int>(componentList.size(), (chunk + 1) << CChangeTracker::CHUNK_SHIFT);
+			for(unsigned int i = chunk << CChangeTracker::CHUNK_SHIFT; i < end; ++i)
+			{
+				CComponent* component = componentList[i];
+				if(component->ChangedTick() >= sinceTick)
+				{
+					function(component->DirectCast<CT>());
+				}
+			}
+		}
+	}
+	
+	template<typename CT>
+	std::vector<CT*> CScene::GetChangedComponents(const uint64_t sinceTick)
+	{
+		std::vector<CT*> changedComponentList;
+		ForEachChanged<CT>(sinceTick, [&changedComponentList](CT* component)
+		{
+			changedComponentList.push_back(component);
+		});
+		return changedComponentList;
+	}
 }
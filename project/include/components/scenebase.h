@@ -0,0 +1,93 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  scenebase.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	class CComponent;
+	class CSceneRecorder;
+	
+	/**
+	 * \class CSceneBase
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * What game objects and transforms see of the scene they are in, shared by CScene and TScene
+	 */
+	class CSceneBase
+	{
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		/**
+		 * NULL unless the scene is being recorded
+		 */
+		CSceneRecorder*		Recorder() const { return mp_recorder; }
+		
+		/**
+		 * Changes when a transform in the scene changes parent, or its game objects come or go
+		 */
+		const unsigned int	HierarchyVersion() const { return m_hierarchyVersion; }
+		void				HierarchyChanged() { ++m_hierarchyVersion; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CSceneBase():
+			mp_recorder(0),
+			m_hierarchyVersion(1)
+		{}
+		
+		virtual ~CSceneBase() {}
+		
+		CSceneBase(const CSceneBase& copy) = delete;
+		void operator= (const CSceneBase& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Called by game objects in the scene for a component added to them. It gets Awake now
+		 * and Start in the next update, unless its game object is leaving the scene.
+		 */
+		virtual void AddComponent(CComponent* component) = 0;
+		
+		/**
+		 * Called by game objects in the scene for a component taken out of them. It gets Sleep now
+		 * and Finish at the end of the update, when the scene deletes it.
+		 */
+		virtual void RemoveComponent(CComponent* component) = 0;
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	protected:
+		CSceneRecorder*		mp_recorder;
+		unsigned int		m_hierarchyVersion;
+	};
+}
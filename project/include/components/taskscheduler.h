@@ -0,0 +1,268 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  taskscheduler.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "gameobject.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	class CTaskEvent;
+	class CTaskScheduler;
+	
+	enum class ETaskWait
+	{
+		Frames,
+		Seconds,
+		Until,
+		Event,
+		Stop
+	};
+	
+	/**
+	 * What a task step waits for before the task goes on.
+	 * By default the task goes on with the next step, Repeat runs the same step again.
+	 */
+	class CTaskWait
+	{
+		friend class CTaskScheduler;
+		
+		// ===========================================================
+		// Static fields / methods
+		// ===========================================================
+	public:
+		/**
+		 * Frames(1) goes on in the next update
+		 */
+		static CTaskWait Frames(const unsigned int frames);
+		static CTaskWait Seconds(const float seconds);
+		
+		/**
+		 * The condition is checked once per update until it's true
+		 */
+		static CTaskWait Until(const std::function<bool()>& condition);
+		
+		/**
+		 * Goes on in the first update after the event is signaled
+		 */
+		static CTaskWait Event(CTaskEvent& event);
+		
+		/**
+		 * Ends the task without running the rest of the steps
+		 */
+		static CTaskWait Stop();
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		CTaskWait& Repeat() { m_repeat = true; return *this; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	private:
+		CTaskWait(const ETaskWait type):
+			m_type(type),
+			m_repeat(false),
+			m_frames(0),
+			m_seconds(0.0f),
+			mp_event(0)
+		{}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		ETaskWait				m_type;
+		bool					m_repeat;
+		unsigned int			m_frames;
+		float					m_seconds;
+		std::function<bool()>	m_condition;
+		CTaskEvent*				mp_event;
+	};
+	
+	using TTaskStep = std::function<CTaskWait()>;
+	using TTaskStepList = std::vector<TTaskStep>;
+	
+	/**
+	 * \class CTaskEvent
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Something tasks can wait for. It must outlive the scheduler updates of the tasks waiting on it.
+	 */
+	class CTaskEvent
+	{
+		friend class CTaskScheduler;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int	WaitingCount() const { return m_waiterList.size(); }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CTaskEvent():
+			mp_scheduler(0)
+		{}
+		
+		CTaskEvent(const CTaskEvent& copy) = delete;
+		void operator= (const CTaskEvent& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Wakes up every task waiting right now
+		 */
+		void Signal();
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		CTaskScheduler*		mp_scheduler;
+		std::vector<uint64_t>	m_waiterList;
+	};
+	
+	/**
+	 * \class CTaskScheduler
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Runs long lived behaviours as a list of steps, each one saying what to wait for before the next.
+	 * Waiting tasks cost nothing per update except the ones waiting on a condition,
+	 * the rest are only touched when they are due.
+	 * Tasks belong to a game object and are cancelled when it leaves the scene.
+	 */
+	class CTaskScheduler
+	{
+		friend class CTaskEvent;
+		
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	private:
+		struct CTask
+		{
+			TTaskStepList			m_stepList;
+			unsigned int			m_step;
+			CGameObject*			mp_owner;
+			unsigned int			m_generation;
+			std::function<bool()>	m_condition;
+		};
+		
+		struct CDueTask
+		{
+			uint64_t	m_due;
+			uint64_t	m_handle;
+			
+			bool operator> (const CDueTask& other) const { return m_due > other.m_due; }
+		};
+		
+		using TDueQueue = std::priority_queue<CDueTask, std::vector<CDueTask>, std::greater<CDueTask>>;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int	TaskCount() const	{ return m_taskList.size() - m_freeList.size(); }
+		const bool			Running(const uint64_t handle) const;
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CTaskScheduler():
+			m_frame(0),
+			m_nowNs(0)
+		{}
+		
+		CTaskScheduler(const CTaskScheduler& copy) = delete;
+		void operator= (const CTaskScheduler& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Starts a task owned by the game object, which can be NULL for tasks owned by nobody.
+		 * The first step runs in the next update, or in the current one if it hasn't run the tasks yet.
+		 * Returns a handle to cancel it.
+		 */
+		uint64_t Start(CGameObject* owner, const TTaskStepList& stepList);
+		
+		void Cancel(const uint64_t handle);
+		
+		/**
+		 * Cancels all the tasks of the game object
+		 */
+		void Cancel(const CGameObject* owner);
+		
+		/**
+		 * Runs every task that is due at this frame and time
+		 */
+		void Update(const uint64_t frame, const uint64_t nowNs);
+		
+	private:
+		void Wake(const uint64_t handle) { m_readyList.push_back(handle); }
+		
+		void Run(const uint64_t handle);
+		void Park(const uint64_t handle, const CTaskWait& wait);
+		void Free(const unsigned int index);
+		
+		const bool Valid(const uint64_t handle) const;
+		
+		static uint64_t		Handle(const unsigned int index, const unsigned int generation) { return (uint64_t(generation) << 32) | index; }
+		static unsigned int	Index(const uint64_t handle) { return (unsigned int)handle; }
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::vector<CTask>			m_taskList;
+		std::vector<unsigned int>	m_freeList;
+		std::unordered_map<const CGameObject*, std::vector<uint64_t>>	m_ownerTable;
+		
+		TDueQueue					m_frameQueue;
+		TDueQueue					m_timeQueue;
+		std::vector<uint64_t>		m_conditionList;
+		std::vector<uint64_t>		m_readyList;		// Due in the next update
+		std::vector<uint64_t>		m_runList;
+		
+		uint64_t					m_frame;
+		uint64_t					m_nowNs;
+	};
+}
@@ -0,0 +1,156 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  timerwheel.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "gameobject.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	using TTimerCallback = std::function<void()>;
+	
+	/**
+	 * \class CTimerWheel
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Delayed and repeating callbacks in a hierarchical timing wheel: four levels of 256 slots,
+	 * each level counting 256 times slower than the one below. Scheduling and cancelling are O(1),
+	 * advancing only visits the slots of the elapsed ticks and moves far timers down as they get near.
+	 * Timers belong to a game object so all of them can be dropped together.
+	 */
+	class CTimerWheel
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const unsigned int LEVEL_BITS = 8;
+		static const unsigned int LEVEL_SLOTS = 1 << LEVEL_BITS;
+		static const unsigned int LEVEL_COUNT = 4;
+		
+	private:
+		static const int NONE = -1;
+		
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	private:
+		struct CTimer
+		{
+			TTimerCallback	m_callback;
+			CGameObject*	mp_owner;
+			uint64_t		m_due;			// In ticks
+			uint64_t		m_period;		// In ticks, 0 for one shot timers
+			unsigned int	m_generation;
+			int				m_slot;			// Wheel slot, NONE while firing or free
+			int				m_prev;
+			int				m_next;
+			int				m_ownerPrev;
+			int				m_ownerNext;
+		};
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int	Count() const			{ return m_timerList.size() - m_freeList.size(); }
+		const uint64_t		ResolutionNs() const	{ return m_resolutionNs; }
+		const bool			Pending(const uint64_t handle) const { return Valid(handle); }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		/**
+		 * Timers fire with the given precision, one millisecond by default
+		 */
+		CTimerWheel(const uint64_t resolutionNs = 1000000);
+		
+		CTimerWheel(const CTimerWheel& copy) = delete;
+		void operator= (const CTimerWheel& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Calls back once after the delay, counted from the last Advance.
+		 * The owner can be NULL for timers that belong to nobody.
+		 */
+		uint64_t After(CGameObject* owner, const float seconds, const TTimerCallback& callback);
+		
+		/**
+		 * Calls back every period until cancelled, the first time after one period
+		 */
+		uint64_t Every(CGameObject* owner, const float seconds, const TTimerCallback& callback);
+		
+		void Cancel(const uint64_t handle);
+		
+		/**
+		 * Cancels all the timers of the game object
+		 */
+		void Cancel(const CGameObject* owner);
+		
+		/**
+		 * Fires every timer due up to the given time. The first call sets the time origin.
+		 */
+		void Advance(const uint64_t nowNs);
+		
+	private:
+		uint64_t Schedule(CGameObject* owner, const float seconds, const bool repeat, const TTimerCallback& callback);
+		
+		void Insert(const int index);
+		void Unlink(const int index);
+		void Free(const int index);
+		
+		void Cascade(const unsigned int level);
+		void Fire(const unsigned int slot);
+		
+		const bool Valid(const uint64_t handle) const;
+		
+		static uint64_t		Handle(const int index, const unsigned int generation) { return (uint64_t(generation) << 32) | (unsigned int)index; }
+		static int			Index(const uint64_t handle) { return (int)(unsigned int)handle; }
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		uint64_t					m_resolutionNs;
+		uint64_t					m_originNs;
+		bool						m_started;
+		uint64_t					m_tick;				// Last tick processed
+		
+		std::vector<CTimer>			m_timerList;
+		std::vector<int>			m_freeList;
+		std::vector<int>			m_slotList;			// First timer of every slot, level after level
+		std::vector<uint64_t>		m_fireList;
+		std::unordered_map<const CGameObject*, int>	m_ownerTable;	// First timer of every owner
+	};
+}
@@ -20,21 +20,38 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include "math/matrix.h"
 
 #include "component.h"
 
+#include "types/vector3array.h"
+
 namespace dc
 {
 	// ===========================================================
 	// External Enums / Typedefs for global usage
 	// ===========================================================
 	
+	class CSceneBase;
 	class CTransform;
 	
 	using TTransformList = std::vector<CTransform*>;
 	using TTransformIterator = TTransformList::iterator;
 	
+	/**
+	 * Parent change for CTransform::Reparent, a NULL parent detaches the child
+	 */
+	struct CReparent
+	{
+		CTransform*	mp_child;
+		CTransform*	mp_parent;
+	};
+	
+	using TReparentList = std::vector<CReparent>;
+	
 	/**
 	 * \class
 	 * \brief
@@ -49,13 +66,52 @@ namespace dc
 		// ===========================================================
 		RTTI_DECLARATIONS(CTransform, CComponent)
 		
+		friend class CGameObject;
+		
 		// ===========================================================
 		// Static fields / methods
 		// ===========================================================
+	public:
+		/**
+		 * Applies all the parent changes first and then updates each moved hierarchy once.
+		 * The children keep their local transforms.
+		 */
+		static void Reparent(const TReparentList& reparentList);
+		
+	private:
+		/**
+		 * Tells the scenes of both transforms, roots cached outside a single scene only check the process wide version
+		 */
+		static void HierarchyChanged(const CTransform* child, const CTransform* parent);
+		
+		static std::atomic<unsigned int> s_hierarchyVersion;	// Changes with every parent change of any transform
+		static thread_local unsigned int s_reparentBatch;		// Scenes may reparent on different threads at once
 		
 		// ===========================================================
 		// Inner and Anonymous Classes
 		// ===========================================================
+	private:
+		/**
+		 * Local position, rotation and scale given through their setters, always composed into the
+		 * local matrix. Transforms without it read them from the local matrix.
+		 */
+		struct CLocalTRS
+		{
+			math::Vector3f		m_position;
+			math::Vector3f		m_scale;
+			math::Quaternionf	m_rotation;
+		};
+		
+		/**
+		 * World matrix and its inverse as 3x3 basis plus translation, columns first.
+		 * Built on the first batched transform after the world matrix changes.
+		 */
+		struct CAffineCache
+		{
+			float	m_world[12];
+			float	m_inverse[12];
+			bool	m_valid;
+		};
 		
 		// ===========================================================
 		// Getter & Setter
@@ -73,7 +129,16 @@ namespace dc
 		TTransformIterator		Begin()	{ return m_children.begin(); }
 		TTransformIterator		End() { return m_children.end(); }
 		
-		CTransform*				Root() const { return mp_root; }
+		/**
+		 * Topmost transform in the hierarchy, NULL for the root itself.
+		 * Cached until a parent changes in its scene, or anywhere when the hierarchy is not all in one scene.
+		 */
+		CTransform*				Root() const;
+		
+		/**
+		 * Next transform after this one in a depth first walk of the hierarchy under root, NULL at the end
+		 */
+		CTransform*				NextInHierarchy(const CTransform* root) const;
 		
 		const bool				HasParent() const { return mp_parent != 0; }
 		CTransform*				Parent() const { return mp_parent; }
@@ -81,22 +146,35 @@ namespace dc
 		
 		math::Vector3f			Position() { return m_globalMatrix.Position(); }
 
-		math::Vector3f			LocalPosition() const { return m_localMatrix.Position(); }
-		math::Quaternionf		LocalRotation() const { return m_localMatrix.Rotation(); }
-		math::Vector3f			LocalScale()	const { return m_localMatrix.Scale(); }
+		math::Vector3f			LocalPosition() const { return mp_localTRS ? mp_localTRS->m_position : m_localMatrix.Position(); }
+		math::Quaternionf		LocalRotation() const { return mp_localTRS ? mp_localTRS->m_rotation : m_localMatrix.Rotation(); }
+		math::Vector3f			LocalScale()	const { return mp_localTRS ? mp_localTRS->m_scale : m_localMatrix.Scale(); }
 
 		void					LocalPosition(const math::Vector3f& position);
 		void					LocalRotation(const math::Quaternionf& rotation);
 		void					LocalScale(const math::Vector3f& scale);
 		
+		/**
+		 * Frozen transforms keep their world matrix as it was when frozen and are skipped
+		 * by every recalculation, even if they or their ancestors change. Moving one to
+		 * another parent bakes it again, along with its hierarchy.
+		 */
+		const bool				Frozen() const { return m_frozen; }
+		
 	private:
-		void					Root(CTransform* root);
+		CLocalTRS&				LocalTRS();
 		
 		// ===========================================================
 		// Constructors
 		// ===========================================================
 	public:
-		CTransform()
+		CTransform():
+			mp_rootCache(0),
+			mp_rootScene(0),
+			m_rootVersion(0),
+			m_reparentBatch(0),
+			m_frozen(false),
+			m_rebake(false)
 		{
 			Reset();
 		}
@@ -117,32 +195,91 @@ namespace dc
 		void Reset();
 		
 		void Add(CTransform* child);
+		
+		/**
+		 * Unlinks the child without recalculating it. The last child takes its place.
+		 */
 		void Remove(CTransform* child);
 		
+		/**
+		 * Unlinks the transform from its parent, making it the root of its own hierarchy
+		 */
+		void Detach();
+		
+		/**
+		 * Bakes the world matrices of the whole hierarchy below and freezes it, see Frozen.
+		 * Their local TRS are dropped, the getters read them back from the local matrix.
+		 */
+		void Freeze();
+		
+		/**
+		 * Unfreezes the hierarchy below and brings it up to date with its ancestors
+		 */
+		void Unfreeze();
+		
 		CTransform* FindChild(const char* name);
 		
 		// Transforms position from local space to world space.
 		math::Vector3f TransformPosition(const math::Vector3f& point);
 		
+		/**
+		 * Batched transforms between local and world space, directions ignore the translation.
+		 * The result is resized to the input, both can be the same array.
+		 */
+		void TransformPositions(const CVector3Array& points, CVector3Array& result) const;
+		void TransformDirections(const CVector3Array& directions, CVector3Array& result) const;
+		
+		void InverseTransformPositions(const CVector3Array& points, CVector3Array& result) const;
+		void InverseTransformDirections(const CVector3Array& directions, CVector3Array& result) const;
+		
 	private:
+		const CAffineCache& AffineCache() const;
+		
+		/**
+		 * Moves the transform into the children of parent, or out of any with NULL. Nothing is recalculated.
+		 */
+		void Link(CTransform* parent);
+		
+		/**
+		 * Remove without recording it, for the changes recorded as something else
+		 */
+		void Unlink(CTransform* child);
+		
+		const bool IsAncestorOf(const CTransform* transform) const;
+		
+		/**
+		 * Copies the local state of source and appends itself to parent, whose world matrix must be up to date
+		 */
+		void CloneFrom(const CTransform& source, CTransform* parent, const unsigned int childCount);
+		
+		/**
+		 * Composes the local TRS into the local matrix, translation * rotation * scale
+		 */
 		void CalculateLocalTransform();
 		void CalculateWorldTransform();
 		
 		void CalculateTransforms();
+		void CalculateHierarchyTransforms();
 		
 		// ===========================================================
 		// Fields
 		// ===========================================================
 	private:
-		CTransform*		mp_root;		// Topmost transform in the hierarchy
 		CTransform*		mp_parent;		// Transform parent
+		unsigned int	m_childIndex;	// Position in the children of the parent
+		
+		mutable CTransform*		mp_rootCache;
+		mutable const CSceneBase*	mp_rootScene;	// Scene of the whole way up to the cached root, NULL when there is none
+		mutable unsigned int	m_rootVersion;	// Hierarchy version the cached root belongs to
+		unsigned int			m_reparentBatch;	// Last Reparent call that moved it
+		bool					m_frozen;
+		bool					m_rebake;		// Frozen and moved to another parent since it was baked
 
 		math::Matrix4x4f		m_localMatrix;
 		math::Matrix4x4f		m_globalMatrix;
 		
-		math::Vector3f		m_position;		// Local position
-		math::Vector3f		m_scale;		// Local scale
-		math::Quaternionf	m_rotation;		// Local rotaion
+		std::unique_ptr<CLocalTRS>	mp_localTRS;	// NULL unless the local TRS setters have been used
+		mutable std::unique_ptr<CAffineCache>	mp_affineCache;	// NULL until a batched transform is used
 		TTransformList	m_children;
 	};
 	// ===========================================================
@@ -0,0 +1,544 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  typedscene.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "destructionqueue.h"
+#include "gameobject.h"
+#include "lifecyclebatch.h"
+#include "scenebase.h"
+
+#include "debug/profiler.h"
+#include "help/deletehelp.h"
+#include "help/vectorhelp.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	template<typename T, typename... List>
+	struct TContains : std::false_type {};
+	
+	template<typename T, typename First, typename... Rest>
+	struct TContains<T, First, Rest...> : std::integral_constant<bool, std::is_same<T, First>::value || TContains<T, Rest...>::value> {};
+	
+	/**
+	 * Position of T in List, fails to compile when it isn't there
+	 */
+	template<typename T, typename... List>
+	struct TIndexOf;
+	
+	template<typename T, typename... Rest>
+	struct TIndexOf<T, T, Rest...> : std::integral_constant<unsigned int, 0> {};
+	
+	template<typename T, typename First, typename... Rest>
+	struct TIndexOf<T, First, Rest...> : std::integral_constant<unsigned int, 1 + TIndexOf<T, Rest...>::value> {};
+	
+	/**
+	 * \class TScene
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Scene for a set of component types known at compile time. Each type is kept in its own
+	 * typed list and updated without virtual calls, and asking for a type outside the set
+	 * doesn't compile.
+	 * Game objects go through the same life cycle as in CScene, and so do the components added
+	 * to or removed from them while they are in the scene. Their components of other types get
+	 * Awake, Start, Sleep and Finish but are never updated.
+	 * Change tracking, snapshots, spatial index and interest management are only in CScene.
+	 */
+	template<typename... Components>
+	class TScene : public CSceneBase
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	private:
+		using TComponentLists = std::tuple<std::vector<Components*>...>;
+		using TExpand = int[];
+		using TOldComponentList = std::vector<std::pair<CComponent*, bool>>;	// With whether it started
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const char*			Name()			const { return mp_name; }
+		const TGOList&		GameObjects()	const { return m_goList; }
+		
+		const bool			Exists(CGameObject* gameObject)
+		{
+			return dc::Exists(m_goList, gameObject) || dc::Exists(m_newGOList, gameObject);
+		}
+		
+		/**
+		 * Components of type CT in the scene, CT must be one of the scene types
+		 */
+		template<typename CT>
+		const std::vector<CT*>&	GetSceneComponents() const
+		{
+			static_assert(TContains<CT, Components...>::value, "[TScene::GetSceneComponents] The component type isn't one of the scene types");
+			return std::get<TIndexOf<CT, Components...>::value>(m_componentLists);
+		}
+		
+		/**
+		 * First component of type CT of the game object, NULL if it has none. CT must be one of
+		 * the scene types, it is checked and cast at compile time, only the type names of the
+		 * game object are compared at run time.
+		 */
+		template<typename CT>
+		static CT*			GetComponent(const CGameObject* gameObject)
+		{
+			static_assert(TContains<CT, Components...>::value, "[TScene::GetComponent] The component type isn't one of the scene types");
+			return static_cast<CT*>(gameObject->Components().Find(CT::TypeName()));
+		}
+		
+		const unsigned int	PendingDestructions() const { return m_destructionQueue.Pending(); }
+		
+		const CDestructionBudget&	DestructionBudget() const { return m_destructionQueue.Budget(); }
+		void				DestructionBudget(const CDestructionBudget& budget) { m_destructionQueue.Budget(budget); }
+		
+	private:
+		template<typename CT>
+		std::vector<CT*>&	SceneComponents()
+		{
+			return std::get<TIndexOf<CT, Components...>::value>(m_componentLists);
+		}
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		TScene(const char* name):
+			mp_name(name)
+		{}
+		
+		~TScene()
+		{
+			// Components taken out of their game objects belong to the scene until the update finishes
+			for(auto& oldComponent : m_oldComponentList)
+			{
+				delete oldComponent.first;
+			}
+			
+			// Game objects waiting to be removed are still in one of the other lists
+			SafeDelete(m_goList);
+			SafeDelete(m_newGOList);
+		}
+		
+		TScene(const TScene& copy) = delete;
+		void operator= (const TScene& copy) = delete;
+		
+		// ===========================================================
+		// Methods for/from SuperClass/Interfaces
+		// ===========================================================
+	public:
+		void AddComponent(CComponent* component) override
+		{
+			assert(component && component->GameObject() && component->GameObject()->Scene() == this && "[TScene::AddComponent] The component's game object isn't in the scene");
+			
+			// A leaving game object is already asleep, the component waits with it and never starts
+			CGameObject* gameObject = component->GameObject();
+			if(gameObject->Removal() == ESceneRemoval::None)
+			{
+				component->Awake();
+			}
+			
+			// Pending game objects start all their components when they join
+			if(!dc::Exists(m_newGOList, gameObject))
+			{
+				m_newComponentList.push_back(component);
+			}
+		}
+		
+		void RemoveComponent(CComponent* component) override
+		{
+			assert(component && component->GameObject() && component->GameObject()->Scene() == this && "[TScene::RemoveComponent] The component's game object isn't in the scene");
+			
+			// Still waiting to start, it mustn't join the scene anymore
+			CGameObject* gameObject = component->GameObject();
+			bool started = !dc::Exists(m_newGOList, gameObject);
+			if(started && !m_newComponentList.empty())
+			{
+				const auto componentIt = std::find(m_newComponentList.begin(), m_newComponentList.end(), component);
+				if(componentIt != m_newComponentList.end())
+				{
+					m_newComponentList.erase(componentIt);
+					started = false;
+				}
+			}
+			
+			// Components of a leaving game object are already asleep, or never woke up
+			if(gameObject->Removal() == ESceneRemoval::None)
+			{
+				component->Sleep();
+			}
+			
+			// Updates may still reach it until it's out of the component lists
+			m_oldComponentList.emplace_back(component, started);
+		}
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Update()
+		{
+			DC_PROFILE_SCOPE("TScene::Update");
+			
+			PrepareUpdate();
+			(void)TExpand { 0, (UpdateComponents<Components>(), 0)... };
+			FinishUpdate();
+		}
+		
+		void Add(CGameObject* gameObject)
+		{
+			assert(gameObject && "[TScene::Add] game object can't be NULL");
+			
+			CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+			batch.AddHierarchy(gameObject);
+			for(CGameObject* child : batch.GameObjects())
+			{
+				assert(!Exists(child) && "[TScene::Add] You can't add more than one instance of a GameObject");
+				assert(!child->Scene() && "[TScene::Add] The game object is already in a scene");
+				child->Scene(this);
+			}
+			++m_hierarchyVersion;
+			m_newGOList.insert(m_newGOList.end(), batch.GameObjects().begin(), batch.GameObjects().end());
+			
+			batch.GroupByType();
+			batch.Dispatch(&CComponent::Awake, "Awake");
+			m_lifecycleBatchPool.Release();
+		}
+		
+		void Remove(CGameObject* gameObject)
+		{
+			RemoveHierarchy(gameObject);
+		}
+		
+		/**
+		 * Same as CScene::Destroy
+		 */
+		void Destroy(CGameObject* gameObject)
+		{
+			assert(gameObject && "[TScene::Destroy] game object can't be NULL");
+			
+			// Already queued, a second entry would destroy it twice
+			if(gameObject->Removal() == ESceneRemoval::Destroy)
+			{
+				return;
+			}
+			
+			RemoveHierarchy(gameObject);
+			gameObject->Removal(ESceneRemoval::Destroy);
+			m_destroyGOList.push_back(gameObject);
+		}
+		
+	private:
+		void RemoveHierarchy(CGameObject* gameObject)
+		{
+			// Game objects with a removal pending, from an overlapping hierarchy, are already asleep and listed
+			CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+			batch.AddHierarchy(gameObject, [](const CGameObject* child)
+			{
+				return child->Removal() == ESceneRemoval::None;
+			});
+			
+			for(CGameObject* child : batch.GameObjects())
+			{
+				child->Removal(ESceneRemoval::Remove);
+			}
+			m_oldGOList.insert(m_oldGOList.end(), batch.GameObjects().begin(), batch.GameObjects().end());
+			
+			batch.GroupByType();
+			batch.Dispatch(&CComponent::Sleep, "Sleep");
+			m_lifecycleBatchPool.Release();
+		}
+		
+		void PrepareUpdate()
+		{
+			if(!m_newComponentList.empty())
+			{
+				StartNewComponents();
+			}
+			
+			if(m_newGOList.empty())
+			{
+				return;
+			}
+			
+			CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+			batch.Add(m_newGOList);
+			m_newGOList.clear();
+			m_goList.insert(m_goList.end(), batch.GameObjects().begin(), batch.GameObjects().end());
+			
+			batch.GroupByType();
+			for(const CTypeRange& range : batch.TypeRanges())
+			{
+				for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+				{
+					(void)TExpand { 0, (RegisterComponent<Components>(batch.Components()[i]), 0)... };
+				}
+				batch.Dispatch(range, &CComponent::Start, "Start");
+			}
+			m_lifecycleBatchPool.Release();
+		}
+		
+		void StartNewComponents()
+		{
+			// Components of game objects leaving the scene don't start, they are dropped once their game objects are out
+			CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+			unsigned int count = 0;
+			for(CComponent* component : m_newComponentList)
+			{
+				if(component->GameObject()->Removal() != ESceneRemoval::None)
+				{
+					m_newComponentList[count++] = component;
+					continue;
+				}
+				batch.Add(component);
+			}
+			m_newComponentList.resize(count);
+			
+			batch.GroupByType();
+			for(const CTypeRange& range : batch.TypeRanges())
+			{
+				for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+				{
+					(void)TExpand { 0, (RegisterComponent<Components>(batch.Components()[i]), 0)... };
+				}
+				batch.Dispatch(range, &CComponent::Start, "Start");
+			}
+			m_lifecycleBatchPool.Release();
+		}
+		
+		void FinishOldComponents()
+		{
+			// Components taken out from Finish wait for the next update
+			TOldComponentList oldComponentList;
+			oldComponentList.swap(m_oldComponentList);
+			
+			// The ones that never started have nothing to finish
+			CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+			for(auto& oldComponent : oldComponentList)
+			{
+				if(oldComponent.second)
+				{
+					batch.Add(oldComponent.first);
+				}
+			}
+			
+			batch.GroupByType();
+			for(const CTypeRange& range : batch.TypeRanges())
+			{
+				for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+				{
+					(void)TExpand { 0, (UnregisterComponent<Components>(batch.Components()[i]), 0)... };
+				}
+				batch.Dispatch(range, &CComponent::Finish, "Finish");
+			}
+			m_lifecycleBatchPool.Release();
+			
+			for(auto& oldComponent : oldComponentList)
+			{
+				delete oldComponent.first;
+			}
+		}
+		
+		void FinishUpdate()
+		{
+			// Game objects destroyed from Finish are still in the scene, they wait for the next update
+			TGOList destroyList;
+			destroyList.swap(m_destroyGOList);
+			
+			if(!m_oldComponentList.empty())
+			{
+				FinishOldComponents();
+			}
+			
+			if(!m_oldGOList.empty())
+			{
+				// Removed game objects are still marked, one pass takes all of them out of each list
+				const auto removed = [](const CGameObject* gameObject)
+				{
+					return gameObject->Removal() != ESceneRemoval::None;
+				};
+				
+				// Removed before joining the scene, they never started so they don't finish
+				TGOList pendingList;
+				for(CGameObject* gameObject : m_newGOList)
+				{
+					if(removed(gameObject))
+					{
+						pendingList.push_back(gameObject);
+					}
+				}
+				
+				if(!pendingList.empty())
+				{
+					m_newGOList.erase(std::remove_if(m_newGOList.begin(), m_newGOList.end(), removed), m_newGOList.end());
+					std::sort(pendingList.begin(), pendingList.end());
+				}
+				
+				m_goList.erase(std::remove_if(m_goList.begin(), m_goList.end(), removed), m_goList.end());
+				
+				// Components added after their game object joined and still waiting to start don't finish either
+				TComponentList unstartedList(m_newComponentList);
+				std::sort(unstartedList.begin(), unstartedList.end());
+				const auto started = [&unstartedList](const CComponent* component)
+				{
+					return unstartedList.empty() || !std::binary_search(unstartedList.begin(), unstartedList.end(), component);
+				};
+				
+				CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+				for(CGameObject* gameObject : m_oldGOList)
+				{
+					gameObject->Scene(0);
+					
+					// Destroyed ones keep the mark until they are queued, their destroyed descendants look for it
+					if(gameObject->Removal() == ESceneRemoval::Remove)
+					{
+						gameObject->Removal(ESceneRemoval::None);
+					}
+					
+					if(pendingList.empty() || !std::binary_search(pendingList.begin(), pendingList.end(), gameObject))
+					{
+						batch.Add(gameObject, started);
+					}
+				}
+				m_oldGOList.clear();
+				++m_hierarchyVersion;
+				
+				// Out with their game objects, they may join again along with them
+				if(!m_newComponentList.empty())
+				{
+					m_newComponentList.erase(std::remove_if(m_newComponentList.begin(), m_newComponentList.end(), [this](CComponent* component)
+					{
+						return component->GameObject()->Scene() != this;
+					}), m_newComponentList.end());
+				}
+				
+				batch.GroupByType();
+				for(const CTypeRange& range : batch.TypeRanges())
+				{
+					for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+					{
+						(void)TExpand { 0, (UnregisterComponent<Components>(batch.Components()[i]), 0)... };
+					}
+					batch.Dispatch(range, &CComponent::Finish, "Finish");
+				}
+				m_lifecycleBatchPool.Release();
+			}
+			
+			// A destroyed game object below another destroyed one goes with its ancestor
+			for(CGameObject* gameObject : destroyList)
+			{
+				CTransform* transform = gameObject->Transform();
+				
+				bool ancestorDestroyed = false;
+				for(CTransform* ancestor = transform->Parent(); ancestor && !ancestorDestroyed; ancestor = ancestor->Parent())
+				{
+					ancestorDestroyed = ancestor->GameObject()->Removal() == ESceneRemoval::Destroy;
+				}
+				if(ancestorDestroyed)
+				{
+					continue;
+				}
+				
+				if(transform->HasParent())
+				{
+					transform->Parent()->Remove(transform);
+				}
+				m_destructionQueue.Enqueue(gameObject);
+			}
+			
+			m_destructionQueue.Process();
+		}
+		
+		template<typename CT>
+		void UpdateComponents()
+		{
+			DC_PROFILE_SCOPE_CAT(CT::TypeName(), "Update");
+			
+			// Qualified call, resolved at compile time. Without interest management nothing is inactive.
+			for(CT* component : SceneComponents<CT>())
+			{
+				component->CT::Update();
+			}
+		}
+		
+		template<typename CT>
+		void RegisterComponent(CComponent* component)
+		{
+			if(component->InstanceName() != CT::TypeName())
+			{
+				return;
+			}
+			
+			std::vector<CT*>& componentList = SceneComponents<CT>();
+			component->m_sceneIndex = componentList.size();
+			componentList.push_back(static_cast<CT*>(component));
+		}
+		
+		template<typename CT>
+		void UnregisterComponent(CComponent* component)
+		{
+			if(component->InstanceName() != CT::TypeName())
+			{
+				return;
+			}
+			
+			// Order doesn't matter here, the last one takes its place
+			std::vector<CT*>& componentList = SceneComponents<CT>();
+			const unsigned int index = component->m_sceneIndex;
+			assert(index < componentList.size() && componentList[index] == component && "[TScene::UnregisterComponent] The component isn't in the scene");
+			
+			componentList[index] = componentList.back();
+			componentList[index]->m_sceneIndex = index;
+			componentList.pop_back();
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		const char*			mp_name;
+		
+		TGOList				m_goList;
+		TGOList				m_newGOList;
+		TGOList				m_oldGOList;
+		TGOList				m_destroyGOList;
+		
+		TComponentList		m_newComponentList;		// Added to game objects already in the scene
+		TOldComponentList	m_oldComponentList;		// Taken out of their game objects, owned by the scene
+		
+		TComponentLists		m_componentLists;
+		CDestructionQueue	m_destructionQueue;
+		CLifecycleBatchPool	m_lifecycleBatchPool;
+	};
+}
@@ -0,0 +1,118 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  worldsnapshot.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "math/matrix.h"
+
+#include "gameobject.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	using TMatrixList = std::vector<math::Matrix4x4f>;
+	
+	/**
+	 * \class CWorldSnapshot
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Immutable copy of the world matrices of every game object in a scene,
+	 * taken at the end of an update. Game object pointers are only handles,
+	 * the objects may be gone by the time a reader looks at the snapshot.
+	 */
+	class CWorldSnapshot
+	{
+		friend class CScene;
+		
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		using TIndexTable = std::unordered_map<const CGameObject*, unsigned int>;
+		
+		static const unsigned int INVALID_INDEX = ~0u;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		/**
+		 * Frame in which the snapshot was taken
+		 */
+		const uint64_t				Epoch()			const { return m_epoch; }
+		const unsigned int			Size()			const { return m_matrixList.size(); }
+		
+		const TMatrixList&			Matrices()		const { return m_matrixList; }
+		const TGOList&				GameObjects()	const { return m_gameObjectList; }
+		
+		const unsigned int IndexOf(const CGameObject* gameObject) const
+		{
+			const auto& indexEntryIt = m_indexTable.find(gameObject);
+			return indexEntryIt != m_indexTable.end() ? indexEntryIt->second : INVALID_INDEX;
+		}
+		
+		/**
+		 * Returns NULL if the game object wasn't in the scene when the snapshot was taken
+		 */
+		const math::Matrix4x4f* WorldMatrix(const CGameObject* gameObject) const
+		{
+			const unsigned int index = IndexOf(gameObject);
+			return index != INVALID_INDEX ? &m_matrixList[index] : 0;
+		}
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CWorldSnapshot():
+			m_epoch(0),
+			m_layoutVersion(~uint64_t(0))
+		{}
+		
+		CWorldSnapshot(const CWorldSnapshot& copy) = delete;
+		void operator= (const CWorldSnapshot& copy) = delete;
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		uint64_t		m_epoch;
+		uint64_t		m_layoutVersion;	// Version of the game object list the index table was built from
+		
+		TMatrixList		m_matrixList;
+		TGOList			m_gameObjectList;
+		TIndexTable		m_indexTable;
+	};
+	
+	// ===========================================================
+	// Class typedefs
+	// ===========================================================
+	
+	using TWorldSnapshotPtr = std::shared_ptr<const CWorldSnapshot>;
+}
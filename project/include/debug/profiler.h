@@ -0,0 +1,235 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  profiler.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Scoped instrumentation, removed at compile time unless DC_PROFILER_ENABLED is defined
+#if defined(DC_PROFILER_ENABLED)
+	#define DC_PROFILE_CONCAT_IMPL(a, b)	a##b
+	#define DC_PROFILE_CONCAT(a, b)			DC_PROFILE_CONCAT_IMPL(a, b)
+	#define DC_PROFILE_SCOPE(name)					dc::CProfileScope DC_PROFILE_CONCAT(profileScope, __LINE__)(name, "dc")
+	#define DC_PROFILE_SCOPE_CAT(name, category)	dc::CProfileScope DC_PROFILE_CONCAT(profileScope, __LINE__)(name, category)
+#else
+	#define DC_PROFILE_SCOPE(name)
+	#define DC_PROFILE_SCOPE_CAT(name, category)
+#endif
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	/**
+	 * A single timed scope. Names and categories must be string literals
+	 * or any other string that outlives the profiler (component type names are fine).
+	 */
+	struct CProfileSample
+	{
+		const char*		mp_name;
+		const char*		mp_category;
+		uint64_t		m_startNs;
+		uint64_t		m_endNs;
+		unsigned int	m_threadIndex;
+	};
+	
+	using TProfileSampleList = std::vector<CProfileSample>;
+	
+	/**
+	 * Aggregated timings for one scope name, in microseconds
+	 */
+	struct CProfileStat
+	{
+		const char*		mp_name;
+		const char*		mp_category;
+		unsigned int	m_count;
+		double			m_meanUs;
+		double			m_p50Us;
+		double			m_p99Us;
+		double			m_maxUs;
+	};
+	
+	using TProfileStatList = std::vector<CProfileStat>;
+	
+	/**
+	 * \class CProfileRingBuffer
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Single producer / single consumer ring of samples. The owning thread pushes,
+	 * the profiler drains. When full, new samples are dropped and counted.
+	 */
+	class CProfileRingBuffer
+	{
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int	ThreadIndex() const	{ return m_threadIndex; }
+		const uint64_t		Dropped() const		{ return m_dropped.load(std::memory_order_relaxed); }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CProfileRingBuffer(const unsigned int threadIndex, const unsigned int capacityLog2);
+		
+		CProfileRingBuffer(const CProfileRingBuffer& copy) = delete;
+		void operator= (const CProfileRingBuffer& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Push(const CProfileSample& sample);
+		
+		/**
+		 * Moves every pending sample to the output list
+		 */
+		void Drain(TProfileSampleList& output);
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		const unsigned int		m_threadIndex;
+		const uint64_t			m_mask;
+		TProfileSampleList		m_samples;
+		
+		std::atomic<uint64_t>	m_head;		// Written by the producer
+		std::atomic<uint64_t>	m_tail;		// Written by the consumer
+		std::atomic<uint64_t>	m_dropped;
+	};
+	
+	/**
+	 * \class CProfiler
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Collects samples from every thread that opened a profile scope.
+	 * Recording never locks, only the first scope of a thread registers its buffer.
+	 */
+	class CProfiler
+	{
+		// ===========================================================
+		// Static fields / methods
+		// ===========================================================
+	public:
+		static CProfiler&	Instance();
+		
+		static uint64_t		NowNs();
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const TProfileSampleList&	Samples() const { return m_samples; }
+		
+		const uint64_t				Dropped() const;
+		
+		/**
+		 * Ring buffer of the calling thread, created on first use
+		 */
+		CProfileRingBuffer&			ThreadBuffer();
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CProfiler(const unsigned int bufferCapacityLog2 = 16);
+		
+		CProfiler(const CProfiler& copy) = delete;
+		void operator= (const CProfiler& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Drains all the thread buffers into the collected sample list.
+		 * Call it from a single thread, typically once per frame or before exporting.
+		 */
+		void Collect();
+		
+		void Clear();
+		
+		/**
+		 * Writes the collected samples using the Chrome trace event format (chrome://tracing, Perfetto)
+		 */
+		void ExportChromeTrace(std::ostream& output) const;
+		const bool ExportChromeTrace(const char* path) const;
+		
+		/**
+		 * Mean, median and 99th percentile per scope name
+		 */
+		TProfileStatList Summary() const;
+		
+		void PrintSummary(std::ostream& output) const;
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		const unsigned int			m_bufferCapacityLog2;
+		
+		std::mutex					m_registryMutex;
+		std::vector<std::unique_ptr<CProfileRingBuffer>>	m_bufferList;
+		
+		TProfileSampleList			m_samples;
+	};
+	
+	/**
+	 * \class CProfileScope
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Times its own lifetime. Use it through the DC_PROFILE_SCOPE macros.
+	 */
+	class CProfileScope
+	{
+	public:
+		CProfileScope(const char* name, const char* category):
+			mp_name(name),
+			mp_category(category),
+			m_startNs(CProfiler::NowNs())
+		{}
+		
+		~CProfileScope()
+		{
+			CProfileRingBuffer& buffer = CProfiler::Instance().ThreadBuffer();
+			buffer.Push(CProfileSample { mp_name, mp_category, m_startNs, CProfiler::NowNs(), buffer.ThreadIndex() });
+		}
+		
+		CProfileScope(const CProfileScope& copy) = delete;
+		void operator= (const CProfileScope& copy) = delete;
+		
+	private:
+		const char*	mp_name;
+		const char*	mp_category;
+		uint64_t	m_startNs;
+	};
+}
@@ -0,0 +1,297 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  stats.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	enum class EStatsSubsystem
+	{
+		GameObject,
+		Component,
+		Scene,
+		Count
+	};
+	
+	enum class EStatsFormat
+	{
+		Text,
+		Json
+	};
+	
+	/**
+	 * \class CStatCounter
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Counter split in shards so threads don't fight over the same cache line.
+	 * Writes are relaxed atomics, reading sums every shard.
+	 */
+	class CStatCounter
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+		static const unsigned int SHARD_COUNT = 8;
+		
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+		struct alignas(64) CShard
+		{
+			std::atomic<int64_t>	m_value;
+		};
+		
+		// ===========================================================
+		// Static fields / methods
+		// ===========================================================
+	private:
+		static unsigned int ShardIndex()
+		{
+			static std::atomic<unsigned int> s_nextShard(0);
+			static thread_local unsigned int t_shard = s_nextShard.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+			return t_shard;
+		}
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const int64_t Value() const
+		{
+			int64_t value = 0;
+			for(const CShard& shard : m_shards)
+			{
+				value += shard.m_value.load(std::memory_order_relaxed);
+			}
+			return value;
+		}
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CStatCounter()
+		{
+			Reset();
+		}
+		
+		CStatCounter(const CStatCounter& copy) = delete;
+		void operator= (const CStatCounter& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Add(const int64_t amount)
+		{
+			m_shards[ShardIndex()].m_value.fetch_add(amount, std::memory_order_relaxed);
+		}
+		
+		void Increment()	{ Add(1); }
+		void Decrement()	{ Add(-1); }
+		
+		void Reset()
+		{
+			for(CShard& shard : m_shards)
+			{
+				shard.m_value.store(0, std::memory_order_relaxed);
+			}
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		CShard	m_shards[SHARD_COUNT];
+	};
+	
+	/**
+	 * \class CTimeHistogram
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Power of two buckets in microseconds, bucket i holds [2^i, 2^(i+1)) us
+	 */
+	class CTimeHistogram
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const unsigned int BUCKET_COUNT = 24;
+		
+		using TBucketList = std::vector<uint64_t>;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		TBucketList Buckets() const;
+		
+		/**
+		 * Upper bound, in microseconds, of the bucket holding the given percentile
+		 */
+		static const uint64_t Percentile(const TBucketList& buckets, const double percentile);
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CTimeHistogram()
+		{
+			Reset();
+		}
+		
+		CTimeHistogram(const CTimeHistogram& copy) = delete;
+		void operator= (const CTimeHistogram& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Record(const uint64_t microseconds);
+		void Reset();
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::atomic<uint64_t>	m_buckets[BUCKET_COUNT];
+	};
+	
+	/**
+	 * \class CStats
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Process wide counters shared by every scene
+	 */
+	class CStats
+	{
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	public:
+		struct CSubsystemCounters
+		{
+			CStatCounter	m_live;
+			CStatCounter	m_allocations;
+			CStatCounter	m_bytes;		// Accumulated since start up
+		};
+		
+		// ===========================================================
+		// Static fields / methods
+		// ===========================================================
+	public:
+		static CStats& Instance()
+		{
+			static CStats instance;
+			return instance;
+		}
+		
+		static const char* SubsystemName(const EStatsSubsystem subsystem);
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		CSubsystemCounters&	Subsystem(const EStatsSubsystem subsystem)	{ return m_subsystemList[(unsigned int)subsystem]; }
+		
+		CStatCounter&		ComponentLookups()		{ return m_componentLookups; }
+		CStatCounter&		TransformUpdates()		{ return m_transformUpdates; }
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Accumulates one heap allocation, live counts are tracked by constructors and destructors
+		 */
+		void Allocated(const EStatsSubsystem subsystem, const int64_t bytes)
+		{
+			CSubsystemCounters& counters = Subsystem(subsystem);
+			counters.m_allocations.Increment();
+			counters.m_bytes.Add(bytes);
+		}
+		
+		void Constructed(const EStatsSubsystem subsystem)	{ Subsystem(subsystem).m_live.Increment(); }
+		void Destroyed(const EStatsSubsystem subsystem)		{ Subsystem(subsystem).m_live.Decrement(); }
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		CSubsystemCounters	m_subsystemList[(unsigned int)EStatsSubsystem::Count];
+		CStatCounter		m_componentLookups;
+		CStatCounter		m_transformUpdates;
+	};
+	
+	/**
+	 * Plain copy of the counters at one moment, cheap to take and safe to keep
+	 */
+	struct CStatsSnapshot
+	{
+		struct CSubsystem
+		{
+			int64_t	m_live;
+			int64_t	m_allocations;
+			int64_t	m_bytes;
+		};
+		
+		using TTypeCountList = std::vector<std::pair<const char*, unsigned int>>;
+		
+		const char*					mp_name;
+		uint64_t					m_frame;
+		
+		unsigned int				m_gameObjects;
+		unsigned int				m_pendingNew;
+		unsigned int				m_pendingOld;
+		TTypeCountList				m_componentsPerType;
+		
+		int64_t						m_componentLookups;
+		int64_t						m_transformUpdates;
+		int64_t						m_transformUpdatesLastFrame;
+		CSubsystem					m_subsystemList[(unsigned int)EStatsSubsystem::Count];
+		
+		CTimeHistogram::TBucketList	m_frameTimeBuckets;
+		
+		CStatsSnapshot();
+		
+		/**
+		 * Copies the process wide counters
+		 */
+		void CaptureGlobals();
+		
+		void Write(std::ostream& output, const EStatsFormat format) const;
+		void WriteText(std::ostream& output) const;
+		void WriteJson(std::ostream& output) const;
+	};
+}
@@ -19,6 +19,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 //
 #pragma once
 
+#include <algorithm>
 #include <vector>
 
 namespace dc
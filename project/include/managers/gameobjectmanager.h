@@ -2,76 +2,177 @@
 //	gameobjectmanager
 //	DCPP_COMPONENTS
 //
-//	Created by Jorge L├│pez Gonz├ílez on 22/07/2018 21:40:02.
+//	Created by Jorge López González on 22/07/2018 21:40:02.
 //
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "components/gameobject.h"
+#include "components/scene.h"
+#include "debug/stats.h"
+#include "threading/threadpool.h"
 
 namespace dc
 {
 	// ===========================================================
 	// External Enums / Typedefs for global usage
 	// ===========================================================
+	
+	using TGOHandle = uint64_t;
+	
 	/**
 	 * \class CGameObjectMgr
 	 * \brief
-	 * \author Jorge L├│pez Gonz├ílez
+	 * \author Jorge López González
 	 *
-	 * Description.
+	 * Owns the game objects of every scene in the process. They are registered in a table split
+	 * in shards, each with its own lock, so scenes on different threads can create and destroy
+	 * game objects at the same time. Handles are generational: a handle to a deleted game object
+	 * stays invalid even after its slot is reused.
+	 * It also owns the scenes and updates them in parallel, each one always on the same worker.
 	 */
-class CGameObjectMgr
-{
-	// ===========================================================
-	// Constant / Enums / Typedefs internal usage
-	// ===========================================================
-	
-	// ===========================================================
-	// Static fields / methods
-	// ===========================================================
+	class CGameObjectMgr
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const TGOHandle INVALID_HANDLE = 0;
+		
+	private:
+		static const unsigned int SHARD_BITS = 4;
+		static const unsigned int SHARD_COUNT = 1 << SHARD_BITS;
+		
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	private:
+		struct CSlot
+		{
+			CGameObject*	mp_gameObject;
+			unsigned int	m_generation;
+		};
+		
+		/**
+		 * The manager may be allocated with new, which ignores alignas in C++11,
+		 * so the padding keeps neighbour shards off each other's cache lines
+		 */
+		struct CShard
+		{
+			std::mutex					m_mutex;
+			std::vector<CSlot>			m_slotList;
+			std::vector<unsigned int>	m_freeList;
+			unsigned int				m_count;
+			char						m_padding[64];
+			
+			CShard(): m_count(0) {}
+		};
+		
+		struct CManagedScene
+		{
+			CScene*	mp_scene;
+			int		m_worker;
+		};
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		/**
+		 * The game object must be alive, test handles to know if a game object still exists
+		 */
+		const bool Exists(const CGameObject* gameObject) const;
+		const bool Exists(const TGOHandle handle) const { return Find(handle) != 0; }
+		
+		/**
+		 * Game object registered with the handle, NULL when it has been deleted
+		 */
+		CGameObject* Find(const TGOHandle handle) const;
+		
+		/**
+		 * Registered game objects, summing all the shards
+		 */
+		const unsigned int Count() const;
+		
+		const unsigned int SceneCount() const { return m_sceneList.size(); }
+		CScene* Scene(const unsigned int index) const { return m_sceneList[index].mp_scene; }
+		
+		/**
+		 * Worker that updates the scene
+		 */
+		const int Affinity(const CScene* scene) const;
+		
+		CThreadPool& ThreadPool() { return *mp_threadPool; }
+		
+		/**
+		 * Copies the registered count and the process wide counters
+		 */
+		CStatsSnapshot Stats() const;
 
-	// ===========================================================
-	// Inner and Anonymous Classes
-	// ===========================================================
-
-	// ===========================================================
-	// Getter & Setter
-	// ===========================================================
-public:
-	const bool Exists(const CGameObject* gameObject) const;
-
-	// ===========================================================
-	// Constructors
-	// ===========================================================
-public:
-	CGameObjectMgr()
-	{}
-
-	~CGameObjectMgr();
-	// ===========================================================
-	// Methods for/from SuperClass/Interfaces
-	// ===========================================================
-
-	// ===========================================================
-	// Methods
-	// ===========================================================
-
-	// ===========================================================
-	// Fields
-	// ===========================================================
-
-private:
-	TGOList				m_goList;
-	TGOList				m_newGOList;
-	TGOList				m_oldGOList;
-};
-
-	// ===========================================================
-	// Class typedefs
-	// ===========================================================
-	
-	// ===========================================================
-	// Template/Inline implementation
-	// ===========================================================
-}
\ No newline at end of file
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		/**
+		 * Zero workers means one per hardware thread
+		 */
+		CGameObjectMgr(const unsigned int workerCount = 0);
+		
+		/**
+		 * Deletes the scenes with their game objects, then the game objects in no scene
+		 */
+		~CGameObjectMgr();
+		
+		CGameObjectMgr(const CGameObjectMgr& copy) = delete;
+		void operator= (const CGameObjectMgr& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Creates a game object owned by the manager. Thread safe.
+		 */
+		CGameObject* Create(const char* name);
+		
+		/**
+		 * The manager takes ownership of the game object, deleting it unregisters it. Thread safe.
+		 */
+		const TGOHandle Register(CGameObject* gameObject);
+		
+		/**
+		 * Gives up ownership without deleting it. Thread safe.
+		 */
+		void Unregister(CGameObject* gameObject);
+		
+		/**
+		 * Scenes are given workers in turns and run their asynchronous awakes on the manager pool.
+		 * Don't create or destroy scenes during Update.
+		 */
+		CScene* CreateScene(const char* name);
+		void DestroyScene(CScene* scene);
+		
+		/**
+		 * Updates all the scenes in parallel and returns when all of them are done.
+		 * A scene must not touch the game objects of another during its update.
+		 */
+		void Update();
+		
+	private:
+		CShard& ShardOf(const TGOHandle handle) const { return m_shardList[handle & (SHARD_COUNT - 1)]; }
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		mutable CShard						m_shardList[SHARD_COUNT];
+		std::vector<CManagedScene>			m_sceneList;
+		unsigned int						m_nextAffinity;
+		std::unique_ptr<CThreadPool>		mp_threadPool;
+	};
+}
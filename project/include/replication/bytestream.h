@@ -0,0 +1,221 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  bytestream.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	using TByteList = std::vector<uint8_t>;
+	
+	/**
+	 * \class CByteWriter
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Appends little endian values and LEB128 varints to a byte list
+	 */
+	class CByteWriter
+	{
+		// ===========================================================
+		// Static fields / methods
+		// ===========================================================
+	public:
+		static uint32_t ZigZag(const int32_t value)	{ return (uint32_t(value) << 1) ^ uint32_t(value >> 31); }
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const TByteList&	Bytes() const	{ return m_byteList; }
+		const size_t		Size() const	{ return m_byteList.size(); }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CByteWriter() {}
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Clear()	{ m_byteList.clear(); }
+		
+		void WriteByte(const uint8_t value)	{ m_byteList.push_back(value); }
+		
+		void WriteVarUInt(uint64_t value)
+		{
+			while(value >= 0x80)
+			{
+				m_byteList.push_back(uint8_t(value | 0x80));
+				value >>= 7;
+			}
+			m_byteList.push_back(uint8_t(value));
+		}
+		
+		void WriteVarInt(const int32_t value)	{ WriteVarUInt(ZigZag(value)); }
+		
+		void WriteFloat(const float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			for(unsigned int i = 0; i < 4; ++i)
+			{
+				m_byteList.push_back(uint8_t(bits >> (i * 8)));
+			}
+		}
+		
+		void WriteBytes(const uint8_t* data, const size_t size)
+		{
+			WriteVarUInt(size);
+			m_byteList.insert(m_byteList.end(), data, data + size);
+		}
+		
+		void WriteString(const std::string& value)
+		{
+			WriteBytes((const uint8_t*)value.data(), value.size());
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		TByteList	m_byteList;
+	};
+	
+	/**
+	 * \class CByteReader
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Reads what CByteWriter wrote. Reading past the end sets the error flag and returns zeros.
+	 */
+	class CByteReader
+	{
+		// ===========================================================
+		// Static fields / methods
+		// ===========================================================
+	public:
+		static int32_t UnZigZag(const uint32_t value)	{ return int32_t(value >> 1) ^ -int32_t(value & 1); }
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const bool		Error() const		{ return m_error; }
+		const bool		AtEnd() const		{ return mp_cursor == mp_end; }
+		const size_t	Remaining() const	{ return mp_end - mp_cursor; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CByteReader(const uint8_t* data, const size_t size):
+			mp_cursor(data),
+			mp_end(data + size),
+			m_error(false)
+		{}
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		const uint8_t ReadByte()
+		{
+			if(mp_cursor == mp_end)
+			{
+				m_error = true;
+				return 0;
+			}
+			return *mp_cursor++;
+		}
+		
+		const uint64_t ReadVarUInt()
+		{
+			uint64_t value = 0;
+			for(unsigned int shift = 0; shift < 64; shift += 7)
+			{
+				const uint8_t byte = ReadByte();
+				value |= uint64_t(byte & 0x7f) << shift;
+				if(!(byte & 0x80))
+				{
+					return value;
+				}
+			}
+			m_error = true;
+			return 0;
+		}
+		
+		const int32_t ReadVarInt()	{ return UnZigZag(uint32_t(ReadVarUInt())); }
+		
+		const float ReadFloat()
+		{
+			uint32_t bits = 0;
+			for(unsigned int i = 0; i < 4; ++i)
+			{
+				bits |= uint32_t(ReadByte()) << (i * 8);
+			}
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+		
+		/**
+		 * Returns a pointer into the buffer, NULL if there weren't enough bytes
+		 */
+		const uint8_t* ReadBytes(size_t& size)
+		{
+			size = ReadVarUInt();
+			if(size > Remaining())
+			{
+				m_error = true;
+				size = 0;
+				return 0;
+			}
+			const uint8_t* data = mp_cursor;
+			mp_cursor += size;
+			return data;
+		}
+		
+		std::string ReadString()
+		{
+			size_t size;
+			const uint8_t* data = ReadBytes(size);
+			return data ? std::string((const char*)data, size) : std::string();
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		const uint8_t*	mp_cursor;
+		const uint8_t*	mp_end;
+		bool			m_error;
+	};
+}
@@ -0,0 +1,156 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  deltacodec.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "snapshot.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	/**
+	 * \class CDeltaEncoder
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Writes the differences between two snapshots: removed game objects,
+	 * created ones in full and, for the rest, only the fields that changed.
+	 */
+	class CDeltaEncoder
+	{
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const size_t		LastBytes() const		{ return m_lastBytes; }
+		const uint64_t		TotalBytes() const		{ return m_totalBytes; }
+		const unsigned int	EncodedCount() const	{ return m_encodedCount; }
+		const double		AverageBytes() const	{ return m_encodedCount ? double(m_totalBytes) / m_encodedCount : 0.0; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CDeltaEncoder():
+			m_lastBytes(0),
+			m_totalBytes(0),
+			m_encodedCount(0)
+		{}
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Appends the delta that turns baseline into current. Use an empty snapshot as baseline for a full update.
+		 */
+		void Encode(const CSceneSnapshot& baseline, const CSceneSnapshot& current, CByteWriter& writer);
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		size_t			m_lastBytes;
+		uint64_t		m_totalBytes;
+		unsigned int	m_encodedCount;
+	};
+	
+	/**
+	 * \class CDeltaDecoder
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Applies deltas to a replica scene, creating, updating and removing game objects.
+	 * The decoder owns the game objects it creates. Removed ones go through CScene::Remove
+	 * and are deleted on the next Apply, so the scene has to update in between.
+	 */
+	class CDeltaDecoder
+	{
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	private:
+		struct CReplica
+		{
+			CGameObject*	mp_gameObject;
+			std::string		m_name;			// CGameObject doesn't own its name
+		};
+		
+		using TReplicaTable = std::unordered_map<uint32_t, CReplica>;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		/**
+		 * Last state applied, the baseline the next delta must be built against
+		 */
+		const CSceneSnapshot&	State() const	{ return m_state; }
+		
+		/**
+		 * Local game object replicating the remote one, NULL if unknown
+		 */
+		CGameObject*			Replica(const uint32_t remoteId) const;
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CDeltaDecoder(CScene& scene, const CQuantization& quantization, const CReplicationRegistry* registry = 0);
+		~CDeltaDecoder();
+		
+		CDeltaDecoder(const CDeltaDecoder& copy) = delete;
+		void operator= (const CDeltaDecoder& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Returns false, leaving everything untouched, when the data is corrupt
+		 * or was encoded against a baseline other than State()
+		 */
+		const bool Apply(const uint8_t* data, const size_t size);
+		
+	private:
+		CGameObject* Create(const CSnapshotEntry& entry);
+		
+		void ApplyTransform(CGameObject* gameObject, const CSnapshotEntry& entry);
+		void ApplyPayloads(CGameObject* gameObject, const CSnapshotEntry& entry);
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		CScene&						m_scene;
+		CQuantization				m_quantization;
+		const CReplicationRegistry*	mp_registry;
+		
+		CSceneSnapshot				m_state;
+		TReplicaTable				m_replicaTable;
+		TGOList						m_removedList;
+	};
+}
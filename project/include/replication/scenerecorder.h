@@ -0,0 +1,159 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  scenerecorder.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "bytestream.h"
+#include "components/transform.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	class CGameObject;
+	class CScene;
+	
+	/**
+	 * Operations of a scene recording. Game objects are referred to by record ids,
+	 * dense and starting at 1, 0 stands for none.
+	 */
+	enum class EReplayOp : uint8_t
+	{
+		Frame,				// The scene updates
+		Add,				// Hierarchy size, then every game object in pre-order
+		Remove,				// Record id
+		Destroy,			// Record id
+		AddComponent,		// Record id, type name
+		RemoveComponent,	// Record id, type name
+		Active,				// Record id, flag
+		Parent,				// Child and parent record ids
+		RemoveChild,		// Parent and child record ids
+		Detach,				// Record id
+		Reparent,			// Count, then child and parent record id pairs
+		LocalMatrix,		// Record id, the matrix bytes
+		LocalPosition,		// Record id, x y z
+		LocalRotation,		// Record id, x y z w
+		LocalScale,			// Record id, x y z
+		Freeze,				// Record id
+		Unfreeze,			// Record id
+		Count
+	};
+	
+	/**
+	 * \class CSceneRecorder
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Records in a compact binary timeline what happens to a scene: game objects coming and
+	 * going, components added and removed, and transform changes, with a mark every update.
+	 * CSceneReplayer rebuilds the scene from it and runs the same timeline without the game.
+	 *
+	 * Matrices are stored as raw bytes, so a recording only replays against the same math library.
+	 * Changes made through CTransform::LocalTRS aren't seen.
+	 */
+	class CSceneRecorder
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const uint32_t MAGIC = 0x50524344;		// "DCRP"
+		static const uint32_t VERSION = 1;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const uint64_t		FrameCount() const		{ return m_frameCount; }
+		const size_t		Size() const			{ return m_writer.Size(); }
+		
+		/**
+		 * Header and timeline, ready to be saved
+		 */
+		TByteList			Bytes() const;
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CSceneRecorder();
+		
+		CSceneRecorder(const CSceneRecorder& copy) = delete;
+		void operator= (const CSceneRecorder& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		const bool Save(const char* path) const;
+		
+		/**
+		 * Records the game objects already in the scene as added
+		 */
+		void Begin(const CScene& scene);
+		
+		void Frame();
+		
+		void Add(CGameObject* gameObject);
+		void Remove(CGameObject* gameObject);
+		void Destroy(CGameObject* gameObject);
+		
+		void AddComponent(const CGameObject* gameObject, const char* name);
+		void RemoveComponent(const CGameObject* gameObject, const char* name);
+		void Active(const CGameObject* gameObject, const bool active);
+		
+		void Parent(const CTransform* child, const CTransform* parent);
+		void RemoveChild(const CTransform* parent, const CTransform* child);
+		void Detach(const CTransform* transform);
+		void Reparent(const TReparentList& reparentList);
+		
+		void LocalMatrix(const CTransform* transform, const math::Matrix4x4f& matrix);
+		void LocalPosition(const CTransform* transform, const math::Vector3f& position);
+		void LocalRotation(const CTransform* transform, const math::Quaternionf& rotation);
+		void LocalScale(const CTransform* transform, const math::Vector3f& scale);
+		void Freeze(const CTransform* transform);
+		void Unfreeze(const CTransform* transform);
+		
+	private:
+		/**
+		 * Record id of the game object, given the first time it's seen
+		 */
+		const uint32_t RecordId(const CGameObject* gameObject);
+		const uint32_t RecordId(const CTransform* transform);
+		
+		void WriteOp(const EReplayOp op, const uint32_t recordId);
+		void WriteVector(const math::Vector3f& vector);
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		CByteWriter									m_writer;
+		std::unordered_map<unsigned int, uint32_t>	m_recordIdMap;		// Game object id to record id
+		uint32_t									m_nextRecordId;
+		uint64_t									m_frameCount;
+	};
+}
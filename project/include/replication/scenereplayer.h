@@ -0,0 +1,167 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  scenereplayer.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "bytestream.h"
+#include "scenerecorder.h"
+#include "components/component.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	using TComponentCreator = std::function<CComponent*()>;
+	
+	/**
+	 * Stands in for the recorded components whose type isn't registered in the replayer.
+	 * It does nothing, but the scene files it under the recorded type name.
+	 */
+	class CReplayComponent : public CComponent
+	{
+	public:
+		CReplayComponent(const char* name):
+			mp_name(name)
+		{}
+		
+		const char* InstanceName() const override	{ return mp_name; }
+		const bool Is(const char* name) const override	{ return strcmp(name, mp_name) == 0 || CComponent::Is(name); }
+		CComponent* Clone() const override			{ return new CReplayComponent(mp_name); }
+		
+	private:
+		const char*	mp_name;
+	};
+	
+	/**
+	 * \class CSceneReplayer
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Runs a CSceneRecorder timeline on a scene: rebuilds the game objects, applies the recorded
+	 * changes in order and updates the scene at every frame mark. Changes made during an update
+	 * are applied right before the next one.
+	 *
+	 * Components of registered types are created for real, the rest are CReplayComponent.
+	 * What the real ones change is replayed from the recording as well, so register the
+	 * types whose cost matters but that don't change the scene.
+	 * The replayer must go away before the scene.
+	 */
+	class CSceneReplayer
+	{
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const bool			Error() const		{ return m_error; }
+		const bool			AtEnd() const		{ return m_cursor == m_byteList.size(); }
+		
+		/**
+		 * Updates run so far
+		 */
+		const uint64_t		Frame() const		{ return m_frame; }
+		
+		/**
+		 * Game objects created by the replay and not destroyed yet
+		 */
+		const unsigned int	GameObjectCount() const;
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CSceneReplayer(CScene& scene);
+		
+		/**
+		 * Deletes the replayed game objects that aren't in a scene, the scene deletes the rest
+		 */
+		~CSceneReplayer();
+		
+		CSceneReplayer(const CSceneReplayer& copy) = delete;
+		void operator= (const CSceneReplayer& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Components of the type are created with their default constructor
+		 */
+		template<typename ComponentType>
+		void RegisterComponent()
+		{
+			m_creatorMap[ComponentType::TypeName()] = [] { return new ComponentType(); };
+		}
+		
+		/**
+		 * Returns false when the bytes aren't a recording of this build
+		 */
+		const bool Load(const TByteList& byteList);
+		const bool Load(const char* path);
+		
+		/**
+		 * Applies the changes up to the next frame mark and updates the scene.
+		 * Returns false once the timeline is over or broken.
+		 */
+		const bool Step();
+		
+	private:
+		const bool Apply(const EReplayOp op, CByteReader& reader);
+		void ApplyAdd(CByteReader& reader);
+		
+		CGameObject* Lookup(const uint64_t recordId);
+		CTransform* LookupTransform(const uint64_t recordId);
+		CGameObject* LookupInScene(const uint64_t recordId);
+		
+		/**
+		 * False when the parent is the child or below it, which only a broken timeline asks for
+		 */
+		const bool CanParent(const CTransform* child, const CTransform* parent);
+		
+		const char* Intern(CByteReader& reader);
+		CComponent* CreateComponent(const char* name);
+		
+		const math::Vector3f ReadVector(CByteReader& reader);
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		CScene&										m_scene;
+		TByteList									m_byteList;
+		size_t										m_cursor;
+		bool										m_error;
+		uint64_t									m_frame;
+		
+		std::vector<CGameObject*>					m_gameObjectList;	// By record id, NULL when unknown or destroyed
+		std::unordered_map<const CGameObject*, uint32_t>	m_recordIdMap;
+		std::unordered_set<std::string>				m_nameSet;			// Names handed to game objects and components
+		std::unordered_map<std::string, TComponentCreator>	m_creatorMap;
+	};
+}
@@ -0,0 +1,125 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  sharedsceneexporter.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sharedscenelayout.h"
+
+#include "components/componentstorage.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	class CGameObject;
+	class CScene;
+	class CTransform;
+	
+	/**
+	 * \class CSharedSceneExporter
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Keeps a named POSIX shared memory region with the id, name, parent and world matrix of every
+	 * game object of a scene, so other processes on the machine can read them with CSharedSceneReader.
+	 * The scene exports at the end of every Update, writing only the changed world matrices and
+	 * the entries of game objects that came or went. Every game object keeps its entry while it
+	 * stays in the scene, free entries have id 0. Game objects past the capacity are left out.
+	 */
+	class CSharedSceneExporter
+	{
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const bool			IsOpen() const		{ return mp_header != 0; }
+		const unsigned int	Capacity() const	{ return mp_header ? mp_header->m_capacity : 0; }
+		
+		/**
+		 * Entries written in the last export
+		 */
+		const unsigned int	WrittenCount() const	{ return m_writtenCount; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CSharedSceneExporter();
+		~CSharedSceneExporter();
+		
+		CSharedSceneExporter(const CSharedSceneExporter& copy) = delete;
+		void operator= (const CSharedSceneExporter& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Creates the region, replacing any other with the same name. Names follow shm_open,
+		 * a slash and no more slashes. Returns false where there is no POSIX shared memory.
+		 */
+		const bool Open(const char* name, const unsigned int capacity);
+		
+		/**
+		 * Removes the name, readers that mapped the region keep it until they close
+		 */
+		void Close();
+		
+		void Export(CScene& scene);
+		
+	private:
+		void Clear();
+		
+		/**
+		 * Gives entries to the game objects that joined the scene, frees the ones of those that
+		 * left and links every entry to its parent
+		 */
+		void SyncEntries(const CScene& scene);
+		
+		void WriteEntry(const unsigned int index, const CGameObject* gameObject);
+		void WriteMatrix(CSharedGameObject& entry, const CTransform* transform, const uint64_t frame);
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::string				m_name;
+		CSharedSceneHeader*		mp_header;
+		CSharedGameObject*		mp_entryList;
+		size_t					m_size;
+		
+		const CScene*			mp_scene;				// Scene the entries belong to
+		uint64_t				m_sceneVersion;			// Its game object list version when last synced
+		unsigned int			m_hierarchyVersion;
+		uint64_t				m_exportTick;			// Changes from this tick on are not exported yet
+		unsigned int			m_writtenCount;
+		
+		CSparseIndex				m_index;		// Game object id to entry
+		std::vector<unsigned int>	m_freeList;
+		std::vector<uint32_t>		m_seenList;		// Stamp of the last sync that found each entry in the scene
+		uint32_t					m_stamp;
+	};
+}
@@ -0,0 +1,73 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  sharedscenelayout.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	// Processes only share the sequence if it is a plain 64 bits word
+	static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The shared scene sequence needs lock free 64 bits atomics");
+	
+	/**
+	 * Start of the shared memory region written by CSharedSceneExporter and mapped by
+	 * CSharedSceneReader, followed by m_capacity game object entries.
+	 * Only plain data, so processes built without the rest of the library can map it too.
+	 */
+	struct CSharedSceneHeader
+	{
+		static const uint32_t MAGIC = 0x48534344;		// "DCSH"
+		static const uint32_t VERSION = 1;
+		
+		uint32_t				m_magic;
+		uint32_t				m_version;
+		uint32_t				m_capacity;
+		uint32_t				m_entrySize;
+		
+		/**
+		 * Seqlock over everything below and the entries, odd while the exporter writes
+		 */
+		std::atomic<uint64_t>	m_sequence;
+		
+		uint64_t				m_frame;			// Scene frame of the last export
+		uint64_t				m_layoutVersion;	// Changes when entries are taken, freed or change parent
+		uint32_t				m_count;			// Entries ever taken, the free ones among them have id 0
+		uint32_t				m_sceneCount;		// Game objects in the scene, more than m_count when they didn't fit
+	};
+	
+	struct CSharedGameObject
+	{
+		static const unsigned int NAME_SIZE = 32;	// Longer names are cut, always NULL terminated
+		static const uint32_t NO_PARENT = ~0u;
+		
+		uint64_t		m_changedFrame;			// Frame in which the world matrix was last written
+		uint32_t		m_id;					// CGameObject::Id, 0 for a free entry
+		uint32_t		m_parentIndex;			// Entry of the parent, NO_PARENT when it has none or it isn't exported
+		float			m_worldMatrix[16];		// Same element order as math::Matrix4x4f
+		float			m_position[3];			// World position, for readers that don't know that order
+		char			m_name[NAME_SIZE];
+	};
+}
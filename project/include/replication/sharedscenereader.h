@@ -0,0 +1,127 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  sharedscenereader.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "sharedscenelayout.h"
+
+namespace dc
+{
+	/**
+	 * \class CSharedSceneReader
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Maps read only the region of a CSharedSceneExporter, in this or another process.
+	 * Nothing is copied: Read hands out the mapped entries and then checks that the exporter
+	 * didn't write them meanwhile, trying again if it did.
+	 */
+	class CSharedSceneReader
+	{
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const bool			IsOpen() const		{ return mp_header != 0; }
+		const unsigned int	Capacity() const	{ return m_capacity; }
+		
+		/**
+		 * Exports finished so far, there is something new to read when it changes
+		 */
+		const uint64_t		ExportCount() const	{ return mp_header ? mp_header->m_sequence.load(std::memory_order_acquire) / 2 : 0; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CSharedSceneReader();
+		~CSharedSceneReader();
+		
+		CSharedSceneReader(const CSharedSceneReader& copy) = delete;
+		void operator= (const CSharedSceneReader& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * False while the exporter hasn't created the region yet, or if it has another layout
+		 */
+		const bool Open(const char* name);
+		void Close();
+		
+		/**
+		 * Calls function(header, entries, count) with the mapped table. The exporter may write it
+		 * at the same time, so function has to copy what it needs and leave any decision for
+		 * after Read returns true. Attempts finding the exporter in the middle of a write yield
+		 * to it. Returns false if no attempt saw a whole export.
+		 */
+		template<typename Function>
+		const bool Read(Function function, const unsigned int attempts = 4096) const;
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		const CSharedSceneHeader*	mp_header;
+		const CSharedGameObject*	mp_entryList;
+		unsigned int				m_capacity;			// As checked against the mapping size
+		size_t						m_size;
+	};
+	
+	// ===========================================================
+	// Template/Inline implementation
+	// ===========================================================
+	
+	template<typename Function>
+	const bool CSharedSceneReader::Read(Function function, const unsigned int attempts) const
+	{
+		if(!mp_header)
+		{
+			return false;
+		}
+		
+		for(unsigned int attempt = 0; attempt < attempts; ++attempt)
+		{
+			const uint64_t sequence = mp_header->m_sequence.load(std::memory_order_acquire);
+			if(sequence & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			
+			// The count may be torn as well, it must not take the reader out of the mapping
+			const unsigned int count = std::min(mp_header->m_count, m_capacity);
+			function(*mp_header, mp_entryList, count);
+			
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(mp_header->m_sequence.load(std::memory_order_relaxed) == sequence)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
@@ -0,0 +1,210 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  snapshot.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "math/matrix.h"
+
+#include "bytestream.h"
+
+#include "components/gameobject.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	class CScene;
+	
+	/**
+	 * Fixed point steps used to store transforms in snapshots.
+	 * Both ends of a replication stream must use the same values.
+	 */
+	struct CQuantization
+	{
+		float			m_positionStep;		// World units per step
+		float			m_scaleStep;
+		unsigned int	m_rotationBits;		// Bits per quaternion component, sign included
+		
+		CQuantization():
+			m_positionStep(1.0f / 1024.0f),
+			m_scaleStep(1.0f / 1024.0f),
+			m_rotationBits(16)
+		{}
+		
+		const int32_t	QuantizePosition(const float value) const;
+		const float		DequantizePosition(const int32_t value) const	{ return value * m_positionStep; }
+		
+		const int32_t	QuantizeScale(const float value) const;
+		const float		DequantizeScale(const int32_t value) const		{ return value * m_scaleStep; }
+		
+		const int32_t	QuantizeRotation(const float value) const;
+		const float		DequantizeRotation(const int32_t value) const;
+	};
+	
+	/**
+	 * \class CReplicationRegistry
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Component types whose state travels with the snapshots.
+	 * Registration order defines the type ids, so both ends must register the same types in the same order.
+	 */
+	class CReplicationRegistry
+	{
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	public:
+		struct CEntry
+		{
+			const char*												mp_typeName;
+			std::function<void(const CComponent*, CByteWriter&)>	m_write;
+			std::function<void(CComponent*, CByteReader&)>			m_read;
+			std::function<CComponent*(CGameObject*)>				m_create;
+		};
+		
+		using TEntryList = std::vector<CEntry>;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const TEntryList&	Entries() const	{ return m_entryList; }
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		template<typename CT>
+		void Register(void (*write)(const CT&, CByteWriter&), void (*read)(CT&, CByteReader&))
+		{
+			CEntry entry;
+			entry.mp_typeName = CT::TypeName();
+			entry.m_write = [write](const CComponent* component, CByteWriter& writer)
+			{
+				write(*component->DirectCast<CT>(), writer);
+			};
+			entry.m_read = [read](CComponent* component, CByteReader& reader)
+			{
+				read(*component->DirectCast<CT>(), reader);
+			};
+			entry.m_create = [](CGameObject* gameObject) -> CComponent*
+			{
+				return gameObject->AddComponent<CT>();
+			};
+			m_entryList.push_back(entry);
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		TEntryList	m_entryList;
+	};
+	
+	/**
+	 * Serialized state of one registered component
+	 */
+	struct CSnapshotPayload
+	{
+		unsigned int	m_type;		// Index in the replication registry
+		TByteList		m_data;
+		
+		bool operator== (const CSnapshotPayload& other) const { return m_type == other.m_type && m_data == other.m_data; }
+		bool operator!= (const CSnapshotPayload& other) const { return !(*this == other); }
+	};
+	
+	using TSnapshotPayloadList = std::vector<CSnapshotPayload>;
+	
+	/**
+	 * Quantized state of one game object
+	 */
+	struct CSnapshotEntry
+	{
+		uint32_t				m_id;
+		uint32_t				m_parentId;		// 0 for roots
+		std::string				m_name;
+		int32_t					m_position[3];
+		int32_t					m_rotation[4];
+		int32_t					m_scale[3];
+		TSnapshotPayloadList	m_payloadList;
+	};
+	
+	using TSnapshotEntryList = std::vector<CSnapshotEntry>;
+	
+	/**
+	 * \class CSceneSnapshot
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Game object set, hierarchy and local transforms of a scene at one tick, sorted by game object id.
+	 * An empty snapshot (tick 0) is the baseline of a full update.
+	 */
+	class CSceneSnapshot
+	{
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const uint64_t				Tick() const		{ return m_tick; }
+		void						Tick(const uint64_t tick)	{ m_tick = tick; }
+		
+		const TSnapshotEntryList&	Entries() const		{ return m_entryList; }
+		TSnapshotEntryList&			Entries()			{ return m_entryList; }
+		
+		/**
+		 * Binary search by id, NULL when missing
+		 */
+		const CSnapshotEntry*		Find(const uint32_t id) const;
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CSceneSnapshot():
+			m_tick(0)
+		{}
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Capture(const CScene& scene, const CQuantization& quantization, const CReplicationRegistry* registry = 0);
+		
+		void Clear()
+		{
+			m_tick = 0;
+			m_entryList.clear();
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		uint64_t			m_tick;
+		TSnapshotEntryList	m_entryList;
+	};
+}
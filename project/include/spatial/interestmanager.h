@@ -0,0 +1,140 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  interestmanager.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "math/matrix.h"
+
+#include "components/gameobject.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	class CScene;
+	
+	/**
+	 * Interest management configuration. Cells activate when an observer gets within the enter radius
+	 * and deactivate after staying beyond the exit radius of every observer for the exit delay.
+	 */
+	struct CInterestSettings
+	{
+		float			m_cellSize;
+		float			m_enterRadius;
+		float			m_exitRadius;			// Bigger than the enter radius
+		unsigned int	m_exitDelayFrames;
+		bool			m_notifyComponents;		// Call Sleep/Start on the components when their cell changes
+		
+		CInterestSettings():
+			m_cellSize(32.0f),
+			m_enterRadius(128.0f),
+			m_exitRadius(160.0f),
+			m_exitDelayFrames(30),
+			m_notifyComponents(false)
+		{}
+	};
+	
+	/**
+	 * \class CInterestManager
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Splits the scene in cells by root transform position and only keeps active
+	 * the hierarchies in cells near an observer. Children follow their root.
+	 */
+	class CInterestManager
+	{
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	private:
+		struct CCell
+		{
+			math::Vector3f	m_center;
+			TGOList			m_rootList;
+			bool			m_active;
+			unsigned int	m_outsideFrames;
+		};
+		
+		struct CObserver
+		{
+			math::Vector3f	m_position;
+			bool			m_used;
+		};
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const CInterestSettings&	Settings() const	{ return m_settings; }
+		
+		const unsigned int			CellCount() const	{ return m_cellTable.size(); }
+		const unsigned int			ActiveCellCount() const;
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CInterestManager(const CInterestSettings& settings);
+		
+		CInterestManager(const CInterestManager& copy) = delete;
+		void operator= (const CInterestManager& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		const unsigned int AddObserver(const math::Vector3f& position);
+		void MoveObserver(const unsigned int observerId, const math::Vector3f& position);
+		void RemoveObserver(const unsigned int observerId);
+		
+		/**
+		 * Places the hierarchies whose transforms changed since sinceTick and updates cell activation
+		 */
+		void Update(CScene& scene, const uint64_t sinceTick);
+		
+		void Remove(CGameObject* gameObject);
+		
+	private:
+		void Place(CGameObject* root);
+		void Unplace(CGameObject* root);
+		
+		void Activate(CCell& cell, const bool active);
+		void Activate(CGameObject* root, const bool active);
+		
+		const float NearestObserverDistance(const math::Vector3f& position) const;
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		CInterestSettings								m_settings;
+		
+		std::unordered_map<uint64_t, CCell>				m_cellTable;
+		std::unordered_map<const CGameObject*, uint64_t>	m_rootCellTable;
+		std::vector<CObserver>							m_observerList;
+	};
+}
@@ -0,0 +1,155 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  spatialgrid.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "math/matrix.h"
+
+#include "components/gameobject.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	using TPointList = std::vector<math::Vector3f>;
+	
+	/**
+	 * Hash key of a grid cell, 21 bits per axis. Cells wrap around every two million cells which is fine for a hash.
+	 */
+	inline uint64_t GridCellKey(const int32_t x, const int32_t y, const int32_t z)
+	{
+		const uint64_t mask = (uint64_t(1) << 21) - 1;
+		return ((uint64_t(x) & mask) << 42) | ((uint64_t(y) & mask) << 21) | (uint64_t(z) & mask);
+	}
+	
+	/**
+	 * \class CSpatialGrid
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Uniform hash grid of game object world positions. Insert, move and remove are O(1),
+	 * queries only look at the cells overlapping the searched volume.
+	 */
+	class CSpatialGrid
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	private:
+		using TIndexList = std::vector<unsigned int>;
+		
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	private:
+		struct CCell
+		{
+			int32_t x, y, z;
+		};
+		
+		struct CEntry
+		{
+			CGameObject*	mp_gameObject;
+			math::Vector3f	m_position;
+			uint64_t		m_cellKey;
+			unsigned int	m_cellSlot;		// Position in its cell index list
+		};
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const float			CellSize() const	{ return m_cellSize; }
+		const unsigned int	Size() const		{ return m_entryList.size(); }
+		const bool			Contains(const CGameObject* gameObject) const { return m_indexTable.count(gameObject) != 0; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CSpatialGrid(const float cellSize);
+		
+		CSpatialGrid(const CSpatialGrid& copy) = delete;
+		void operator= (const CSpatialGrid& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Inserts the game object or moves it if it's already indexed
+		 */
+		void Update(CGameObject* gameObject, const math::Vector3f& position);
+		void Remove(CGameObject* gameObject);
+		void Clear();
+		
+		/**
+		 * Game objects within radius of center, appended to result
+		 */
+		void QueryRadius(const math::Vector3f& center, const float radius, TGOList& result) const;
+		
+		/**
+		 * Game objects inside the axis aligned box, appended to result
+		 */
+		void QueryBox(const math::Vector3f& min, const math::Vector3f& max, TGOList& result) const;
+		
+		/**
+		 * Up to k game objects closest to point, nearest first, appended to result
+		 */
+		void QueryNearest(const math::Vector3f& point, const unsigned int k, TGOList& result) const;
+		
+		/**
+		 * Radius query for many points at once. Points falling in the same cell share
+		 * the candidate gathering, results[i] receives the game objects around centers[i].
+		 */
+		void QueryRadius(const TPointList& centers, const float radius, std::vector<TGOList>& results) const;
+		
+	private:
+		CCell		CellOf(const math::Vector3f& position) const;
+		uint64_t	CellKey(const CCell& cell) const;
+		
+		const TIndexList*	Cell(const int32_t x, const int32_t y, const int32_t z) const;
+		
+		void GatherBox(const CCell& minCell, const CCell& maxCell, TIndexList& candidates) const;
+		
+		void AddToCell(const unsigned int index);
+		void RemoveFromCell(const unsigned int index);
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		float			m_cellSize;
+		float			m_inverseCellSize;
+		
+		std::vector<CEntry>									m_entryList;
+		std::unordered_map<const CGameObject*, unsigned int>	m_indexTable;
+		std::unordered_map<uint64_t, TIndexList>			m_cellTable;
+		
+		CCell			m_minCell;		// Bounds of every cell ever used, limits the nearest search
+		CCell			m_maxCell;
+	};
+}
@@ -0,0 +1,178 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  threadpool.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	using TJob = std::function<void()>;
+	
+	class CThreadPool;
+	
+	/**
+	 * Jobs submitted with a counter and not finished yet
+	 */
+	class CJobCounter
+	{
+		friend class CThreadPool;
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const bool			Done() const	{ return m_pending.load(std::memory_order_acquire) == 0; }
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CJobCounter():
+			m_pending(0)
+		{}
+		
+		CJobCounter(const CJobCounter& copy) = delete;
+		void operator= (const CJobCounter& copy) = delete;
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::atomic<unsigned int>	m_pending;
+	};
+	
+	/**
+	 * \class CThreadPool
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Worker threads, each with its own job queue. Jobs pinned to a worker stay on it so the
+	 * data they touch stays in its caches, the rest go round robin. Idle workers steal the
+	 * unpinned jobs of others, and pinned ones only from workers busy with something else.
+	 */
+	class CThreadPool
+	{
+		// ===========================================================
+		// Constant / Enums / Typedefs internal usage
+		// ===========================================================
+	public:
+		static const int ANY_WORKER = -1;
+		
+		// ===========================================================
+		// Inner and Anonymous Classes
+		// ===========================================================
+	private:
+		struct CJob
+		{
+			TJob			m_function;
+			CJobCounter*	mp_counter;
+			bool			m_pinned;
+		};
+		
+		/**
+		 * Allocated one by one, C++11 new ignores alignas, so the padding keeps
+		 * the next worker off this one's cache line
+		 */
+		struct CWorker
+		{
+			std::mutex			m_mutex;
+			std::deque<CJob>	m_jobList;
+			std::atomic<bool>	m_busy;
+			std::thread			m_thread;
+			char				m_padding[64];
+		};
+		
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int	WorkerCount() const	{ return m_workerList.size(); }
+		
+		/**
+		 * Index of the worker running the calling thread, ANY_WORKER outside this pool,
+		 * which includes the workers of any other pool
+		 */
+		const int			CurrentWorker() const;
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		/**
+		 * Zero workers means one per hardware thread
+		 */
+		CThreadPool(const unsigned int workerCount = 0);
+		
+		/**
+		 * Runs whatever is still queued before joining the workers
+		 */
+		~CThreadPool();
+		
+		CThreadPool(const CThreadPool& copy) = delete;
+		void operator= (const CThreadPool& copy) = delete;
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		/**
+		 * Queues the job. The counter, if any, counts it until it's finished.
+		 * Pinned jobs go to worker % WorkerCount().
+		 */
+		void Submit(const TJob& job, CJobCounter* counter = 0, const int worker = ANY_WORKER);
+		
+		/**
+		 * Blocks until the counter is done, running queued jobs in the meantime
+		 */
+		void Wait(CJobCounter& counter);
+		
+	private:
+		void Run(const unsigned int index);
+		
+		const bool TakeJob(const int self, CJob& job);
+		void Execute(CJob& job);
+		void Wake();
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::vector<std::unique_ptr<CWorker>>	m_workerList;
+		std::atomic<unsigned int>	m_nextWorker;
+		
+		std::mutex					m_sleepMutex;
+		std::condition_variable		m_wakeCondition;
+		uint64_t					m_epoch;			// Changes with every new job or finished counter, guarded by m_sleepMutex
+		bool						m_stop;
+	};
+}
@@ -0,0 +1,121 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  vector3array.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <vector>
+
+#include "math/matrix.h"
+
+namespace dc
+{
+	// ===========================================================
+	// External Enums / Typedefs for global usage
+	// ===========================================================
+	
+	/**
+	 * \class CVector3Array
+	 * \brief
+	 * \author Jorge López González
+	 *
+	 * Array of 3D vectors stored as structure of arrays, one array per coordinate,
+	 * so batched operations can process several vectors with each instruction.
+	 */
+	class CVector3Array
+	{
+		// ===========================================================
+		// Getter & Setter
+		// ===========================================================
+	public:
+		const unsigned int	Size() const	{ return m_x.size(); }
+		const bool			Empty() const	{ return m_x.empty(); }
+		
+		float*				X()			{ return m_x.data(); }
+		float*				Y()			{ return m_y.data(); }
+		float*				Z()			{ return m_z.data(); }
+		
+		const float*		X() const	{ return m_x.data(); }
+		const float*		Y() const	{ return m_y.data(); }
+		const float*		Z() const	{ return m_z.data(); }
+		
+		math::Vector3f		Get(const unsigned int index) const
+		{
+			return math::Vector3f(m_x[index], m_y[index], m_z[index]);
+		}
+		
+		void				Set(const unsigned int index, const math::Vector3f& vector)
+		{
+			m_x[index] = vector.x;
+			m_y[index] = vector.y;
+			m_z[index] = vector.z;
+		}
+		
+		// ===========================================================
+		// Constructors
+		// ===========================================================
+	public:
+		CVector3Array() {}
+		CVector3Array(const unsigned int size):
+			m_x(size),
+			m_y(size),
+			m_z(size)
+		{}
+		
+		// ===========================================================
+		// Methods
+		// ===========================================================
+	public:
+		void Resize(const unsigned int size)
+		{
+			m_x.resize(size);
+			m_y.resize(size);
+			m_z.resize(size);
+		}
+		
+		void Reserve(const unsigned int size)
+		{
+			m_x.reserve(size);
+			m_y.reserve(size);
+			m_z.reserve(size);
+		}
+		
+		void Push(const math::Vector3f& vector)
+		{
+			m_x.push_back(vector.x);
+			m_y.push_back(vector.y);
+			m_z.push_back(vector.z);
+		}
+		
+		void Clear()
+		{
+			m_x.clear();
+			m_y.clear();
+			m_z.clear();
+		}
+		
+		// ===========================================================
+		// Fields
+		// ===========================================================
+	private:
+		std::vector<float>	m_x;
+		std::vector<float>	m_y;
+		std::vector<float>	m_z;
+	};
+}
@@ -0,0 +1,97 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "destructionqueue.h"
+
+#include <cassert>
+#include <chrono>
+
+#include "transform.h"
+
+#include "debug/profiler.h"
+
+namespace dc
+{
+	CDestructionQueue::~CDestructionQueue()
+	{
+		Flush();
+	}
+	
+	void CDestructionQueue::Enqueue(CGameObject* root)
+	{
+		assert(root && "[CDestructionQueue::Enqueue] game object can't be NULL");
+		assert(!root->Scene() && "[CDestructionQueue::Enqueue] The game object is still in a scene");
+		
+		// Reversed pre-order puts every game object before its ancestors
+		TGOList hierarchyList;
+		TGOList pendingList(1, root);
+		while(!pendingList.empty())
+		{
+			CGameObject* gameObject = pendingList.back();
+			pendingList.pop_back();
+			hierarchyList.push_back(gameObject);
+			
+			CTransform* transform = gameObject->Transform();
+			for(auto it = transform->Begin(), end = transform->End(); it != end; ++it)
+			{
+				pendingList.push_back((*it)->GameObject());
+			}
+		}
+		
+		m_pendingList.insert(m_pendingList.end(), hierarchyList.rbegin(), hierarchyList.rend());
+	}
+	
+	const unsigned int CDestructionQueue::Process()
+	{
+		if(m_pendingList.empty())
+		{
+			return 0;
+		}
+		
+		DC_PROFILE_SCOPE("CDestructionQueue::Process");
+		
+		using TClock = std::chrono::steady_clock;
+		const TClock::time_point deadline = TClock::now() + std::chrono::microseconds(m_budget.m_maxMicroseconds);
+		
+		// The clock is only checked every few deletions
+		const unsigned int CLOCK_CHECK_INTERVAL = 16;
+		
+		unsigned int destroyed = 0;
+		while(!m_pendingList.empty())
+		{
+			if(m_budget.m_maxGameObjects && destroyed >= m_budget.m_maxGameObjects)
+			{
+				break;
+			}
+			
+			if(m_budget.m_maxMicroseconds && destroyed % CLOCK_CHECK_INTERVAL == 0 && destroyed && TClock::now() >= deadline)
+			{
+				break;
+			}
+			
+			delete m_pendingList.front();
+			m_pendingList.pop_front();
+			++destroyed;
+		}
+		
+		return destroyed;
+	}
+	
+	void CDestructionQueue::Flush()
+	{
+		for(CGameObject* gameObject : m_pendingList)
+		{
+			delete gameObject;
+		}
+		m_pendingList.clear();
+	}
+}
@@ -0,0 +1,202 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "eventbus.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+namespace dc
+{
+	namespace
+	{
+		std::mutex					s_threadSlotMutex;
+		std::vector<unsigned int>	s_freeThreadSlotList;
+		unsigned int				s_nextThreadSlot = 0;
+		
+		/**
+		 * Going past the fixed tables would write out of bounds, so this stops release builds too
+		 */
+		void LimitExceeded(const char* message)
+		{
+			std::fprintf(stderr, "%s\n", message);
+			std::abort();
+		}
+		
+		/**
+		 * Holds the slot of a thread while it lives. Two live threads never share a slot,
+		 * that's what lets them publish without locking.
+		 */
+		struct CThreadSlotLease
+		{
+			unsigned int m_slot;
+			
+			CThreadSlotLease()
+			{
+				std::lock_guard<std::mutex> lock(s_threadSlotMutex);
+				if(s_freeThreadSlotList.empty())
+				{
+					m_slot = s_nextThreadSlot++;
+				}
+				else
+				{
+					m_slot = s_freeThreadSlotList.back();
+					s_freeThreadSlotList.pop_back();
+				}
+				if(m_slot >= CEventBus::MAX_THREAD_SLOTS)
+				{
+					LimitExceeded("[CEventBus::AcquireThreadSlot] Too many threads publishing events, raise MAX_THREAD_SLOTS");
+				}
+			}
+			
+			~CThreadSlotLease()
+			{
+				std::lock_guard<std::mutex> lock(s_threadSlotMutex);
+				s_freeThreadSlotList.push_back(m_slot);
+			}
+		};
+	}
+	
+	const unsigned int CEventBus::TYPE_BITS;
+	const unsigned int CEventBus::MAX_EVENT_TYPES;
+	const unsigned int CEventBus::MAX_THREAD_SLOTS;
+	const unsigned int CEventBus::PHASE_COUNT;
+	
+	// ===========================================================
+	// Static fields / methods
+	// ===========================================================
+	
+	const unsigned int CEventBus::NextTypeIndex()
+	{
+		static std::atomic<unsigned int> s_nextTypeIndex(0);
+		const unsigned int index = s_nextTypeIndex.fetch_add(1, std::memory_order_relaxed);
+		if(index >= MAX_EVENT_TYPES)
+		{
+			LimitExceeded("[CEventBus::NextTypeIndex] Too many event types, raise TYPE_BITS");
+		}
+		return index;
+	}
+	
+	const unsigned int CEventBus::AcquireThreadSlot()
+	{
+		static thread_local CThreadSlotLease tp_lease;
+		return tp_lease.m_slot;
+	}
+	
+	// ===========================================================
+	// Getter & Setter
+	// ===========================================================
+	
+	const unsigned int CEventBus::Pending() const
+	{
+		unsigned int pending = 0;
+		for(auto& slot : m_channelList)
+		{
+			const CChannelBase* channel = slot.load(std::memory_order_acquire);
+			if(channel)
+			{
+				pending += channel->Pending();
+			}
+		}
+		return pending;
+	}
+	
+	// ===========================================================
+	// Constructors
+	// ===========================================================
+	
+	CEventBus::CEventBus():
+		m_dispatching(false),
+		m_nextSubscriberId(1)
+	{
+		for(auto& channel : m_channelList)
+		{
+			channel.store(0, std::memory_order_relaxed);
+		}
+	}
+	
+	CEventBus::~CEventBus()
+	{
+		for(auto& channel : m_channelList)
+		{
+			delete channel.load(std::memory_order_relaxed);
+		}
+	}
+	
+	// ===========================================================
+	// Methods
+	// ===========================================================
+	
+	CEventBus::CChannelBase* CEventBus::CreateChannel(const unsigned int index, CChannelBase* (*factory)(const bool& dispatching))
+	{
+		// Two threads may race to create it, the loser deletes its copy
+		CChannelBase* channel = 0;
+		CChannelBase* created = factory(m_dispatching);
+		if(m_channelList[index].compare_exchange_strong(channel, created, std::memory_order_acq_rel))
+		{
+			return created;
+		}
+		delete created;
+		return channel;
+	}
+	
+	void CEventBus::Unsubscribe(const uint64_t id)
+	{
+		CChannelBase* channel = m_channelList[id & (MAX_EVENT_TYPES - 1)].load(std::memory_order_acquire);
+		if(!channel || !channel->Unsubscribe(id))
+		{
+			assert(false && "[CEventBus::Unsubscribe] Unknown subscriber");
+		}
+	}
+	
+	void CEventBus::Dispatch(const EEventPhase phase)
+	{
+		assert(!m_dispatching && "[CEventBus::Dispatch] Already dispatching");
+		assert(phase != EEventPhase::Count && "[CEventBus::Dispatch] Count isn't a phase");
+		
+		m_dispatching = true;
+		for(auto& slot : m_channelList)
+		{
+			CChannelBase* channel = slot.load(std::memory_order_acquire);
+			if(channel)
+			{
+				channel->Dispatch((unsigned int)phase);
+			}
+		}
+		m_dispatching = false;
+		
+		for(auto& slot : m_channelList)
+		{
+			CChannelBase* channel = slot.load(std::memory_order_acquire);
+			if(channel)
+			{
+				channel->EndDispatch();
+			}
+		}
+	}
+	
+	void CEventBus::Recycle()
+	{
+		assert(!m_dispatching && "[CEventBus::Recycle] Can't recycle while dispatching");
+		
+		for(auto& slot : m_channelList)
+		{
+			CChannelBase* channel = slot.load(std::memory_order_acquire);
+			if(channel)
+			{
+				channel->Recycle();
+			}
+		}
+	}
+}
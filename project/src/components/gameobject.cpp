@@ -12,30 +12,144 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include "gameobject.h"
 
+#include <atomic>
 #include <cassert>
 
-#include "help/deletehelp.h"
+#include "scene.h"
 
-#include "transform.h"
+#include "debug/profiler.h"
+#include "managers/gameobjectmanager.h"
+#include "replication/scenerecorder.h"
 
 namespace dc
 {
+	namespace
+	{
+		const unsigned int NextId()
+		{
+			static std::atomic<unsigned int> s_nextId(1);
+			return s_nextId.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	
 	CGameObject::CGameObject():
-		mp_name("GameObject")
+		m_id(NextId()),
+		mp_name("GameObject"),
+		mp_scene(0),
+		mp_manager(0),
+		m_handle(0),
+		m_active(true),
+		m_removal(ESceneRemoval::None)
 	{
-		mp_transform = AddComponent<CTransform>();
+		CStats::Instance().Constructed(EStatsSubsystem::GameObject);
+		CStats::Instance().Allocated(EStatsSubsystem::GameObject, sizeof(CGameObject));
+		AddComponent(&m_transform);
 	}
 	
 	CGameObject::CGameObject(const char* name):
-		mp_name(name)
+		m_id(NextId()),
+		mp_name(name),
+		mp_scene(0),
+		mp_manager(0),
+		m_handle(0),
+		m_active(true),
+		m_removal(ESceneRemoval::None)
+	{
+		CStats::Instance().Constructed(EStatsSubsystem::GameObject);
+		CStats::Instance().Allocated(EStatsSubsystem::GameObject, sizeof(CGameObject));
+		AddComponent(&m_transform);
+	}
+	
+	CGameObject::CGameObject(const CGameObject& original, CGameObject* parent):
+		m_id(NextId()),
+		mp_name(original.mp_name),
+		mp_scene(0),
+		mp_manager(0),
+		m_handle(0),
+		m_active(true),
+		m_removal(ESceneRemoval::None)
 	{
-		mp_transform = AddComponent<CTransform>();
+		CStats::Instance().Constructed(EStatsSubsystem::GameObject);
+		AddComponent(&m_transform);
+		m_transform.CloneFrom(original.m_transform, parent ? &parent->m_transform : 0, original.m_transform.ChildCount());
 	}
 	
 	CGameObject::~CGameObject()
 	{
-		mp_transform = 0;
-		SafeDelete(m_componentTable);
+		// The transform is a member, it goes away with the game object
+		for(CComponent* component : m_components)
+		{
+			if(component != &m_transform)
+			{
+				delete component;
+			}
+		}
+		
+		if(mp_manager)
+		{
+			mp_manager->Unregister(this);
+		}
+		CStats::Instance().Destroyed(EStatsSubsystem::GameObject);
+	}
+	
+	CGameObject* CGameObject::Instantiate(const CGameObject* original)
+	{
+		assert(original && "[CGameObject::Instantiate] The original game object can't be NULL");
+		
+		DC_PROFILE_SCOPE("CGameObject::Instantiate");
+		
+		// Pre-order, so every parent is cloned before its children
+		TGOList originalList;
+		std::vector<int> parentIndexList;
+		
+		originalList.push_back(const_cast<CGameObject*>(original));
+		parentIndexList.push_back(-1);
+		for(unsigned int i = 0; i < originalList.size(); ++i)
+		{
+			CTransform* transform = originalList[i]->Transform();
+			for(auto it = transform->Begin(), end = transform->End(); it != end; ++it)
+			{
+				originalList.push_back((*it)->GameObject());
+				parentIndexList.push_back(i);
+			}
+		}
+		
+		CGameObjectBlock* block = CGameObjectBlock::Create(originalList.size());
+		TGOList cloneList(originalList.size());
+		
+		for(unsigned int i = 0; i < originalList.size(); ++i)
+		{
+			const CGameObject* source = originalList[i];
+			CGameObject* parent = parentIndexList[i] < 0 ? 0 : cloneList[parentIndexList[i]];
+			
+			CGameObject* clone = new (block->Slot(i)) CGameObject(*source, parent);
+			cloneList[i] = clone;
+			
+			for(const CComponent* component : source->m_components)
+			{
+				if(component == &source->m_transform)
+				{
+					continue;
+				}
+				
+				CComponent* componentClone = component->Clone();
+				if(componentClone)
+				{
+					clone->AddComponent(componentClone);
+				}
+			}
+		}
+		
+		// Clones belong to the manager of the original
+		if(original->mp_manager)
+		{
+			for(CGameObject* clone : cloneList)
+			{
+				original->mp_manager->Register(clone);
+			}
+		}
+		
+		return cloneList.front();
 	}
 	
 	const bool CGameObject::HasChild(const char* name) const
@@ -45,14 +159,22 @@ namespace dc
 	
 	const unsigned int CGameObject::ComponentsNum(const char* compId) const
 	{
-		return GetComponents(compId).size();
+		return m_components.Count(compId);
 	}
 	
-	const TComponentList& CGameObject::GetComponents(const char* compId) const
+	CSceneRecorder* CGameObject::Recorder() const
 	{
-		const auto& componentsEntryIt = m_componentTable.find(compId);
-		assert(componentsEntryIt != m_componentTable.end() && "[CGameObject::GetComponents] You shouldn't be asking for Components that doesn't exist");
-		return componentsEntryIt->second;
+		return mp_scene ? mp_scene->Recorder() : 0;
+	}
+	
+	void CGameObject::Active(const bool active)
+	{
+		CSceneRecorder* recorder = Recorder();
+		if(recorder && active != m_active)
+		{
+			recorder->Active(this, active);
+		}
+		m_active = active;
 	}
 	
 	CComponent* CGameObject::AddComponent(CComponent* component)
@@ -60,36 +182,50 @@ namespace dc
 		assert(component && "[CGameObject::GetComponents] Component is NULL");
 		
 		component->GameObject(this);
-		TComponentList& componentList = m_componentTable[component->InstanceName()];
+		m_components.Add(component);
+		
+		CSceneRecorder* recorder = Recorder();
+		if(recorder)
+		{
+			recorder->AddComponent(this, component->InstanceName());
+		}
 		
-		componentList.push_back(component);
+		if(mp_scene)
+		{
+			mp_scene->AddComponent(component);
+		}
 		return component;
 	}
 	
 	void CGameObject::RemoveComponent(const char* name)
 	{
-		TComponentListTable::iterator componentsEntryIt = m_componentTable.find(name);
-		if(componentsEntryIt != m_componentTable.end())
+		assert(name != CTransform::TypeName() && "[CGameObject::RemoveComponent] The transform can't be removed");
+		
+		CComponent* component = m_components.Find(name);
+		if(component)
 		{
-			TComponentList& componentList = componentsEntryIt->second;
-			
-			CComponent* component = componentList.front();
-			componentList.erase(std::find(componentList.begin(), componentList.end(), component));
+			CSceneRecorder* recorder = Recorder();
+			if(recorder)
+			{
+				recorder->RemoveComponent(this, name);
+			}
 			
-			if(componentList.empty())
+			// In a scene it still has to sleep and finish, the scene deletes it afterwards
+			if(mp_scene)
 			{
-				m_componentTable.erase(componentsEntryIt);
+				mp_scene->RemoveComponent(component);
+				m_components.Remove(component);
+				return;
 			}
 			
+			m_components.Remove(component);
 			delete component;
 		}
 	}
 	
 	CGameObject* CGameObject::FindChild(const char* name) const
 	{
-		assert(mp_transform && "[CGameObject::FindChild] The game object has no transform component");
-		
-		TTransformList childrenTransList = mp_transform->Children();
+		TTransformList childrenTransList = m_transform.Children();
 		for(auto* childTrans : childrenTransList)
 		{
 			auto* childGO = childTrans->GameObject();
@@ -0,0 +1,103 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "gameobjectblock.h"
+
+#include <cassert>
+#include <new>
+
+#include "gameobject.h"
+
+namespace dc
+{
+	namespace
+	{
+		const std::size_t ALIGNMENT = alignof(std::max_align_t);
+		
+		const std::size_t Align(const std::size_t size)
+		{
+			return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		}
+		
+		// Every allocation is preceded by the block it belongs to, or NULL when it's on its own
+		const std::size_t HEADER_SIZE = Align(sizeof(CGameObjectBlock*));
+		const std::size_t SLOT_SIZE = HEADER_SIZE + Align(sizeof(CGameObject));
+		
+		CGameObjectBlock*& Header(char* memory)
+		{
+			return *reinterpret_cast<CGameObjectBlock**>(memory);
+		}
+	}
+	
+	void* CGameObjectBlock::Allocate(const std::size_t size)
+	{
+		char* memory = static_cast<char*>(::operator new(HEADER_SIZE + size));
+		Header(memory) = 0;
+		return memory + HEADER_SIZE;
+	}
+	
+	void CGameObjectBlock::Deallocate(void* pointer)
+	{
+		if(!pointer)
+		{
+			return;
+		}
+		
+		char* memory = static_cast<char*>(pointer) - HEADER_SIZE;
+		CGameObjectBlock* block = Header(memory);
+		if(block)
+		{
+			block->Release();
+		}
+		else
+		{
+			::operator delete(memory);
+		}
+	}
+	
+	CGameObjectBlock* CGameObjectBlock::Create(const unsigned int count)
+	{
+		assert(count > 0 && "[CGameObjectBlock::Create] The block can't be empty");
+		
+		const std::size_t bytes = Align(sizeof(CGameObjectBlock)) + count * SLOT_SIZE;
+		CGameObjectBlock* block = new (::operator new(bytes)) CGameObjectBlock(count);
+		
+		char* slots = block->Slots();
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			Header(slots + i * SLOT_SIZE) = block;
+		}
+		
+		CStats::Instance().Allocated(EStatsSubsystem::GameObject, bytes);
+		return block;
+	}
+	
+	void* CGameObjectBlock::Slot(const unsigned int index)
+	{
+		assert(index < m_count && "[CGameObjectBlock::Slot] Index out of range");
+		return Slots() + index * SLOT_SIZE + HEADER_SIZE;
+	}
+	
+	char* CGameObjectBlock::Slots()
+	{
+		return reinterpret_cast<char*>(this) + Align(sizeof(CGameObjectBlock));
+	}
+	
+	void CGameObjectBlock::Release()
+	{
+		if(m_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			this->~CGameObjectBlock();
+			::operator delete(this);
+		}
+	}
+}
@@ -0,0 +1,153 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "lifecyclebatch.h"
+
+#include <cassert>
+
+#include "transform.h"
+
+#include "debug/profiler.h"
+
+namespace dc
+{
+	void CLifecycleBatch::Clear()
+	{
+		m_goList.clear();
+		m_componentList.clear();
+		m_typeRangeList.clear();
+		m_typeTable.clear();
+		m_unsortedList.clear();
+		m_typeIndexList.clear();
+	}
+	
+	void CLifecycleBatch::AddHierarchy(CGameObject* root)
+	{
+		AddHierarchy(root, [](const CGameObject*) { return true; });
+	}
+	
+	void CLifecycleBatch::Add(const TGOList& gameObjectList)
+	{
+		for(CGameObject* gameObject : gameObjectList)
+		{
+			Add(gameObject);
+		}
+	}
+	
+	void CLifecycleBatch::Add(CGameObject* gameObject)
+	{
+		m_goList.push_back(gameObject);
+		
+		// Components are counted by type as they come, m_end holds the count until they are grouped.
+		// Only the type names next to the slots are read, the components aren't touched.
+		const CComponentSlots& components = gameObject->Components();
+		for(unsigned int i = 0; i < components.Size(); ++i)
+		{
+			const unsigned int typeIndex = TypeIndex(components.Name(i));
+			++m_typeRangeList[typeIndex].m_end;
+			m_typeIndexList.push_back(typeIndex);
+			m_unsortedList.push_back(components[i]);
+		}
+	}
+	
+	void CLifecycleBatch::Add(CComponent* component)
+	{
+		const unsigned int typeIndex = TypeIndex(component->InstanceName());
+		++m_typeRangeList[typeIndex].m_end;
+		m_typeIndexList.push_back(typeIndex);
+		m_unsortedList.push_back(component);
+	}
+	
+	void CLifecycleBatch::GroupByType()
+	{
+		assert(m_componentList.empty() && "[CLifecycleBatch::GroupByType] The batch is already grouped");
+		
+		unsigned int begin = 0;
+		for(CTypeRange& range : m_typeRangeList)
+		{
+			const unsigned int count = range.m_end;
+			range.m_begin = begin;
+			range.m_end = begin;
+			begin += count;
+		}
+		
+		// Every component goes to the end of its range, which leaves the ranges complete
+		m_componentList.resize(begin);
+		for(unsigned int i = 0; i < m_unsortedList.size(); ++i)
+		{
+			m_componentList[m_typeRangeList[m_typeIndexList[i]].m_end++] = m_unsortedList[i];
+		}
+	}
+	
+	const unsigned int CLifecycleBatch::LookupType(const char* name)
+	{
+		// The linear search in TypeIndex missed. A few types are quicker to go through than to hash.
+		if(m_typeTable.empty())
+		{
+			if(m_typeRangeList.size() < LINEAR_TYPES)
+			{
+				m_typeRangeList.push_back(CTypeRange { name, 0, 0 });
+				return m_typeRangeList.size() - 1;
+			}
+			
+			for(unsigned int i = 0; i < m_typeRangeList.size(); ++i)
+			{
+				m_typeTable.emplace(m_typeRangeList[i].mp_name, i);
+			}
+		}
+		
+		auto typeEntryIt = m_typeTable.find(name);
+		if(typeEntryIt == m_typeTable.end())
+		{
+			typeEntryIt = m_typeTable.emplace(name, m_typeRangeList.size()).first;
+			m_typeRangeList.push_back(CTypeRange { name, 0, 0 });
+		}
+		return typeEntryIt->second;
+	}
+	
+	void CLifecycleBatch::Dispatch(TLifecyclePhase phase, const char* phaseName) const
+	{
+		for(const CTypeRange& range : m_typeRangeList)
+		{
+			Dispatch(range, phase, phaseName);
+		}
+	}
+	
+	void CLifecycleBatch::Dispatch(const CTypeRange& range, TLifecyclePhase phase, const char* phaseName) const
+	{
+		DC_PROFILE_SCOPE_CAT(range.mp_name, phaseName);
+		(void)phaseName;
+		
+		for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+		{
+			(m_componentList[i]->*phase)();
+		}
+	}
+	
+	CLifecycleBatch& CLifecycleBatchPool::Acquire()
+	{
+		if(m_depth == m_batchList.size())
+		{
+			m_batchList.emplace_back(new CLifecycleBatch());
+		}
+		
+		CLifecycleBatch& batch = *m_batchList[m_depth++];
+		batch.Clear();
+		return batch;
+	}
+	
+	void CLifecycleBatchPool::Release()
+	{
+		assert(m_depth > 0 && "[CLifecycleBatchPool::Release] There is no batch to release");
+		--m_depth;
+	}
+}
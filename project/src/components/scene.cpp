@@ -12,13 +12,21 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include "scene.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <functional>
 
 #include "transform.h"
 
+#include "debug/profiler.h"
+
 #include "help/deletehelp.h"
 #include "help/vectorhelp.h"
 
+#include "replication/scenerecorder.h"
+#include "replication/sharedsceneexporter.h"
+
 namespace dc
 {
 	const bool CScene::Exists(const CGameObject* gameObject)
@@ -29,50 +37,472 @@ namespace dc
 		return it != end;
 	}
 
+	namespace
+	{
+		uint64_t NowNs()
+		{
+			using namespace std::chrono;
+			return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+		}
+		
+		template<typename T>
+		void TrackGrowth(const std::vector<T>& list, const size_t previousCapacity)
+		{
+			if(list.capacity() != previousCapacity)
+			{
+				CStats::Instance().Allocated(EStatsSubsystem::Scene, list.capacity() * sizeof(T));
+			}
+		}
+	}
+	
+	CStatsSnapshot CScene::Stats() const
+	{
+		CStatsSnapshot snapshot;
+		snapshot.mp_name = mp_name;
+		snapshot.m_frame = m_frame;
+		snapshot.m_gameObjects = m_goList.size();
+		snapshot.m_pendingNew = m_newGOList.size();
+		snapshot.m_pendingOld = m_oldGOList.size();
+		
+		snapshot.m_componentsPerType.reserve(m_componentsMap.size());
+		for(const auto& componentListEntry : m_componentsMap)
+		{
+			snapshot.m_componentsPerType.emplace_back(componentListEntry.first, componentListEntry.second.size());
+		}
+		
+		snapshot.CaptureGlobals();
+		snapshot.m_transformUpdatesLastFrame = m_transformUpdatesLastFrame;
+		snapshot.m_frameTimeBuckets = m_frameTimes.Buckets();
+		return snapshot;
+	}
+	
+	void CScene::StatsReport(std::ostream* output, const unsigned int frameInterval, const EStatsFormat format)
+	{
+		mp_statsOutput = output;
+		m_statsInterval = frameInterval;
+		m_statsFormat = format;
+	}
+	
+	void CScene::Record(CSceneRecorder* recorder)
+	{
+		mp_recorder = recorder;
+		if(mp_recorder)
+		{
+			mp_recorder->Begin(*this);
+		}
+	}
+	
 	CScene::~CScene()
 	{
+		// No awake may be running on what is about to be deleted
+		while(!m_awakingMap.empty())
+		{
+			FinishAwake(m_awakingMap.begin()->first);
+		}
+		
+		// Components taken out of their game objects belong to the scene until the update finishes
+		SafeDelete(m_oldComponentList);
+		
+		// Game objects waiting to be removed are still in one of the other lists
 		SafeDelete(m_goList);
 		SafeDelete(m_newGOList);
-		SafeDelete(m_oldGOList);
 	}
 	
 	void CScene::PrepareUpdate()
 	{
+		DC_PROFILE_SCOPE("CScene::PrepareUpdate");
+		
+		if(!m_newComponentList.empty())
+		{
+			StartNewComponents();
+		}
+		
 		if(m_newGOList.size() == 0)
 			return;
 		
-		for(CGameObject* gameObject : m_newGOList)
+		// Game objects added from Start wait for the next update
+		CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+		if(m_awakingMap.empty())
+		{
+			batch.Add(m_newGOList);
+			m_newGOList.clear();
+		}
+		else
 		{
-			AddToScene(gameObject);
+			TakeAwakeGameObjects(batch);
+			if(batch.GameObjects().empty())
+			{
+				m_lifecycleBatchPool.Release();
+				return;
+			}
 		}
-		m_newGOList.clear();
+		
+		const size_t previousCapacity = m_goList.capacity();
+		m_goList.insert(m_goList.end(), batch.GameObjects().begin(), batch.GameObjects().end());
+		TrackGrowth(m_goList, previousCapacity);
+		++m_goListVersion;
+		
+		// The Game Objects are finally added into the scene, we call Start
+		batch.GroupByType();
+		for(const CTypeRange& range : batch.TypeRanges())
+		{
+			AddComponents(batch, range);
+			batch.Dispatch(range, &CComponent::Start, "Start");
+		}
+		
+		m_lifecycleBatchPool.Release();
+	}
+	
+	void CScene::StartNewComponents()
+	{
+		// Components of game objects leaving the scene don't start, they are dropped once their game objects are out
+		CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+		unsigned int count = 0;
+		for(CComponent* component : m_newComponentList)
+		{
+			if(component->GameObject()->Removal() != ESceneRemoval::None)
+			{
+				m_newComponentList[count++] = component;
+				continue;
+			}
+			batch.Add(component);
+		}
+		m_newComponentList.resize(count);
+		
+		// Components added from Start wait for the next update
+		batch.GroupByType();
+		for(const CTypeRange& range : batch.TypeRanges())
+		{
+			AddComponents(batch, range);
+			batch.Dispatch(range, &CComponent::Start, "Start");
+		}
+		
+		m_lifecycleBatchPool.Release();
 	}
 	
 	void CScene::Update()
 	{
+		DC_PROFILE_SCOPE("CScene::Update");
+		
+		const uint64_t frameStartNs = NowNs();
+		const int64_t transformUpdatesAtStart = CStats::Instance().TransformUpdates().Value();
+		
+		if(mp_recorder)
+		{
+			mp_recorder->Frame();
+		}
+		
 		PrepareUpdate();
+		
+		if(mp_interestManager)
+		{
+			DC_PROFILE_SCOPE("CInterestManager::Update");
+			mp_interestManager->Update(*this, m_interestTick);
+			m_interestTick = m_tick;
+		}
 
-		for(auto& componentListEntry : m_componentsMap)
+		// Only interest management deactivates game objects, without it nothing is skipped
+		if(mp_interestManager)
+		{
+			for(auto& componentListEntry : m_componentsMap)
+			{
+				DC_PROFILE_SCOPE_CAT(componentListEntry.first, "Update");
+				for(auto* component : componentListEntry.second)
+				{
+					if(component->GameObject()->Active())
+					{
+						component->Update();
+					}
+				}
+			}
+		}
+		else
 		{
-			for(auto* component : componentListEntry.second)
+			for(auto& componentListEntry : m_componentsMap)
 			{
-				component->Update();
+				DC_PROFILE_SCOPE_CAT(componentListEntry.first, "Update");
+				for(auto* component : componentListEntry.second)
+				{
+					component->Update();
+				}
 			}
 		}
+		
+		m_events.Dispatch(EEventPhase::AfterUpdate);
+		
+		m_timers.Advance(frameStartNs);
+		m_scheduler.Update(m_frame, frameStartNs);
 
 		FinishUpdate();
+		
+		m_events.Dispatch(EEventPhase::EndOfFrame);
+		m_events.Recycle();
+		
+		if(m_compactionBudget)
+		{
+			Compact();
+		}
+		
+		if(mp_spatialIndex)
+		{
+			SyncSpatialIndex();
+		}
+		
+		++m_tick;
+		
+		if(m_publishSnapshots)
+		{
+			PublishWorldSnapshot();
+		}
+		
+		if(mp_exporter)
+		{
+			DC_PROFILE_SCOPE("CSharedSceneExporter::Export");
+			mp_exporter->Export(*this);
+		}
+		
+		RecordFrameStats(frameStartNs, transformUpdatesAtStart);
+	}
+	
+	void CScene::RecordFrameStats(const uint64_t frameStartNs, const int64_t transformUpdatesAtStart)
+	{
+		// Transform updates are process wide, other scenes updating at the same time will add to this count
+		m_transformUpdatesLastFrame = CStats::Instance().TransformUpdates().Value() - transformUpdatesAtStart;
+		m_frameTimes.Record((NowNs() - frameStartNs) / 1000);
+		++m_frame;
+		
+		if(mp_statsOutput && m_statsInterval && (m_frame % m_statsInterval) == 0)
+		{
+			Stats().Write(*mp_statsOutput, m_statsFormat);
+		}
 	}
 
+	CChangeTracker& CScene::ChangeTracker(const char* name)
+	{
+		auto trackerEntryIt = m_changeTrackerMap.find(name);
+		if(trackerEntryIt == m_changeTrackerMap.end())
+		{
+			trackerEntryIt = m_changeTrackerMap.emplace(name, CChangeTracker(&m_tick)).first;
+		}
+		return trackerEntryIt->second;
+	}
+	
+	void CScene::EnableSpatialIndex(const float cellSize)
+	{
+		mp_spatialIndex.reset(new CSpatialGrid(cellSize));
+		
+		for(CGameObject* gameObject : m_goList)
+		{
+			mp_spatialIndex->Update(gameObject, gameObject->Transform()->Position());
+		}
+		m_spatialTick = m_tick + 1;
+	}
+	
+	void CScene::EnableInterestManagement(const CInterestSettings& settings)
+	{
+		mp_interestManager.reset(new CInterestManager(settings));
+		
+		// Everything counts as changed, the next update places the whole scene
+		m_interestTick = 0;
+	}
+	
+	void CScene::DisableInterestManagement()
+	{
+		mp_interestManager.reset();
+		
+		for(CGameObject* gameObject : m_goList)
+		{
+			gameObject->Active(true);
+		}
+	}
+	
+	void CScene::SyncSpatialIndex()
+	{
+		DC_PROFILE_SCOPE("CScene::SyncSpatialIndex");
+		
+		CSpatialGrid* spatialIndex = mp_spatialIndex.get();
+		ForEachChanged<CTransform>(m_spatialTick, [spatialIndex](CTransform* transform)
+		{
+			spatialIndex->Update(transform->GameObject(), transform->Position());
+		});
+		
+		// Whatever changes after this point will be stamped with the next tick
+		m_spatialTick = m_tick + 1;
+	}
+	
+	void CScene::PublishWorldSnapshot()
+	{
+		DC_PROFILE_SCOPE("CScene::PublishWorldSnapshot");
+		
+		std::shared_ptr<CWorldSnapshot> snapshot = RecycleWorldSnapshot();
+		
+		const unsigned int count = m_goList.size();
+		snapshot->m_epoch = m_frame;
+		snapshot->m_matrixList.resize(count);
+		
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			snapshot->m_matrixList[i] = m_goList[i]->Transform()->WorldMatrix();
+		}
+		
+		// The handle to index table only needs rebuilding when the game object list changed
+		if(snapshot->m_layoutVersion != m_goListVersion)
+		{
+			snapshot->m_layoutVersion = m_goListVersion;
+			snapshot->m_gameObjectList = m_goList;
+			snapshot->m_indexTable.clear();
+			snapshot->m_indexTable.reserve(count);
+			
+			for(unsigned int i = 0; i < count; ++i)
+			{
+				snapshot->m_indexTable[m_goList[i]] = i;
+			}
+		}
+		
+		std::atomic_store(&mp_worldSnapshot, TWorldSnapshotPtr(snapshot));
+	}
+	
+	std::shared_ptr<CWorldSnapshot> CScene::RecycleWorldSnapshot()
+	{
+		// A snapshot only referenced by the pool is neither published nor held by a reader.
+		// Once unpublished nobody can get a new reference, so the count can only go down.
+		for(auto& snapshot : m_snapshotPool)
+		{
+			if(snapshot.use_count() == 1)
+			{
+				std::atomic_thread_fence(std::memory_order_acquire);
+				return snapshot;
+			}
+		}
+		
+		m_snapshotPool.push_back(std::make_shared<CWorldSnapshot>());
+		return m_snapshotPool.back();
+	}
+	
 	void CScene::FinishUpdate()
 	{
-		if(m_oldGOList.size() == 0)
-			return;
+		DC_PROFILE_SCOPE("CScene::FinishUpdate");
+		
+		// Game objects destroyed from Finish are still in the scene, they wait for the next update
+		TGOList destroyList;
+		destroyList.swap(m_destroyGOList);
+		
+		if(!m_oldComponentList.empty())
+		{
+			FinishOldComponents();
+		}
+		
+		if(!m_oldGOList.empty())
+		{
+			// Game objects removed from Finish wait for the next update
+			CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+			bool pendingRemoved = false;
+			for(CGameObject* gameObject : m_oldGOList)
+			{
+				RemoveFromScene(gameObject);
+				
+				// Removed before joining the scene, they never started so they don't finish
+				if(!gameObject->Transform()->mp_changeTracker)
+				{
+					pendingRemoved = true;
+					continue;
+				}
+				
+				// Neither do the components added after it joined that are still waiting to start
+				batch.Add(gameObject, [](const CComponent* component)
+				{
+					return component->mp_changeTracker != 0;
+				});
+			}
+			m_oldGOList.clear();
+			
+			// Removed game objects have no scene now, one pass takes all of them out of the list
+			m_goList.erase(std::remove_if(m_goList.begin(), m_goList.end(), [this](CGameObject* gameObject)
+			{
+				return gameObject->Scene() != this;
+			}), m_goList.end());
+			++m_goListVersion;
+			
+			// The pending ones must not join the scene once they are gone
+			if(pendingRemoved)
+			{
+				m_newGOList.erase(std::remove_if(m_newGOList.begin(), m_newGOList.end(), [this](CGameObject* gameObject)
+				{
+					return gameObject->Scene() != this;
+				}), m_newGOList.end());
+			}
+			
+			if(!m_newComponentList.empty())
+			{
+				m_newComponentList.erase(std::remove_if(m_newComponentList.begin(), m_newComponentList.end(), [this](CComponent* component)
+				{
+					return component->GameObject()->Scene() != this;
+				}), m_newComponentList.end());
+			}
+			
+			batch.GroupByType();
+			for(const CTypeRange& range : batch.TypeRanges())
+			{
+				RemoveComponents(batch, range);
+				batch.Dispatch(range, &CComponent::Finish, "Finish");
+			}
+			
+			m_lifecycleBatchPool.Release();
+		}
+		
+		// Destroyed hierarchies are out of the scene now, they can be unlinked and queued.
+		// A destroyed game object below another destroyed one goes with its ancestor.
+		for(CGameObject* gameObject : destroyList)
+		{
+			CTransform* transform = gameObject->Transform();
+			
+			bool ancestorDestroyed = false;
+			for(CTransform* ancestor = transform->Parent(); ancestor && !ancestorDestroyed; ancestor = ancestor->Parent())
+			{
+				ancestorDestroyed = ancestor->GameObject()->Removal() == ESceneRemoval::Destroy;
+			}
+			if(ancestorDestroyed)
+			{
+				continue;
+			}
+			
+			CTransform* parent = transform->Parent();
+			if(parent)
+			{
+				parent->Remove(transform);
+			}
+			m_destructionQueue.Enqueue(gameObject);
+		}
+		
+		m_destructionQueue.Process();
+	}
+	
+	void CScene::FinishOldComponents()
+	{
+		// Components taken out from Finish wait for the next update
+		TComponentList oldComponentList;
+		oldComponentList.swap(m_oldComponentList);
 		
-		for(CGameObject* gameObject : m_oldGOList)
+		// The ones that never joined the scene have nothing to finish
+		CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+		for(CComponent* component : oldComponentList)
 		{
-			RemoveFromScene(gameObject);
+			if(component->mp_changeTracker)
+			{
+				batch.Add(component);
+			}
 		}
-		m_oldGOList.clear();
+		
+		batch.GroupByType();
+		for(const CTypeRange& range : batch.TypeRanges())
+		{
+			RemoveComponents(batch, range);
+			batch.Dispatch(range, &CComponent::Finish, "Finish");
+		}
+		
+		m_lifecycleBatchPool.Release();
+		
+		SafeDelete(oldComponentList);
 	}
 
 	
@@ -80,110 +510,570 @@ namespace dc
 	{
 		assert(gameObject && "[CScene::Exists] game object can't be NULL");
 
-		//printf("[CScene::AddToScene] Adding %s\n", gameObject->Name().c_str());
+		// The whole hierarchy goes in at once
+		CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+		batch.AddHierarchy(gameObject);
 		
-		// Check if the same Game Object is already in the scene, we can't have two instances of the same game object
-		assert(!Exists(gameObject) && "[CScene::AddToScene] You can't add more than one instance of a GameObject");
+		for(CGameObject* child : batch.GameObjects())
+		{
+			// Check if the same Game Object is already in the scene, we can't have two instances of the same game object
+			assert(!Exists(child) && "[CScene::Add] You can't add more than one instance of a GameObject");
+			assert(!child->Scene() && "[CScene::Add] The game object is already in a scene");
+			child->Scene(this);
+		}
+		++m_hierarchyVersion;
 		
-		// We add it to a list to include it in the scene in a deferred way
-		m_newGOList.push_back(gameObject);
+		// We add them to a list to include them in the scene in a deferred way
+		const size_t previousCapacity = m_newGOList.capacity();
+		m_newGOList.insert(m_newGOList.end(), batch.GameObjects().begin(), batch.GameObjects().end());
+		TrackGrowth(m_newGOList, previousCapacity);
 		
-		// As the Game Object is a valid one, we initialize its components
-		const TComponentListTable& goComponentsMap = gameObject->ComponentsTable();
-		for(auto& componentListEntry : goComponentsMap)
+		if(mp_recorder)
 		{
-			const TComponentList& componentList = componentListEntry.second;
-			for(CComponent* component : componentList)
+			mp_recorder->Add(gameObject);
+		}
+		
+		// As the Game Objects are valid ones, we initialize their components
+		batch.GroupByType();
+		AwakeComponents(batch);
+		
+		m_lifecycleBatchPool.Release();
+	}
+	
+	void CScene::Destroy(CGameObject* gameObject)
+	{
+		assert(gameObject && "[CScene::Destroy] game object can't be NULL");
+		
+		// Already queued, a second entry would destroy it twice
+		if(gameObject->Removal() == ESceneRemoval::Destroy)
+		{
+			return;
+		}
+		
+		if(mp_recorder)
+		{
+			mp_recorder->Destroy(gameObject);
+		}
+		
+		RemoveHierarchy(gameObject);
+		gameObject->Removal(ESceneRemoval::Destroy);
+		m_destroyGOList.push_back(gameObject);
+	}
+	
+	void CScene::AddComponent(CComponent* component)
+	{
+		assert(component && component->GameObject() && component->GameObject()->Scene() == this && "[CScene::AddComponent] The component's game object isn't in the scene");
+		
+		// A leaving game object is already asleep, the component waits with it
+		CGameObject* gameObject = component->GameObject();
+		if(gameObject->Removal() != ESceneRemoval::None)
+		{
+			return;
+		}
+		
+		// Awake can't run alongside the ones of the rest of the game object
+		if(!m_awakingMap.empty())
+		{
+			FinishAwake(gameObject);
+		}
+		component->Awake();
+		
+		// Pending game objects start all their components when they join
+		if(gameObject->Transform()->mp_changeTracker)
+		{
+			m_newComponentList.push_back(component);
+		}
+	}
+	
+	void CScene::RemoveComponent(CComponent* component)
+	{
+		assert(component && component->GameObject() && component->GameObject()->Scene() == this && "[CScene::RemoveComponent] The component's game object isn't in the scene");
+		
+		// Still waiting to start, it mustn't join the scene anymore
+		if(!component->mp_changeTracker && !m_newComponentList.empty())
+		{
+			const auto componentIt = std::find(m_newComponentList.begin(), m_newComponentList.end(), component);
+			if(componentIt != m_newComponentList.end())
 			{
-				component->Awake();
+				m_newComponentList.erase(componentIt);
 			}
 		}
 		
-		// And now the children components
-		const TTransformList& childrenList = gameObject->Transform()->Children();
-		
-		for(auto* children : childrenList)
+		// Components of a leaving game object are already asleep, or never woke up
+		CGameObject* gameObject = component->GameObject();
+		if(gameObject->Removal() == ESceneRemoval::None)
 		{
-			Add(children->GameObject());
+			if(!m_awakingMap.empty())
+			{
+				FinishAwake(gameObject);
+			}
+			component->Sleep();
 		}
+		
+		// Updates may still reach it until it's out of the component lists
+		m_oldComponentList.push_back(component);
 	}
 	
 	void CScene::Remove(CGameObject* gameObject)
 	{
-		// We add it to a list to remove it from the scene in a deferred way
-		m_oldGOList.push_back(gameObject);
+		if(mp_recorder)
+		{
+			mp_recorder->Remove(gameObject);
+		}
 		
-		// To prepare the Game Object for removal we call Sleep on its components
-		const TComponentListTable& goComponentsMap = gameObject->ComponentsTable();
-		for(auto& componentListEntry : goComponentsMap)
+		RemoveHierarchy(gameObject);
+	}
+	
+	void CScene::RemoveHierarchy(CGameObject* gameObject)
+	{
+		// Game objects with a removal pending, from an overlapping hierarchy, are already asleep and listed
+		CLifecycleBatch& batch = m_lifecycleBatchPool.Acquire();
+		batch.AddHierarchy(gameObject, [](const CGameObject* child)
 		{
-			const TComponentList& componentList = componentListEntry.second;
-			for(CComponent* component : componentList)
+			return child->Removal() == ESceneRemoval::None;
+		});
+		
+		// We add them to a list to remove them from the scene in a deferred way
+		m_oldGOList.insert(m_oldGOList.end(), batch.GameObjects().begin(), batch.GameObjects().end());
+		
+		// Their timers must not fire anymore, not even in this update
+		for(CGameObject* child : batch.GameObjects())
+		{
+			child->Removal(ESceneRemoval::Remove);
+			m_timers.Cancel(child);
+		}
+		
+		// Sleep can't run alongside Awake
+		if(!m_awakingMap.empty())
+		{
+			for(CGameObject* child : batch.GameObjects())
 			{
-				component->Sleep();
+				FinishAwake(child);
 			}
 		}
 		
-		// And now the children components
-		const TTransformList& childrenList = gameObject->Transform()->Children();
+		// To prepare the Game Objects for removal we call Sleep on their components
+		batch.GroupByType();
+		batch.Dispatch(&CComponent::Sleep, "Sleep");
+		
+		m_lifecycleBatchPool.Release();
+	}
+	
+	void CScene::RemoveFromScene(CGameObject* gameObject)
+	{
+		gameObject->Scene(0);
+		++m_hierarchyVersion;
+		
+		// Destroyed ones keep the mark until they are queued, their destroyed descendants look for it
+		if(gameObject->Removal() == ESceneRemoval::Remove)
+		{
+			gameObject->Removal(ESceneRemoval::None);
+		}
+		
+		// The rest of the hierarchy being compacted went with it, the next root follows
+		if(gameObject == mp_compactionNext)
+		{
+			mp_compactionNext = 0;
+		}
 		
-		for(auto* children : childrenList)
+		if(mp_spatialIndex)
 		{
-			Remove(children->GameObject());
+			mp_spatialIndex->Remove(gameObject);
 		}
+		
+		if(mp_interestManager)
+		{
+			mp_interestManager->Remove(gameObject);
+		}
+		
+		m_scheduler.Cancel(gameObject);
+		m_timers.Cancel(gameObject);
 	}
-
-	void CScene::AddToScene(CGameObject* gameObject)
+	
+	void CScene::AwakeComponents(const CLifecycleBatch& batch)
 	{
-		m_goList.push_back(gameObject);
+		CAwakeGroup* group = 0;
+		for(const CTypeRange& range : batch.TypeRanges())
+		{
+			DC_PROFILE_SCOPE_CAT(range.mp_name, "Awake");
+			
+			for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+			{
+				CComponent* component = batch.Components()[i];
+				if(!mp_threadPool || !component->AsyncAwake())
+				{
+					component->Awake();
+					continue;
+				}
+				
+				if(!group)
+				{
+					group = new CAwakeGroup();
+					group->m_gameObjectCount = 0;
+				}
+				mp_threadPool->Submit([component] { component->Awake(); }, &group->m_counter);
+			}
+		}
 		
-		const TComponentListTable& goComponentsMap = gameObject->ComponentsTable();
-		for(auto& componentListEntry : goComponentsMap)
+		if(!group)
 		{
-			AddComponents(componentListEntry.first, componentListEntry.second);
+			return;
+		}
+		
+		// The hierarchy joins the scene at once, every game object waits for the whole group
+		for(CGameObject* gameObject : batch.GameObjects())
+		{
+			m_awakingMap[gameObject] = group;
+			++group->m_gameObjectCount;
 		}
 	}
 	
-	void CScene::RemoveFromScene(CGameObject* gameObject)
+	void CScene::TakeAwakeGameObjects(CLifecycleBatch& batch)
+	{
+		unsigned int count = 0;
+		for(CGameObject* gameObject : m_newGOList)
+		{
+			const auto awakingEntryIt = m_awakingMap.find(gameObject);
+			if(awakingEntryIt != m_awakingMap.end())
+			{
+				if(!awakingEntryIt->second->m_counter.Done())
+				{
+					m_newGOList[count++] = gameObject;
+					continue;
+				}
+				ReleaseAwaking(awakingEntryIt);
+			}
+			batch.Add(gameObject);
+		}
+		m_newGOList.resize(count);
+	}
+	
+	void CScene::FinishAwake(const CGameObject* gameObject)
 	{
-		dc::Remove(m_goList, gameObject);
+		const auto awakingEntryIt = m_awakingMap.find(gameObject);
+		if(awakingEntryIt == m_awakingMap.end())
+		{
+			return;
+		}
 		
-		const TComponentListTable& goComponentsMap = gameObject->ComponentsTable();
-		for(auto& componentListEntry : goComponentsMap)
+		mp_threadPool->Wait(awakingEntryIt->second->m_counter);
+		ReleaseAwaking(awakingEntryIt);
+	}
+	
+	void CScene::ReleaseAwaking(std::unordered_map<const CGameObject*, CAwakeGroup*>::iterator awakingEntryIt)
+	{
+		CAwakeGroup* group = awakingEntryIt->second;
+		m_awakingMap.erase(awakingEntryIt);
+		if(--group->m_gameObjectCount == 0)
 		{
-			RemoveComponents(componentListEntry.first, componentListEntry.second);
+			delete group;
 		}
 	}
 	
-	void CScene::AddComponents(const char* name, const TComponentList& newComponentList)
+	void CScene::AddComponents(const CLifecycleBatch& batch, const CTypeRange& range)
 	{
-		assert(newComponentList.size() && "[CScene::AddToScene] No components being added");
+		TComponentList& componentList = m_componentsMap[range.mp_name];
+		CChangeTracker& tracker = ChangeTracker(range.mp_name);
 		
-		// The Game Object is finally added into the scene, we call Awake
-		TComponentList& componentList = m_componentsMap[name];
+		const size_t previousCapacity = componentList.capacity();
+		unsigned int firstIndex = componentList.size();
 		
-		for(CComponent* component : newComponentList)
+		// New components count as changed, Refresh takes their tick into the chunks
+		for(unsigned int i = range.m_begin; i < range.m_end; ++i)
 		{
+			CComponent* component = batch.Components()[i];
+			component->m_sceneIndex = componentList.size();
+			component->mp_changeTracker = &tracker;
+			component->m_changedTick = m_tick;
 			componentList.push_back(component);
-			component->Start();
 		}
+		TrackGrowth(componentList, previousCapacity);
+		
+		switch(batch.Components()[range.m_begin]->StorageType())
+		{
+			case EComponentStorage::Dense:
+			{
+				// Kept in address order, so updating them walks the pool chunks forwards
+				const auto begin = componentList.begin();
+				const auto middle = begin + firstIndex;
+				const std::less<CComponent*> byAddress;
+				std::sort(middle, componentList.end(), byAddress);
+				
+				const auto mergeBegin = std::upper_bound(begin, middle, *middle, byAddress);
+				std::inplace_merge(mergeBegin, middle, componentList.end(), byAddress);
+				
+				firstIndex = mergeBegin - begin;
+				for(unsigned int i = firstIndex; i < componentList.size(); ++i)
+				{
+					componentList[i]->m_sceneIndex = i;
+				}
+				break;
+			}
+			case EComponentStorage::Sparse:
+			{
+				CSparseComponents& sparseComponents = m_sparseComponentsMap[range.mp_name];
+				sparseComponents.mp_componentList = &componentList;
+				
+				for(unsigned int i = firstIndex; i < componentList.size(); ++i)
+				{
+					const unsigned int id = componentList[i]->GameObject()->Id();
+					assert(sparseComponents.m_index.Get(id) == CSparseIndex::NONE && "[CScene::AddComponents] A game object can't have two sparse components of the same type");
+					sparseComponents.m_index.Set(id, i);
+				}
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+		tracker.Refresh(componentList, firstIndex);
 	}
 	
-	void CScene::RemoveComponents(const char* name, const TComponentList& oldComponentList)
+	void CScene::RemoveComponents(const CLifecycleBatch& batch, const CTypeRange& range)
 	{
-		assert(oldComponentList.size() && "[CScene::Remove] No components being removed");
+		TComponentList& componentList = m_componentsMap[range.mp_name];
+		
+		unsigned int* compactedCount = CompactedCount(range.mp_name);
+		if(batch.Components()[range.m_begin]->StorageType() == EComponentStorage::Sparse)
+		{
+			// Holes are filled from the back, only the part before the first one stays compacted.
+			// The components moved into them are out of order until another pass puts them back.
+			if(compactedCount)
+			{
+				for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+				{
+					*compactedCount = std::min(*compactedCount, batch.Components()[i]->m_sceneIndex);
+				}
+			}
+			m_compactionVersion = ~0ull;
+			
+			RemoveSparseComponents(batch, range, componentList);
+			return;
+		}
+		
+		// Removing from the compacted part leaves it shorter
+		if(compactedCount)
+		{
+			unsigned int removed = 0;
+			for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+			{
+				removed += batch.Components()[i]->m_sceneIndex < *compactedCount;
+			}
+			*compactedCount -= removed;
+		}
 		
-		TComponentList& componentList = m_componentsMap[name];
+		// Leave a hole where every removed component was
+		unsigned int firstHole = componentList.size();
+		for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+		{
+			CComponent* component = batch.Components()[i];
+			const unsigned int index = component->m_sceneIndex;
+			assert(index < componentList.size() && componentList[index] == component && "[CScene::RemoveComponents] The component isn't in the scene");
+			
+			componentList[index] = 0;
+			firstHole = std::min(firstHole, index);
+			component->mp_changeTracker = 0;
+		}
 		
-		TComponentList::iterator oldBegin = std::find(componentList.begin(), componentList.end(), *oldComponentList.begin());
-		TComponentList::iterator oldEnd = oldBegin + oldComponentList.size();
+		// Close all the holes in a single pass, the remaining components keep their order
+		unsigned int count = firstHole;
+		for(unsigned int i = firstHole; i < componentList.size(); ++i)
+		{
+			if(componentList[i])
+			{
+				componentList[i]->m_sceneIndex = count;
+				componentList[count++] = componentList[i];
+			}
+		}
+		componentList.resize(count);
 		
-		componentList.erase(oldBegin, oldEnd);
+		ChangeTracker(range.mp_name).Refresh(componentList, firstHole);
+	}
+	
+	void CScene::RemoveSparseComponents(const CLifecycleBatch& batch, const CTypeRange& range, TComponentList& componentList)
+	{
+		CSparseIndex& sparseIndex = m_sparseComponentsMap[range.mp_name].m_index;
 		
-		for(CComponent* component : oldComponentList)
+		// The last component fills every hole, the order isn't kept
+		unsigned int firstHole = componentList.size();
+		for(unsigned int i = range.m_begin; i < range.m_end; ++i)
+		{
+			CComponent* component = batch.Components()[i];
+			const unsigned int index = component->m_sceneIndex;
+			assert(index < componentList.size() && componentList[index] == component && "[CScene::RemoveComponents] The component isn't in the scene");
+			
+			CComponent* last = componentList.back();
+			componentList[index] = last;
+			last->m_sceneIndex = index;
+			sparseIndex.Set(last->GameObject()->Id(), index);
+			componentList.pop_back();
+			
+			sparseIndex.Clear(component->GameObject()->Id());
+			firstHole = std::min(firstHole, index);
+			component->mp_changeTracker = 0;
+		}
+		
+		ChangeTracker(range.mp_name).Refresh(componentList, firstHole);
+	}
+	
+	CLocality CScene::Locality() const
+	{
+		uint64_t pairs = 0;
+		uint64_t nearPairs = 0;
+		uint64_t forwardPairs = 0;
+		for(const auto& componentListEntry : m_componentsMap)
+		{
+			const TComponentList& componentList = componentListEntry.second;
+			for(unsigned int i = 1; i < componentList.size(); ++i)
+			{
+				const intptr_t distance = (intptr_t)componentList[i] - (intptr_t)componentList[i - 1];
+				nearPairs += distance <= (intptr_t)CLocality::NEAR_BYTES && distance >= -(intptr_t)CLocality::NEAR_BYTES;
+				forwardPairs += distance > 0;
+				++pairs;
+			}
+		}
+		
+		uint64_t children = 0;
+		uint64_t parentFirst = 0;
+		const auto transformEntryIt = m_componentsMap.find(CTransform::TypeName());
+		if(transformEntryIt != m_componentsMap.end())
 		{
-			component->Finish();
+			for(const CComponent* component : transformEntryIt->second)
+			{
+				const CComponent* parent = component->DirectCast<CTransform>()->Parent();
+				if(parent && parent->mp_changeTracker && parent->GameObject()->Scene() == this)
+				{
+					parentFirst += parent->m_sceneIndex < component->m_sceneIndex;
+					++children;
+				}
+			}
+		}
+		
+		CLocality locality;
+		locality.m_nearFraction = pairs ? (float)nearPairs / pairs : 1.0f;
+		locality.m_forwardFraction = pairs ? (float)forwardPairs / pairs : 1.0f;
+		locality.m_parentFirstFraction = children ? (float)parentFirst / children : 1.0f;
+		return locality;
+	}
+	
+	unsigned int* CScene::CompactedCount(const char* name)
+	{
+		if(!m_compacting)
+		{
+			return 0;
+		}
+		
+		auto compactedEntryIt = m_compactedCountMap.find(name);
+		return compactedEntryIt != m_compactedCountMap.end() ? &compactedEntryIt->second : 0;
+	}
+	
+	void CScene::Compact()
+	{
+		DC_PROFILE_SCOPE("CScene::Compact");
+		
+		if(!m_compacting)
+		{
+			// Nothing came, went or moved since the last pass started, the lists are still in order
+			if(m_compactionVersion == m_goListVersion && m_compactionHierarchyVersion == m_hierarchyVersion)
+			{
+				return;
+			}
+			
+			m_compacting = true;
+			m_compactionVersion = m_goListVersion;
+			m_compactionHierarchyVersion = m_hierarchyVersion;
+			m_compactionCursor = 0;
+			mp_compactionRoot = 0;
+			mp_compactionNext = 0;
+			m_compactedCountMap.clear();
+		}
+		
+		for(unsigned int visited = 0; visited < m_compactionBudget; ++visited)
+		{
+			if(!mp_compactionNext)
+			{
+				// Children are reached from their roots
+				for(; m_compactionCursor < m_goList.size(); ++m_compactionCursor)
+				{
+					const CTransform* parent = m_goList[m_compactionCursor]->Transform()->Parent();
+					if(!parent || parent->GameObject()->Scene() != this)
+					{
+						break;
+					}
+				}
+				
+				if(m_compactionCursor == m_goList.size())
+				{
+					m_compacting = false;
+					++m_compactionPasses;
+					return;
+				}
+				
+				mp_compactionNext = m_goList[m_compactionCursor++];
+				mp_compactionRoot = mp_compactionNext->Transform();
+			}
+			
+			CGameObject* gameObject = mp_compactionNext;
+			CTransform* next = gameObject->Transform()->NextInHierarchy(mp_compactionRoot);
+			mp_compactionNext = next ? next->GameObject() : 0;
+			
+			if(gameObject->Scene() == this)
+			{
+				CompactGameObject(gameObject);
+			}
+		}
+	}
+	
+	void CScene::CompactGameObject(CGameObject* gameObject)
+	{
+		const CComponentSlots& components = gameObject->Components();
+		for(unsigned int i = 0; i < components.Size(); ++i)
+		{
+			CComponent* component = components[i];
+			
+			// Not started yet, or kept in memory order
+			if(!component->mp_changeTracker || component->StorageType() == EComponentStorage::Dense)
+			{
+				continue;
+			}
+			
+			const char* name = components.Name(i);
+			unsigned int& compactedCount = m_compactedCountMap[name];
+			const unsigned int index = component->m_sceneIndex;
+			if(index < compactedCount)
+			{
+				continue;
+			}
+			
+			if(index != compactedCount)
+			{
+				SwapComponents(name, m_componentsMap[name], index, compactedCount);
+			}
+			++compactedCount;
+		}
+	}
+	
+	void CScene::SwapComponents(const char* name, TComponentList& componentList, const unsigned int first, const unsigned int second)
+	{
+		CComponent* firstComponent = componentList[first];
+		CComponent* secondComponent = componentList[second];
+		
+		componentList[first] = secondComponent;
+		componentList[second] = firstComponent;
+		firstComponent->m_sceneIndex = second;
+		secondComponent->m_sceneIndex = first;
+		
+		// Both chunks have to cover the ticks that came in
+		CChangeTracker* tracker = firstComponent->mp_changeTracker;
+		tracker->Raise(second, firstComponent->m_changedTick);
+		tracker->Raise(first, secondComponent->m_changedTick);
+		
+		if(firstComponent->StorageType() == EComponentStorage::Sparse)
+		{
+			CSparseIndex& sparseIndex = m_sparseComponentsMap[name].m_index;
+			sparseIndex.Set(firstComponent->GameObject()->Id(), second);
+			sparseIndex.Set(secondComponent->GameObject()->Id(), first);
 		}
 	}
 }
-
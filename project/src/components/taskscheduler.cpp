@@ -0,0 +1,273 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "taskscheduler.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "debug/profiler.h"
+
+namespace dc
+{
+	CTaskWait CTaskWait::Frames(const unsigned int frames)
+	{
+		assert(frames > 0 && "[CTaskWait::Frames] Tasks wait at least one frame");
+		CTaskWait wait(ETaskWait::Frames);
+		wait.m_frames = frames;
+		return wait;
+	}
+	
+	CTaskWait CTaskWait::Seconds(const float seconds)
+	{
+		CTaskWait wait(ETaskWait::Seconds);
+		wait.m_seconds = seconds;
+		return wait;
+	}
+	
+	CTaskWait CTaskWait::Until(const std::function<bool()>& condition)
+	{
+		assert(condition && "[CTaskWait::Until] The condition can't be empty");
+		CTaskWait wait(ETaskWait::Until);
+		wait.m_condition = condition;
+		return wait;
+	}
+	
+	CTaskWait CTaskWait::Event(CTaskEvent& event)
+	{
+		CTaskWait wait(ETaskWait::Event);
+		wait.mp_event = &event;
+		return wait;
+	}
+	
+	CTaskWait CTaskWait::Stop()
+	{
+		return CTaskWait(ETaskWait::Stop);
+	}
+	
+	void CTaskEvent::Signal()
+	{
+		if(!mp_scheduler)
+		{
+			return;
+		}
+		
+		for(const uint64_t handle : m_waiterList)
+		{
+			mp_scheduler->Wake(handle);
+		}
+		m_waiterList.clear();
+	}
+	
+	const bool CTaskScheduler::Running(const uint64_t handle) const
+	{
+		return Valid(handle);
+	}
+	
+	uint64_t CTaskScheduler::Start(CGameObject* owner, const TTaskStepList& stepList)
+	{
+		assert(!stepList.empty() && "[CTaskScheduler::Start] The task has no steps");
+		
+		unsigned int index;
+		if(m_freeList.empty())
+		{
+			index = m_taskList.size();
+			m_taskList.push_back(CTask { TTaskStepList(), 0, 0, 1, std::function<bool()>() });
+		}
+		else
+		{
+			index = m_freeList.back();
+			m_freeList.pop_back();
+		}
+		
+		CTask& task = m_taskList[index];
+		task.m_stepList = stepList;
+		task.m_step = 0;
+		task.mp_owner = owner;
+		
+		const uint64_t handle = Handle(index, task.m_generation);
+		if(owner)
+		{
+			m_ownerTable[owner].push_back(handle);
+		}
+		
+		m_readyList.push_back(handle);
+		return handle;
+	}
+	
+	void CTaskScheduler::Cancel(const uint64_t handle)
+	{
+		if(!Valid(handle))
+		{
+			return;
+		}
+		
+		const unsigned int index = Index(handle);
+		const CGameObject* owner = m_taskList[index].mp_owner;
+		if(owner)
+		{
+			auto ownerIt = m_ownerTable.find(owner);
+			std::vector<uint64_t>& handleList = ownerIt->second;
+			
+			auto handleIt = std::find(handleList.begin(), handleList.end(), handle);
+			*handleIt = handleList.back();
+			handleList.pop_back();
+			
+			if(handleList.empty())
+			{
+				m_ownerTable.erase(ownerIt);
+			}
+		}
+		
+		Free(index);
+	}
+	
+	void CTaskScheduler::Cancel(const CGameObject* owner)
+	{
+		auto ownerIt = m_ownerTable.find(owner);
+		if(ownerIt == m_ownerTable.end())
+		{
+			return;
+		}
+		
+		for(const uint64_t handle : ownerIt->second)
+		{
+			Free(Index(handle));
+		}
+		m_ownerTable.erase(ownerIt);
+	}
+	
+	void CTaskScheduler::Update(const uint64_t frame, const uint64_t nowNs)
+	{
+		DC_PROFILE_SCOPE("CTaskScheduler::Update");
+		
+		m_frame = frame;
+		m_nowNs = nowNs;
+		
+		// Gather everything due first, tasks run now only park for later updates
+		m_runList.swap(m_readyList);
+		
+		while(!m_frameQueue.empty() && m_frameQueue.top().m_due <= frame)
+		{
+			m_runList.push_back(m_frameQueue.top().m_handle);
+			m_frameQueue.pop();
+		}
+		
+		while(!m_timeQueue.empty() && m_timeQueue.top().m_due <= nowNs)
+		{
+			m_runList.push_back(m_timeQueue.top().m_handle);
+			m_timeQueue.pop();
+		}
+		
+		for(unsigned int i = 0; i < m_conditionList.size();)
+		{
+			const uint64_t handle = m_conditionList[i];
+			if(!Valid(handle) || m_taskList[Index(handle)].m_condition())
+			{
+				m_runList.push_back(handle);
+				m_conditionList[i] = m_conditionList.back();
+				m_conditionList.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+		
+		for(const uint64_t handle : m_runList)
+		{
+			if(Valid(handle))
+			{
+				Run(handle);
+			}
+		}
+		m_runList.clear();
+	}
+	
+	void CTaskScheduler::Run(const uint64_t handle)
+	{
+		const unsigned int index = Index(handle);
+		
+		// The step may start or cancel tasks, growing the list or freeing this one,
+		// so it runs out of the list and the task is looked up again afterwards
+		const unsigned int stepIndex = m_taskList[index].m_step;
+		TTaskStep step = std::move(m_taskList[index].m_stepList[stepIndex]);
+		const CTaskWait wait = step();
+		
+		if(!Valid(handle))
+		{
+			return;
+		}
+		
+		CTask& task = m_taskList[index];
+		task.m_stepList[stepIndex] = std::move(step);
+		
+		if(!wait.m_repeat)
+		{
+			++task.m_step;
+		}
+		
+		if(wait.m_type == ETaskWait::Stop || task.m_step == task.m_stepList.size())
+		{
+			Cancel(handle);
+			return;
+		}
+		
+		Park(handle, wait);
+	}
+	
+	void CTaskScheduler::Park(const uint64_t handle, const CTaskWait& wait)
+	{
+		switch(wait.m_type)
+		{
+			case ETaskWait::Frames:
+				m_frameQueue.push(CDueTask { m_frame + wait.m_frames, handle });
+				break;
+				
+			case ETaskWait::Seconds:
+				m_timeQueue.push(CDueTask { m_nowNs + uint64_t(std::max(wait.m_seconds, 0.0f) * 1e9), handle });
+				break;
+				
+			case ETaskWait::Until:
+				m_taskList[Index(handle)].m_condition = wait.m_condition;
+				m_conditionList.push_back(handle);
+				break;
+				
+			case ETaskWait::Event:
+				wait.mp_event->mp_scheduler = this;
+				wait.mp_event->m_waiterList.push_back(handle);
+				break;
+				
+			case ETaskWait::Stop:
+				break;
+		}
+	}
+	
+	void CTaskScheduler::Free(const unsigned int index)
+	{
+		CTask& task = m_taskList[index];
+		
+		// Releases whatever the steps captured
+		task.m_stepList.clear();
+		task.m_condition = std::function<bool()>();
+		task.mp_owner = 0;
+		++task.m_generation;
+		
+		m_freeList.push_back(index);
+	}
+	
+	const bool CTaskScheduler::Valid(const uint64_t handle) const
+	{
+		const unsigned int index = Index(handle);
+		return index < m_taskList.size() && m_taskList[index].m_generation == (unsigned int)(handle >> 32) && !m_taskList[index].m_stepList.empty();
+	}
+}
@@ -0,0 +1,320 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "timerwheel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace dc
+{
+	const int CTimerWheel::NONE;
+	
+	CTimerWheel::CTimerWheel(const uint64_t resolutionNs):
+		m_resolutionNs(resolutionNs),
+		m_originNs(0),
+		m_started(false),
+		m_tick(0),
+		m_slotList(LEVEL_COUNT * LEVEL_SLOTS, NONE)
+	{
+		assert(resolutionNs > 0 && "[CTimerWheel::CTimerWheel] The resolution can't be zero");
+	}
+	
+	uint64_t CTimerWheel::After(CGameObject* owner, const float seconds, const TTimerCallback& callback)
+	{
+		return Schedule(owner, seconds, false, callback);
+	}
+	
+	uint64_t CTimerWheel::Every(CGameObject* owner, const float seconds, const TTimerCallback& callback)
+	{
+		return Schedule(owner, seconds, true, callback);
+	}
+	
+	void CTimerWheel::Cancel(const uint64_t handle)
+	{
+		if(!Valid(handle))
+		{
+			return;
+		}
+		
+		const int index = Index(handle);
+		CTimer& timer = m_timerList[index];
+		
+		// Take it out of the owner list
+		if(timer.mp_owner)
+		{
+			if(timer.m_ownerPrev != NONE)
+			{
+				m_timerList[timer.m_ownerPrev].m_ownerNext = timer.m_ownerNext;
+			}
+			else if(timer.m_ownerNext != NONE)
+			{
+				m_ownerTable[timer.mp_owner] = timer.m_ownerNext;
+			}
+			else
+			{
+				m_ownerTable.erase(timer.mp_owner);
+			}
+			
+			if(timer.m_ownerNext != NONE)
+			{
+				m_timerList[timer.m_ownerNext].m_ownerPrev = timer.m_ownerPrev;
+			}
+		}
+		
+		Unlink(index);
+		Free(index);
+	}
+	
+	void CTimerWheel::Cancel(const CGameObject* owner)
+	{
+		auto ownerIt = m_ownerTable.find(owner);
+		if(ownerIt == m_ownerTable.end())
+		{
+			return;
+		}
+		
+		int index = ownerIt->second;
+		m_ownerTable.erase(ownerIt);
+		
+		while(index != NONE)
+		{
+			const int next = m_timerList[index].m_ownerNext;
+			Unlink(index);
+			Free(index);
+			index = next;
+		}
+	}
+	
+	void CTimerWheel::Advance(const uint64_t nowNs)
+	{
+		if(!m_started)
+		{
+			m_started = true;
+			m_originNs = nowNs;
+			return;
+		}
+		
+		if(nowNs < m_originNs)
+		{
+			return;
+		}
+		
+		const uint64_t target = (nowNs - m_originNs) / m_resolutionNs;
+		
+		while(m_tick < target)
+		{
+			// Nothing to wait for, jump straight to the end
+			if(Count() == 0)
+			{
+				m_tick = target;
+				return;
+			}
+			
+			++m_tick;
+			
+			// When a level wraps around the next slot of the level above comes down, highest level first
+			unsigned int level = 1;
+			while(level < LEVEL_COUNT && (m_tick & ((uint64_t(1) << (LEVEL_BITS * level)) - 1)) == 0)
+			{
+				++level;
+			}
+			
+			while(--level > 0)
+			{
+				Cascade(level);
+			}
+			
+			Fire(m_tick & (LEVEL_SLOTS - 1));
+		}
+	}
+	
+	uint64_t CTimerWheel::Schedule(CGameObject* owner, const float seconds, const bool repeat, const TTimerCallback& callback)
+	{
+		assert(callback && "[CTimerWheel::Schedule] The callback can't be empty");
+		assert(seconds >= 0.0f && "[CTimerWheel::Schedule] The delay can't be negative");
+		
+		// Timers never fire in the tick they are scheduled in
+		const uint64_t ticks = std::max<uint64_t>(1, (uint64_t)std::ceil((double)seconds * 1e9 / (double)m_resolutionNs));
+		
+		int index;
+		if(m_freeList.empty())
+		{
+			index = m_timerList.size();
+			m_timerList.push_back(CTimer { TTimerCallback(), 0, 0, 0, 1, NONE, NONE, NONE, NONE, NONE });
+		}
+		else
+		{
+			index = m_freeList.back();
+			m_freeList.pop_back();
+		}
+		
+		CTimer& timer = m_timerList[index];
+		timer.m_callback = callback;
+		timer.mp_owner = owner;
+		timer.m_due = m_tick + ticks;
+		timer.m_period = repeat ? ticks : 0;
+		timer.m_ownerPrev = NONE;
+		timer.m_ownerNext = NONE;
+		
+		if(owner)
+		{
+			auto ownerIt = m_ownerTable.find(owner);
+			if(ownerIt != m_ownerTable.end())
+			{
+				timer.m_ownerNext = ownerIt->second;
+				m_timerList[ownerIt->second].m_ownerPrev = index;
+				ownerIt->second = index;
+			}
+			else
+			{
+				m_ownerTable.emplace(owner, index);
+			}
+		}
+		
+		Insert(index);
+		return Handle(index, timer.m_generation);
+	}
+	
+	void CTimerWheel::Insert(const int index)
+	{
+		CTimer& timer = m_timerList[index];
+		
+		// Timers beyond the reach of the wheel wait in the farthest slot and come down again later
+		const uint64_t horizon = m_tick + (uint64_t(1) << (LEVEL_BITS * LEVEL_COUNT)) - (uint64_t(1) << (LEVEL_BITS * (LEVEL_COUNT - 1)));
+		const uint64_t due = std::min(timer.m_due, horizon);
+		
+		// The level is the lowest one above which the due tick and the current one are the same
+		unsigned int level = 0;
+		while(level + 1 < LEVEL_COUNT && (due >> (LEVEL_BITS * (level + 1))) != (m_tick >> (LEVEL_BITS * (level + 1))))
+		{
+			++level;
+		}
+		
+		const int slot = level * LEVEL_SLOTS + ((due >> (LEVEL_BITS * level)) & (LEVEL_SLOTS - 1));
+		const int head = m_slotList[slot];
+		
+		timer.m_slot = slot;
+		timer.m_prev = NONE;
+		timer.m_next = head;
+		if(head != NONE)
+		{
+			m_timerList[head].m_prev = index;
+		}
+		m_slotList[slot] = index;
+	}
+	
+	void CTimerWheel::Unlink(const int index)
+	{
+		CTimer& timer = m_timerList[index];
+		if(timer.m_slot == NONE)
+		{
+			return;
+		}
+		
+		if(timer.m_prev != NONE)
+		{
+			m_timerList[timer.m_prev].m_next = timer.m_next;
+		}
+		else
+		{
+			m_slotList[timer.m_slot] = timer.m_next;
+		}
+		
+		if(timer.m_next != NONE)
+		{
+			m_timerList[timer.m_next].m_prev = timer.m_prev;
+		}
+		
+		timer.m_slot = NONE;
+	}
+	
+	void CTimerWheel::Free(const int index)
+	{
+		CTimer& timer = m_timerList[index];
+		timer.m_callback = TTimerCallback();
+		timer.mp_owner = 0;
+		timer.m_slot = NONE;
+		++timer.m_generation;
+		m_freeList.push_back(index);
+	}
+	
+	void CTimerWheel::Cascade(const unsigned int level)
+	{
+		const int slot = level * LEVEL_SLOTS + ((m_tick >> (LEVEL_BITS * level)) & (LEVEL_SLOTS - 1));
+		int index = m_slotList[slot];
+		m_slotList[slot] = NONE;
+		
+		while(index != NONE)
+		{
+			const int next = m_timerList[index].m_next;
+			Insert(index);
+			index = next;
+		}
+	}
+	
+	void CTimerWheel::Fire(const unsigned int slot)
+	{
+		int index = m_slotList[slot];
+		if(index == NONE)
+		{
+			return;
+		}
+		
+		// Detach the whole slot first, the callbacks are free to schedule and cancel timers
+		m_slotList[slot] = NONE;
+		m_fireList.clear();
+		while(index != NONE)
+		{
+			CTimer& timer = m_timerList[index];
+			timer.m_slot = NONE;
+			m_fireList.push_back(Handle(index, timer.m_generation));
+			index = timer.m_next;
+		}
+		
+		for(const uint64_t handle : m_fireList)
+		{
+			if(!Valid(handle))
+			{
+				continue;
+			}
+			
+			// The callback is moved out as it can grow the timer list
+			const int fireIndex = Index(handle);
+			TTimerCallback callback = std::move(m_timerList[fireIndex].m_callback);
+			
+			if(m_timerList[fireIndex].m_period == 0)
+			{
+				Cancel(handle);
+				callback();
+				continue;
+			}
+			
+			callback();
+			
+			if(Valid(handle))
+			{
+				CTimer& timer = m_timerList[fireIndex];
+				timer.m_callback = std::move(callback);
+				timer.m_due += timer.m_period;
+				Insert(fireIndex);
+			}
+		}
+	}
+	
+	const bool CTimerWheel::Valid(const uint64_t handle) const
+	{
+		const int index = Index(handle);
+		return index < (int)m_timerList.size() && m_timerList[index].m_generation == (unsigned int)(handle >> 32);
+	}
+}
@@ -13,121 +13,572 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "transform.h"
 
 #include "gameobject.h"
+#include "scene.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "debug/profiler.h"
+#include "replication/scenerecorder.h"
+
+#if !defined(DC_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+	#define DC_TRANSFORM_SSE
+	#include <xmmintrin.h>
+#endif
 
 namespace dc
 {
-	void CTransform::LocalMatrix(const math::Matrix4x4f& matrix)
+	namespace
 	{
-		m_localMatrix = matrix;
-		m_position = LocalPosition();
-		m_rotation = LocalRotation();
-		m_scale = LocalScale();
+		CSceneRecorder* Recorder(const CTransform* transform)
+		{
+			return transform->GameObject() ? transform->GameObject()->Recorder() : 0;
+		}
+		
+		/**
+		 * Scene of the transform's game object, NULL for transforms out of any scene or without game object
+		 */
+		CSceneBase* Scene(const CTransform* transform)
+		{
+			return transform->GameObject() ? transform->GameObject()->Scene() : 0;
+		}
+		
+		/**
+		 * Changes relating two transforms are only recorded when both are in the recorded scene
+		 */
+		CSceneRecorder* Recorder(const CTransform* transform, const CTransform* other)
+		{
+			CSceneRecorder* recorder = Recorder(transform);
+			return recorder && other->GameObject() && other->GameObject()->Scene() == transform->GameObject()->Scene() ? recorder : 0;
+		}
+		
+		/**
+		 * Applies an affine transform stored as basis columns x, y, z and translation
+		 */
+		void AffineTransform(const float* affine, const bool translate, const CVector3Array& input, CVector3Array& result)
+		{
+			const unsigned int count = input.Size();
+			result.Resize(count);
+			
+			const float* inX = input.X();
+			const float* inY = input.Y();
+			const float* inZ = input.Z();
+			float* outX = result.X();
+			float* outY = result.Y();
+			float* outZ = result.Z();
+			
+			const float tx = translate ? affine[9] : 0.0f;
+			const float ty = translate ? affine[10] : 0.0f;
+			const float tz = translate ? affine[11] : 0.0f;
+			
+			unsigned int i = 0;
+			
+#if defined(DC_TRANSFORM_SSE)
+			const __m128 xx = _mm_set1_ps(affine[0]), xy = _mm_set1_ps(affine[1]), xz = _mm_set1_ps(affine[2]);
+			const __m128 yx = _mm_set1_ps(affine[3]), yy = _mm_set1_ps(affine[4]), yz = _mm_set1_ps(affine[5]);
+			const __m128 zx = _mm_set1_ps(affine[6]), zy = _mm_set1_ps(affine[7]), zz = _mm_set1_ps(affine[8]);
+			const __m128 vtx = _mm_set1_ps(tx), vty = _mm_set1_ps(ty), vtz = _mm_set1_ps(tz);
+			
+			for(; i + 4 <= count; i += 4)
+			{
+				const __m128 x = _mm_loadu_ps(inX + i);
+				const __m128 y = _mm_loadu_ps(inY + i);
+				const __m128 z = _mm_loadu_ps(inZ + i);
+				
+				_mm_storeu_ps(outX + i, _mm_add_ps(_mm_add_ps(vtx, _mm_mul_ps(x, xx)), _mm_add_ps(_mm_mul_ps(y, yx), _mm_mul_ps(z, zx))));
+				_mm_storeu_ps(outY + i, _mm_add_ps(_mm_add_ps(vty, _mm_mul_ps(x, xy)), _mm_add_ps(_mm_mul_ps(y, yy), _mm_mul_ps(z, zy))));
+				_mm_storeu_ps(outZ + i, _mm_add_ps(_mm_add_ps(vtz, _mm_mul_ps(x, xz)), _mm_add_ps(_mm_mul_ps(y, yz), _mm_mul_ps(z, zz))));
+			}
+#endif
+			
+			for(; i < count; ++i)
+			{
+				const float x = inX[i];
+				const float y = inY[i];
+				const float z = inZ[i];
+				
+				outX[i] = tx + x * affine[0] + y * affine[3] + z * affine[6];
+				outY[i] = ty + x * affine[1] + y * affine[4] + z * affine[7];
+				outZ[i] = tz + x * affine[2] + y * affine[5] + z * affine[8];
+			}
+		}
 	}
 	
-	const bool CTransform::HasChild(CTransform* transform) const
+	std::atomic<unsigned int> CTransform::s_hierarchyVersion(1);
+	thread_local unsigned int CTransform::s_reparentBatch = 0;
+	
+	void CTransform::Reparent(const TReparentList& reparentList)
 	{
-		for (const auto* child : m_children)
+		DC_PROFILE_SCOPE_CAT("CTransform::Reparent", "Transform");
+		
+		const unsigned int batch = ++s_reparentBatch;
+		
+		// Consecutive moves within a recorded scene are recorded together
+		TReparentList recordList;
+		CSceneRecorder* recordListRecorder = 0;
+		for(const CReparent& reparent : reparentList)
 		{
-			if (child == transform)
-				return true;
+			CSceneRecorder* recorder = reparent.mp_parent ? Recorder(reparent.mp_child, reparent.mp_parent) : Recorder(reparent.mp_child);
+			if(recorder != recordListRecorder && !recordList.empty())
+			{
+				recordListRecorder->Reparent(recordList);
+				recordList.clear();
+			}
+			if(recorder)
+			{
+				recordList.push_back(reparent);
+			}
+			recordListRecorder = recorder;
+		}
+		if(!recordList.empty())
+		{
+			recordListRecorder->Reparent(recordList);
+		}
+		
+		for(const CReparent& reparent : reparentList)
+		{
+			assert(reparent.mp_child && "[CTransform::Reparent] You're moving a NULL pointer");
+			assert(!(reparent.mp_parent && reparent.mp_child->IsAncestorOf(reparent.mp_parent)) && "[CTransform::Reparent] A transform can't be moved below itself");
+			
+			reparent.mp_child->Link(reparent.mp_parent);
+			reparent.mp_child->m_reparentBatch = batch;
+		}
+		
+		// Updating the moved transforms without a moved ancestor reaches all the others
+		TTransformList topList;
+		for(const CReparent& reparent : reparentList)
+		{
+			CTransform* transform = reparent.mp_child;
+			
+			bool covered = false;
+			for(const CTransform* ancestor = transform->mp_parent; ancestor && !covered; ancestor = ancestor->mp_parent)
+			{
+				covered = ancestor->m_reparentBatch == batch;
+			}
+			
+			if(!covered)
+			{
+				topList.push_back(transform);
+			}
+		}
+		
+		// A transform listed twice is updated once
+		std::sort(topList.begin(), topList.end());
+		topList.erase(std::unique(topList.begin(), topList.end()), topList.end());
+		
+		for(CTransform* transform : topList)
+		{
+			transform->CalculateTransforms();
 		}
-		return false;
 	}
 	
-	void CTransform::Parent(CTransform* parent)
+	void CTransform::HierarchyChanged(const CTransform* child, const CTransform* parent)
 	{
-		assert(parent && "[CTransform::Parent] You're adding a NULL pointer");
+		s_hierarchyVersion.fetch_add(1, std::memory_order_relaxed);
 		
-		// If it's the same we do nothing
-		if(mp_parent == parent)
+		CSceneBase* childScene = Scene(child);
+		if(childScene)
 		{
-			return;
+			childScene->HierarchyChanged();
 		}
 		
-		// If it already has a parent, first we need to remove ourselves from its list of children
-		if(mp_parent)
+		CSceneBase* parentScene = Scene(parent);
+		if(parentScene && parentScene != childScene)
 		{
-			mp_parent->Remove(this);
+			parentScene->HierarchyChanged();
+		}
+	}
+	
+	void CTransform::LocalMatrix(const math::Matrix4x4f& matrix)
+	{
+		CSceneRecorder* recorder = Recorder(this);
+		if(recorder)
+		{
+			recorder->LocalMatrix(this, matrix);
 		}
 		
-		mp_parent = parent;
-
-		// If we are not already a child we add ourselves as child
-		if(!mp_parent->HasChild(this))
+		m_localMatrix = matrix;
+		mp_localTRS.reset();
+		CalculateTransforms();
+	}
+	
+	const bool CTransform::HasChild(CTransform* transform) const
+	{
+		return transform && transform->mp_parent == this;
+	}
+	
+	CTransform* CTransform::Root() const
+	{
+		if(!mp_parent)
 		{
-			mp_parent->Add(this);
+			return 0;
 		}
 		
-		// If
-		if (!mp_parent->Root())
+		// Only compared until it matches, a scene the game object left may be gone
+		const CSceneBase* scene = Scene(this);
+		if(mp_rootScene != scene || m_rootVersion != (scene ? scene->HierarchyVersion() : s_hierarchyVersion.load(std::memory_order_relaxed)))
 		{
-			Root(mp_parent);
+			// The scene version only covers the cache when every transform on the way up is in the scene
+			const unsigned int globalVersion = s_hierarchyVersion.load(std::memory_order_relaxed);
+			bool sameScene = scene != 0;
+			CTransform* root = 0;
+			for(CTransform* ancestor = mp_parent; ancestor; ancestor = ancestor->mp_parent)
+			{
+				root = ancestor;
+				sameScene = sameScene && Scene(ancestor) == scene;
+			}
+			
+			mp_rootCache = root;
+			mp_rootScene = sameScene ? scene : 0;
+			m_rootVersion = sameScene ? scene->HierarchyVersion() : globalVersion;
 		}
-		else
+		return mp_rootCache;
+	}
+	
+	CTransform* CTransform::NextInHierarchy(const CTransform* root) const
+	{
+		if(!m_children.empty())
 		{
-			Root(mp_parent->Root());
+			return m_children.front();
 		}
 		
+		for(const CTransform* transform = this; transform != root && transform->mp_parent; transform = transform->mp_parent)
+		{
+			const TTransformList& siblingList = transform->mp_parent->m_children;
+			if(transform->m_childIndex + 1 < siblingList.size())
+			{
+				return siblingList[transform->m_childIndex + 1];
+			}
+		}
+		return 0;
+	}
+	
+	void CTransform::Parent(CTransform* parent)
+	{
+		assert(parent && "[CTransform::Parent] You're adding a NULL pointer");
+		assert(!IsAncestorOf(parent) && "[CTransform::Parent] A transform can't be its own ancestor");
+		
+		// If it's the same we do nothing
+		if(mp_parent == parent)
+		{
+			return;
+		}
+		
+		CSceneRecorder* recorder = Recorder(this, parent);
+		if(recorder)
+		{
+			recorder->Parent(this, parent);
+		}
+		
+		Link(parent);
 		CalculateTransforms();
 	}
 
 	void CTransform::LocalPosition(const math::Vector3f& position)
 	{
-		m_position = position;
+		CSceneRecorder* recorder = Recorder(this);
+		if(recorder)
+		{
+			recorder->LocalPosition(this, position);
+		}
+		
+		LocalTRS().m_position = position;
+		CalculateLocalTransform();
 		CalculateTransforms();
 	}
 
 	void CTransform::LocalRotation(const math::Quaternionf& rotation)
 	{
-		m_rotation = rotation;
+		CSceneRecorder* recorder = Recorder(this);
+		if(recorder)
+		{
+			recorder->LocalRotation(this, rotation);
+		}
+		
+		LocalTRS().m_rotation = rotation;
+		CalculateLocalTransform();
 		CalculateTransforms();
 	}
 
 	void CTransform::LocalScale(const math::Vector3f& scale)
 	{
-		m_scale = scale;
+		CSceneRecorder* recorder = Recorder(this);
+		if(recorder)
+		{
+			recorder->LocalScale(this, scale);
+		}
+		
+		LocalTRS().m_scale = scale;
+		CalculateLocalTransform();
 		CalculateTransforms();
 	}
 	
-	void CTransform::Root(CTransform* root)
+	CTransform::CLocalTRS& CTransform::LocalTRS()
 	{
-		mp_root = root;
-		
-		for(auto* child : m_children)
+		if(!mp_localTRS)
 		{
-			child->Root(root);
+			mp_localTRS.reset(new CLocalTRS { m_localMatrix.Position(), m_localMatrix.Scale(), m_localMatrix.Rotation() });
 		}
+		return *mp_localTRS;
 	}
 	
 	void CTransform::Reset()
 	{
 		m_localMatrix.Identify();
 		m_globalMatrix.Identify();
-		m_scale = math::Vector3f::One();
-		m_rotation.Identity();
-		mp_root = 0;
+		mp_localTRS.reset();
+		mp_affineCache.reset();
 		mp_parent = 0;
+		m_childIndex = 0;
 		m_children.clear();
 	}
 	
 	math::Vector3f CTransform::TransformPosition(const math::Vector3f& point)
 	{
-		return m_localMatrix.TransformPosition(point);
+		return m_globalMatrix.TransformPosition(point);
+	}
+	
+	void CTransform::TransformPositions(const CVector3Array& points, CVector3Array& result) const
+	{
+		AffineTransform(AffineCache().m_world, true, points, result);
+	}
+	
+	void CTransform::TransformDirections(const CVector3Array& directions, CVector3Array& result) const
+	{
+		AffineTransform(AffineCache().m_world, false, directions, result);
+	}
+	
+	void CTransform::InverseTransformPositions(const CVector3Array& points, CVector3Array& result) const
+	{
+		AffineTransform(AffineCache().m_inverse, true, points, result);
+	}
+	
+	void CTransform::InverseTransformDirections(const CVector3Array& directions, CVector3Array& result) const
+	{
+		AffineTransform(AffineCache().m_inverse, false, directions, result);
+	}
+	
+	const CTransform::CAffineCache& CTransform::AffineCache() const
+	{
+		if(!mp_affineCache)
+		{
+			mp_affineCache.reset(new CAffineCache());
+			mp_affineCache->m_valid = false;
+		}
+		
+		CAffineCache& cache = *mp_affineCache;
+		if(cache.m_valid)
+		{
+			return cache;
+		}
+		
+		// The matrix layout is opaque, the affine part is read back from how it moves the origin and the axes
+		const math::Vector3f origin = m_globalMatrix.TransformPosition(math::Vector3f(0.0f, 0.0f, 0.0f));
+		const math::Vector3f axisList[3] =
+		{
+			m_globalMatrix.TransformPosition(math::Vector3f(1.0f, 0.0f, 0.0f)),
+			m_globalMatrix.TransformPosition(math::Vector3f(0.0f, 1.0f, 0.0f)),
+			m_globalMatrix.TransformPosition(math::Vector3f(0.0f, 0.0f, 1.0f))
+		};
+		
+		float* world = cache.m_world;
+		for(unsigned int axis = 0; axis < 3; ++axis)
+		{
+			world[axis * 3 + 0] = axisList[axis].x - origin.x;
+			world[axis * 3 + 1] = axisList[axis].y - origin.y;
+			world[axis * 3 + 2] = axisList[axis].z - origin.z;
+		}
+		world[9] = origin.x;
+		world[10] = origin.y;
+		world[11] = origin.z;
+		
+		// The rows of the inverse basis are the cross products of the columns divided by the determinant
+		const float* a = world;
+		const float* b = world + 3;
+		const float* c = world + 6;
+		const float rowList[3][3] =
+		{
+			{ b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2], b[0] * c[1] - b[1] * c[0] },
+			{ c[1] * a[2] - c[2] * a[1], c[2] * a[0] - c[0] * a[2], c[0] * a[1] - c[1] * a[0] },
+			{ a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] }
+		};
+		
+		const float determinant = a[0] * rowList[0][0] + a[1] * rowList[0][1] + a[2] * rowList[0][2];
+		assert(std::fabs(determinant) > 1e-12f && "[CTransform::AffineCache] The world matrix can't be inverted");
+		const float inverseDeterminant = 1.0f / determinant;
+		
+		float* inverse = cache.m_inverse;
+		for(unsigned int row = 0; row < 3; ++row)
+		{
+			float translation = 0.0f;
+			for(unsigned int column = 0; column < 3; ++column)
+			{
+				const float value = rowList[row][column] * inverseDeterminant;
+				inverse[column * 3 + row] = value;
+				translation -= value * world[9 + column];
+			}
+			inverse[9 + row] = translation;
+		}
+		
+		cache.m_valid = true;
+		return cache;
 	}
 	
 	void CTransform::Add(CTransform* child)
 	{
 		assert(child && "[CTransform::Add] You're adding a NULL pointer");
-		m_children.push_back(child);
 		child->Parent(this);
 	}
 	
 	void CTransform::Remove(CTransform* child)
 	{
 		assert(child && "[CTransform::Remove] You're removing a NULL pointer");
-		m_children.erase(std::find(Begin(), End(), child));
+		
+		CSceneRecorder* recorder = Recorder(this, child);
+		if(recorder)
+		{
+			recorder->RemoveChild(this, child);
+		}
+		
+		Unlink(child);
+	}
+	
+	void CTransform::Unlink(CTransform* child)
+	{
+		assert(HasChild(child) && m_children[child->m_childIndex] == child && "[CTransform::Remove] It isn't a child of this transform");
+		
+		CTransform* last = m_children.back();
+		m_children[child->m_childIndex] = last;
+		last->m_childIndex = child->m_childIndex;
+		m_children.pop_back();
+		
+		child->mp_parent = 0;
+		child->m_childIndex = 0;
+		child->m_rebake = child->m_frozen;
+		HierarchyChanged(child, this);
+	}
+	
+	void CTransform::Detach()
+	{
+		if(!mp_parent)
+		{
+			return;
+		}
+		
+		CSceneRecorder* recorder = Recorder(this);
+		if(recorder)
+		{
+			recorder->Detach(this);
+		}
+		
+		mp_parent->Unlink(this);
+		CalculateTransforms();
+	}
+	
+	void CTransform::Freeze()
+	{
+		DC_PROFILE_SCOPE_CAT("CTransform::Freeze", "Transform");
+		
+		CSceneRecorder* recorder = Recorder(this);
+		if(recorder)
+		{
+			recorder->Freeze(this);
+		}
+		
+		// World matrices are always up to date, freezing only has to stop them changing
+		TTransformList pendingList(1, this);
+		while(!pendingList.empty())
+		{
+			CTransform* transform = pendingList.back();
+			pendingList.pop_back();
+			
+			transform->m_frozen = true;
+			transform->mp_localTRS.reset();
+			pendingList.insert(pendingList.end(), transform->m_children.begin(), transform->m_children.end());
+		}
+	}
+	
+	void CTransform::Unfreeze()
+	{
+		DC_PROFILE_SCOPE_CAT("CTransform::Unfreeze", "Transform");
+		
+		CSceneRecorder* recorder = Recorder(this);
+		if(recorder)
+		{
+			recorder->Unfreeze(this);
+		}
+		
+		TTransformList pendingList(1, this);
+		while(!pendingList.empty())
+		{
+			CTransform* transform = pendingList.back();
+			pendingList.pop_back();
+			
+			transform->m_frozen = false;
+			pendingList.insert(pendingList.end(), transform->m_children.begin(), transform->m_children.end());
+		}
+		
+		CalculateTransforms();
+	}
+	
+	void CTransform::Link(CTransform* parent)
+	{
+		if(mp_parent == parent)
+		{
+			return;
+		}
+		
+		if(mp_parent)
+		{
+			mp_parent->Unlink(this);
+		}
+		
+		if(parent)
+		{
+			mp_parent = parent;
+			m_childIndex = parent->m_children.size();
+			parent->m_children.push_back(this);
+			m_rebake = m_frozen;
+			HierarchyChanged(this, parent);
+		}
+	}
+	
+	const bool CTransform::IsAncestorOf(const CTransform* transform) const
+	{
+		for(; transform; transform = transform->mp_parent)
+		{
+			if(transform == this)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	
+	void CTransform::CloneFrom(const CTransform& source, CTransform* parent, const unsigned int childCount)
+	{
+		m_localMatrix = source.m_localMatrix;
+		if(source.mp_localTRS)
+		{
+			mp_localTRS.reset(new CLocalTRS(*source.mp_localTRS));
+		}
+		m_frozen = source.m_frozen;
+		m_children.reserve(childCount);
+		
+		if(parent)
+		{
+			mp_parent = parent;
+			m_childIndex = parent->m_children.size();
+			parent->m_children.push_back(this);
+			HierarchyChanged(this, parent);
+			m_globalMatrix = parent->m_globalMatrix * m_localMatrix;
+		}
+		else
+		{
+			m_globalMatrix = m_localMatrix;
+		}
 	}
 	
 	CTransform* CTransform::FindChild(const char* name)
@@ -150,19 +601,40 @@ namespace dc
 
 	void CTransform::CalculateLocalTransform()
 	{
-		/*
-		glm::mat4 translation = glm::translate(m_position);
-		glm::mat4 rotation = glm::toMat4(m_rotation);
-		glm::mat4 scale = glm::scale(m_scale);
-		m_localMatrix = translation * rotation * scale;
-		*/
+		static_assert(sizeof(math::Matrix4x4f) == 16 * sizeof(float), "[CTransform::CalculateLocalTransform] The local matrix must be 16 floats");
+		
+		const math::Vector3f& position = mp_localTRS->m_position;
+		const math::Vector3f& scale = mp_localTRS->m_scale;
+		const math::Quaternionf& rotation = mp_localTRS->m_rotation;
+		
+		const float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+		const float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+		const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+		
+		// Rotation columns scaled by each axis, then the translation, columns first like the affine cache
+		const float matrix[16] =
+		{
+			(1.0f - 2.0f * (yy + zz)) * scale.x,	2.0f * (xy + wz) * scale.x,				2.0f * (xz - wy) * scale.x,				0.0f,
+			2.0f * (xy - wz) * scale.y,				(1.0f - 2.0f * (xx + zz)) * scale.y,	2.0f * (yz + wx) * scale.y,				0.0f,
+			2.0f * (xz + wy) * scale.z,				2.0f * (yz - wx) * scale.z,				(1.0f - 2.0f * (xx + yy)) * scale.z,	0.0f,
+			position.x,								position.y,								position.z,								1.0f
+		};
+		std::memcpy(&m_localMatrix, matrix, sizeof(matrix));
+		
+		assert(m_localMatrix.Position().x == position.x && m_localMatrix.Position().y == position.y && m_localMatrix.Position().z == position.z
+			&& "[CTransform::CalculateLocalTransform] The local matrix isn't stored columns first");
 	}
 	
 	void CTransform::CalculateWorldTransform()
 	{
+		if(mp_affineCache)
+		{
+			mp_affineCache->m_valid = false;
+		}
+		
+		// Every change updates the whole hierarchy below it, so the parent is already up to date
 		if(HasParent())
 		{
-			mp_parent->CalculateWorldTransform();
 			m_globalMatrix = mp_parent->WorldMatrix() * m_localMatrix;
 		}
 		else
@@ -173,12 +645,31 @@ namespace dc
 	
 	void CTransform::CalculateTransforms()
 	{
-		CalculateLocalTransform();
+		if(m_frozen && !m_rebake)
+		{
+			return;
+		}
+		
+		DC_PROFILE_SCOPE_CAT("CTransform::CalculateTransforms", "Transform");
+		CalculateHierarchyTransforms();
+	}
+	
+	void CTransform::CalculateHierarchyTransforms()
+	{
+		// Frozen ones only get here after moving, or below one that moved, and bake the whole hierarchy again
+		const bool bake = m_frozen;
+		m_rebake = false;
+		
+		CStats::Instance().TransformUpdates().Increment();
+		MarkChanged();
 		CalculateWorldTransform();
 		
 		for(auto* child: m_children)
 		{
-			child->CalculateTransforms();
+			if(bake || !child->m_frozen || child->m_rebake)
+			{
+				child->CalculateHierarchyTransforms();
+			}
 		}
 	}
 	
@@ -0,0 +1,255 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+
+namespace dc
+{
+	namespace
+	{
+		thread_local CProfiler*			tp_bufferOwner = 0;
+		thread_local CProfileRingBuffer*	tp_threadBuffer = 0;
+		
+		void WriteJsonString(std::ostream& output, const char* text)
+		{
+			output << '"';
+			for(const char* c = text; *c; ++c)
+			{
+				if(*c == '"' || *c == '\\')
+				{
+					output << '\\';
+				}
+				output << *c;
+			}
+			output << '"';
+		}
+		
+		const double Percentile(const std::vector<double>& sortedValues, const double percentile)
+		{
+			const size_t index = std::min(sortedValues.size() - 1, (size_t)(percentile * sortedValues.size()));
+			return sortedValues[index];
+		}
+	}
+	
+	// ===========================================================
+	// CProfileRingBuffer
+	// ===========================================================
+	
+	CProfileRingBuffer::CProfileRingBuffer(const unsigned int threadIndex, const unsigned int capacityLog2):
+		m_threadIndex(threadIndex),
+		m_mask((uint64_t(1) << capacityLog2) - 1),
+		m_samples(size_t(1) << capacityLog2),
+		m_head(0),
+		m_tail(0),
+		m_dropped(0)
+	{}
+	
+	void CProfileRingBuffer::Push(const CProfileSample& sample)
+	{
+		const uint64_t head = m_head.load(std::memory_order_relaxed);
+		const uint64_t tail = m_tail.load(std::memory_order_acquire);
+		
+		if(head - tail > m_mask)
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		
+		m_samples[head & m_mask] = sample;
+		m_head.store(head + 1, std::memory_order_release);
+	}
+	
+	void CProfileRingBuffer::Drain(TProfileSampleList& output)
+	{
+		const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+		const uint64_t head = m_head.load(std::memory_order_acquire);
+		
+		for(uint64_t i = tail; i < head; ++i)
+		{
+			output.push_back(m_samples[i & m_mask]);
+		}
+		
+		m_tail.store(head, std::memory_order_release);
+	}
+	
+	// ===========================================================
+	// CProfiler
+	// ===========================================================
+	
+	CProfiler& CProfiler::Instance()
+	{
+		static CProfiler instance;
+		return instance;
+	}
+	
+	uint64_t CProfiler::NowNs()
+	{
+		using namespace std::chrono;
+		return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+	
+	CProfiler::CProfiler(const unsigned int bufferCapacityLog2):
+		m_bufferCapacityLog2(bufferCapacityLog2)
+	{
+		assert(bufferCapacityLog2 < 32 && "[CProfiler::CProfiler] Ring buffer capacity is too big");
+	}
+	
+	const uint64_t CProfiler::Dropped() const
+	{
+		uint64_t dropped = 0;
+		for(const auto& buffer : m_bufferList)
+		{
+			dropped += buffer->Dropped();
+		}
+		return dropped;
+	}
+	
+	CProfileRingBuffer& CProfiler::ThreadBuffer()
+	{
+		if(tp_bufferOwner != this)
+		{
+			std::lock_guard<std::mutex> lock(m_registryMutex);
+			m_bufferList.emplace_back(new CProfileRingBuffer(m_bufferList.size(), m_bufferCapacityLog2));
+			tp_threadBuffer = m_bufferList.back().get();
+			tp_bufferOwner = this;
+		}
+		return *tp_threadBuffer;
+	}
+	
+	void CProfiler::Collect()
+	{
+		std::lock_guard<std::mutex> lock(m_registryMutex);
+		for(auto& buffer : m_bufferList)
+		{
+			buffer->Drain(m_samples);
+		}
+	}
+	
+	void CProfiler::Clear()
+	{
+		Collect();
+		m_samples.clear();
+	}
+	
+	void CProfiler::ExportChromeTrace(std::ostream& output) const
+	{
+		const uint64_t originNs = m_samples.empty() ? 0 : std::min_element(m_samples.begin(), m_samples.end(), [](const CProfileSample& a, const CProfileSample& b)
+		{
+			return a.m_startNs < b.m_startNs;
+		})->m_startNs;
+		
+		const std::ios::fmtflags flags = output.flags();
+		const std::streamsize precision = output.precision();
+		
+		output << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+		
+		bool first = true;
+		for(const CProfileSample& sample : m_samples)
+		{
+			if(!first)
+			{
+				output << ",";
+			}
+			first = false;
+			
+			output << "\n{\"name\":";
+			WriteJsonString(output, sample.mp_name);
+			output << ",\"cat\":";
+			WriteJsonString(output, sample.mp_category);
+			output << ",\"ph\":\"X\""
+				<< ",\"ts\":" << (sample.m_startNs - originNs) / 1000.0
+				<< ",\"dur\":" << (sample.m_endNs - sample.m_startNs) / 1000.0
+				<< ",\"pid\":1"
+				<< ",\"tid\":" << sample.m_threadIndex << "}";
+		}
+		
+		output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		
+		output.flags(flags);
+		output.precision(precision);
+	}
+	
+	const bool CProfiler::ExportChromeTrace(const char* path) const
+	{
+		std::ofstream file(path);
+		if(!file)
+		{
+			return false;
+		}
+		ExportChromeTrace(file);
+		return file.good();
+	}
+	
+	TProfileStatList CProfiler::Summary() const
+	{
+		// Scopes are grouped by name and category content, the same literal may live at different addresses
+		using TScopeKey = std::pair<std::string, std::string>;
+		std::map<TScopeKey, std::pair<const CProfileSample*, std::vector<double>>> durationsTable;
+		for(const CProfileSample& sample : m_samples)
+		{
+			auto& entry = durationsTable[TScopeKey(sample.mp_name, sample.mp_category)];
+			entry.first = &sample;
+			entry.second.push_back((sample.m_endNs - sample.m_startNs) / 1000.0);
+		}
+		
+		TProfileStatList statList;
+		statList.reserve(durationsTable.size());
+		
+		for(auto& durationsEntry : durationsTable)
+		{
+			std::vector<double>& durations = durationsEntry.second.second;
+			std::sort(durations.begin(), durations.end());
+			
+			double total = 0.0;
+			for(const double duration : durations)
+			{
+				total += duration;
+			}
+			
+			CProfileStat stat;
+			stat.mp_name = durationsEntry.second.first->mp_name;
+			stat.mp_category = durationsEntry.second.first->mp_category;
+			stat.m_count = durations.size();
+			stat.m_meanUs = total / durations.size();
+			stat.m_p50Us = Percentile(durations, 0.5);
+			stat.m_p99Us = Percentile(durations, 0.99);
+			stat.m_maxUs = durations.back();
+			statList.push_back(stat);
+		}
+		
+		return statList;
+	}
+	
+	void CProfiler::PrintSummary(std::ostream& output) const
+	{
+		output << "scope category count mean_us p50_us p99_us max_us\n";
+		for(const CProfileStat& stat : Summary())
+		{
+			output << stat.mp_name << " " << stat.mp_category << " " << stat.m_count << " "
+				<< stat.m_meanUs << " " << stat.m_p50Us << " " << stat.m_p99Us << " " << stat.m_maxUs << "\n";
+		}
+		
+		const uint64_t dropped = Dropped();
+		if(dropped)
+		{
+			output << "dropped " << dropped << "\n";
+		}
+	}
+}
@@ -0,0 +1,200 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stats.h"
+
+namespace dc
+{
+	// ===========================================================
+	// CTimeHistogram
+	// ===========================================================
+	
+	CTimeHistogram::TBucketList CTimeHistogram::Buckets() const
+	{
+		TBucketList bucketList(BUCKET_COUNT);
+		for(unsigned int i = 0; i < BUCKET_COUNT; ++i)
+		{
+			bucketList[i] = m_buckets[i].load(std::memory_order_relaxed);
+		}
+		return bucketList;
+	}
+	
+	const uint64_t CTimeHistogram::Percentile(const TBucketList& buckets, const double percentile)
+	{
+		uint64_t total = 0;
+		for(const uint64_t count : buckets)
+		{
+			total += count;
+		}
+		
+		if(total == 0)
+		{
+			return 0;
+		}
+		
+		const uint64_t target = (uint64_t)(percentile * total);
+		uint64_t accumulated = 0;
+		for(unsigned int i = 0; i < buckets.size(); ++i)
+		{
+			accumulated += buckets[i];
+			if(accumulated > target)
+			{
+				return uint64_t(1) << (i + 1);
+			}
+		}
+		return uint64_t(1) << buckets.size();
+	}
+	
+	void CTimeHistogram::Record(const uint64_t microseconds)
+	{
+		unsigned int bucket = 0;
+		uint64_t value = microseconds;
+		while(value > 1 && bucket < BUCKET_COUNT - 1)
+		{
+			value >>= 1;
+			++bucket;
+		}
+		m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	}
+	
+	void CTimeHistogram::Reset()
+	{
+		for(auto& bucket : m_buckets)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+	
+	// ===========================================================
+	// CStats
+	// ===========================================================
+	
+	const char* CStats::SubsystemName(const EStatsSubsystem subsystem)
+	{
+		switch(subsystem)
+		{
+			case EStatsSubsystem::GameObject:	return "gameobject";
+			case EStatsSubsystem::Component:	return "component";
+			case EStatsSubsystem::Scene:		return "scene";
+			default:							return "unknown";
+		}
+	}
+	
+	// ===========================================================
+	// CStatsSnapshot
+	// ===========================================================
+	
+	CStatsSnapshot::CStatsSnapshot():
+		mp_name(""),
+		m_frame(0),
+		m_gameObjects(0),
+		m_pendingNew(0),
+		m_pendingOld(0),
+		m_componentLookups(0),
+		m_transformUpdates(0),
+		m_transformUpdatesLastFrame(0),
+		m_subsystemList()
+	{}
+	
+	void CStatsSnapshot::CaptureGlobals()
+	{
+		CStats& stats = CStats::Instance();
+		
+		m_componentLookups = stats.ComponentLookups().Value();
+		m_transformUpdates = stats.TransformUpdates().Value();
+		
+		for(unsigned int i = 0; i < (unsigned int)EStatsSubsystem::Count; ++i)
+		{
+			CStats::CSubsystemCounters& counters = stats.Subsystem((EStatsSubsystem)i);
+			m_subsystemList[i].m_live = counters.m_live.Value();
+			m_subsystemList[i].m_allocations = counters.m_allocations.Value();
+			m_subsystemList[i].m_bytes = counters.m_bytes.Value();
+		}
+	}
+	
+	void CStatsSnapshot::Write(std::ostream& output, const EStatsFormat format) const
+	{
+		if(format == EStatsFormat::Json)
+		{
+			WriteJson(output);
+		}
+		else
+		{
+			WriteText(output);
+		}
+	}
+	
+	void CStatsSnapshot::WriteText(std::ostream& output) const
+	{
+		output << "[" << mp_name << "] frame " << m_frame << "\n";
+		output << "  gameobjects " << m_gameObjects << " (new " << m_pendingNew << ", old " << m_pendingOld << ")\n";
+		
+		for(const auto& typeCount : m_componentsPerType)
+		{
+			output << "  components " << typeCount.first << " " << typeCount.second << "\n";
+		}
+		
+		output << "  component lookups " << m_componentLookups << "\n";
+		output << "  transform updates " << m_transformUpdates << " (last frame " << m_transformUpdatesLastFrame << ")\n";
+		
+		for(unsigned int i = 0; i < (unsigned int)EStatsSubsystem::Count; ++i)
+		{
+			const CSubsystem& subsystem = m_subsystemList[i];
+			output << "  " << CStats::SubsystemName((EStatsSubsystem)i)
+				<< " live " << subsystem.m_live
+				<< " allocations " << subsystem.m_allocations
+				<< " bytes " << subsystem.m_bytes << "\n";
+		}
+		
+		if(!m_frameTimeBuckets.empty())
+		{
+			output << "  frame time us p50 <" << CTimeHistogram::Percentile(m_frameTimeBuckets, 0.5)
+				<< " p99 <" << CTimeHistogram::Percentile(m_frameTimeBuckets, 0.99) << "\n";
+		}
+	}
+	
+	void CStatsSnapshot::WriteJson(std::ostream& output) const
+	{
+		output << "{\"name\":\"" << mp_name << "\""
+			<< ",\"frame\":" << m_frame
+			<< ",\"gameobjects\":" << m_gameObjects
+			<< ",\"pending_new\":" << m_pendingNew
+			<< ",\"pending_old\":" << m_pendingOld
+			<< ",\"components\":{";
+		
+		for(unsigned int i = 0; i < m_componentsPerType.size(); ++i)
+		{
+			output << (i ? "," : "") << "\"" << m_componentsPerType[i].first << "\":" << m_componentsPerType[i].second;
+		}
+		
+		output << "},\"component_lookups\":" << m_componentLookups
+			<< ",\"transform_updates\":" << m_transformUpdates
+			<< ",\"transform_updates_last_frame\":" << m_transformUpdatesLastFrame
+			<< ",\"subsystems\":{";
+		
+		for(unsigned int i = 0; i < (unsigned int)EStatsSubsystem::Count; ++i)
+		{
+			const CSubsystem& subsystem = m_subsystemList[i];
+			output << (i ? "," : "") << "\"" << CStats::SubsystemName((EStatsSubsystem)i) << "\":{"
+				<< "\"live\":" << subsystem.m_live
+				<< ",\"allocations\":" << subsystem.m_allocations
+				<< ",\"bytes\":" << subsystem.m_bytes << "}";
+		}
+		
+		output << "},\"frame_time_us\":[";
+		for(unsigned int i = 0; i < m_frameTimeBuckets.size(); ++i)
+		{
+			output << (i ? "," : "") << m_frameTimeBuckets[i];
+		}
+		output << "]}\n";
+	}
+}
@@ -5,27 +5,238 @@
 //	Created by Jorge L├│pez Gonz├ílez on 22/07/2018 21:40:02.
 //
 
+
 #include "gameobjectmanager.h"
 
-#include <cassert>
 #include <algorithm>
+#include <atomic>
+#include <cassert>
 
-#include "help/vectorhelp.h"
+#include "debug/profiler.h"
 
 namespace dc
 {
-	const bool CGameObjectMgr::Exists(const CGameObject * gameObject) const
+	namespace
+	{
+		const unsigned int SLOT_BITS = 28;
+		
+		/**
+		 * Every thread registers in its own shard, so threads only meet when deleting
+		 * game objects another thread created
+		 */
+		const unsigned int ThreadShard(const unsigned int shardCount)
+		{
+			static std::atomic<unsigned int> s_nextShard(0);
+			static thread_local unsigned int tp_shard = s_nextShard.fetch_add(1, std::memory_order_relaxed);
+			return tp_shard % shardCount;
+		}
+	}
+	
+	const TGOHandle CGameObjectMgr::INVALID_HANDLE;
+	const unsigned int CGameObjectMgr::SHARD_BITS;
+	const unsigned int CGameObjectMgr::SHARD_COUNT;
+	
+	// ===========================================================
+	// Getter & Setter
+	// ===========================================================
+	
+	const bool CGameObjectMgr::Exists(const CGameObject* gameObject) const
 	{
 		assert(gameObject && "[CGameObjectMgr::Exists] game object can't be NULL");
-		auto end = m_goList.end();
-		auto it = std::find(m_goList.begin(), end, gameObject);
-		return it != end;
+		return gameObject->mp_manager == this && Find(gameObject->m_handle) == gameObject;
 	}
-
+	
+	CGameObject* CGameObjectMgr::Find(const TGOHandle handle) const
+	{
+		if(handle == INVALID_HANDLE)
+		{
+			return 0;
+		}
+		
+		const unsigned int generation = handle >> 32;
+		const unsigned int slot = (handle & 0xFFFFFFFF) >> SHARD_BITS;
+		
+		CShard& shard = ShardOf(handle);
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+		if(slot >= shard.m_slotList.size() || shard.m_slotList[slot].m_generation != generation)
+		{
+			return 0;
+		}
+		return shard.m_slotList[slot].mp_gameObject;
+	}
+	
+	const unsigned int CGameObjectMgr::Count() const
+	{
+		unsigned int count = 0;
+		for(CShard& shard : m_shardList)
+		{
+			std::lock_guard<std::mutex> lock(shard.m_mutex);
+			count += shard.m_count;
+		}
+		return count;
+	}
+	
+	const int CGameObjectMgr::Affinity(const CScene* scene) const
+	{
+		for(const CManagedScene& managedScene : m_sceneList)
+		{
+			if(managedScene.mp_scene == scene)
+			{
+				return managedScene.m_worker;
+			}
+		}
+		return CThreadPool::ANY_WORKER;
+	}
+	
+	CStatsSnapshot CGameObjectMgr::Stats() const
+	{
+		CStatsSnapshot snapshot;
+		snapshot.mp_name = "CGameObjectMgr";
+		snapshot.m_gameObjects = Count();
+		snapshot.CaptureGlobals();
+		return snapshot;
+	}
+	
+	// ===========================================================
+	// Constructors
+	// ===========================================================
+	
+	CGameObjectMgr::CGameObjectMgr(const unsigned int workerCount):
+		m_nextAffinity(0),
+		mp_threadPool(new CThreadPool(workerCount))
+	{}
+	
 	CGameObjectMgr::~CGameObjectMgr()
 	{
-		SafeDelete(m_goList);
-		SafeDelete(m_newGOList);
-		SafeDelete(m_oldGOList);
+		for(CManagedScene& managedScene : m_sceneList)
+		{
+			delete managedScene.mp_scene;
+		}
+		m_sceneList.clear();
+		
+		// The destructors unregister, so they can't run while holding a shard
+		TGOList leftoverList;
+		for(CShard& shard : m_shardList)
+		{
+			std::lock_guard<std::mutex> lock(shard.m_mutex);
+			for(CSlot& slot : shard.m_slotList)
+			{
+				if(slot.mp_gameObject)
+				{
+					leftoverList.push_back(slot.mp_gameObject);
+				}
+			}
+		}
+		
+		for(CGameObject* gameObject : leftoverList)
+		{
+			delete gameObject;
+		}
+	}
+	
+	// ===========================================================
+	// Methods
+	// ===========================================================
+	
+	CGameObject* CGameObjectMgr::Create(const char* name)
+	{
+		CGameObject* gameObject = new CGameObject(name);
+		Register(gameObject);
+		return gameObject;
+	}
+	
+	const TGOHandle CGameObjectMgr::Register(CGameObject* gameObject)
+	{
+		assert(gameObject && "[CGameObjectMgr::Register] game object can't be NULL");
+		assert(!gameObject->mp_manager && "[CGameObjectMgr::Register] The game object already has a manager");
+		
+		const unsigned int shardIndex = ThreadShard(SHARD_COUNT);
+		CShard& shard = m_shardList[shardIndex];
+		
+		unsigned int slot = 0;
+		unsigned int generation = 0;
+		{
+			std::lock_guard<std::mutex> lock(shard.m_mutex);
+			if(shard.m_freeList.empty())
+			{
+				assert(shard.m_slotList.size() < (1u << SLOT_BITS) && "[CGameObjectMgr::Register] The shard is full");
+				slot = shard.m_slotList.size();
+				shard.m_slotList.push_back(CSlot { gameObject, 1 });
+			}
+			else
+			{
+				slot = shard.m_freeList.back();
+				shard.m_freeList.pop_back();
+				shard.m_slotList[slot].mp_gameObject = gameObject;
+			}
+			generation = shard.m_slotList[slot].m_generation;
+			++shard.m_count;
+		}
+		
+		const TGOHandle handle = ((TGOHandle)generation << 32) | ((TGOHandle)slot << SHARD_BITS) | shardIndex;
+		gameObject->mp_manager = this;
+		gameObject->m_handle = handle;
+		return handle;
+	}
+	
+	void CGameObjectMgr::Unregister(CGameObject* gameObject)
+	{
+		assert(gameObject && "[CGameObjectMgr::Unregister] game object can't be NULL");
+		assert(gameObject->mp_manager == this && "[CGameObjectMgr::Unregister] The game object belongs to another manager");
+		
+		const TGOHandle handle = gameObject->m_handle;
+		const unsigned int slot = (handle & 0xFFFFFFFF) >> SHARD_BITS;
+		
+		CShard& shard = ShardOf(handle);
+		{
+			std::lock_guard<std::mutex> lock(shard.m_mutex);
+			CSlot& entry = shard.m_slotList[slot];
+			assert(entry.mp_gameObject == gameObject && "[CGameObjectMgr::Unregister] The slot holds another game object");
+			
+			entry.mp_gameObject = 0;
+			// Zero is left for INVALID_HANDLE
+			if(++entry.m_generation == 0)
+			{
+				entry.m_generation = 1;
+			}
+			shard.m_freeList.push_back(slot);
+			--shard.m_count;
+		}
+		
+		gameObject->mp_manager = 0;
+		gameObject->m_handle = INVALID_HANDLE;
+	}
+	
+	CScene* CGameObjectMgr::CreateScene(const char* name)
+	{
+		CScene* scene = new CScene(name);
+		scene->ThreadPool(mp_threadPool.get());
+		const int worker = m_nextAffinity++ % mp_threadPool->WorkerCount();
+		m_sceneList.push_back(CManagedScene { scene, worker });
+		return scene;
+	}
+	
+	void CGameObjectMgr::DestroyScene(CScene* scene)
+	{
+		assert(scene && "[CGameObjectMgr::DestroyScene] scene can't be NULL");
+		
+		auto it = std::find_if(m_sceneList.begin(), m_sceneList.end(), [scene](const CManagedScene& managedScene) { return managedScene.mp_scene == scene; });
+		assert(it != m_sceneList.end() && "[CGameObjectMgr::DestroyScene] The scene wasn't created by this manager");
+		
+		m_sceneList.erase(it);
+		delete scene;
+	}
+	
+	void CGameObjectMgr::Update()
+	{
+		DC_PROFILE_SCOPE("CGameObjectMgr::Update");
+		
+		CJobCounter counter;
+		for(const CManagedScene& managedScene : m_sceneList)
+		{
+			CScene* scene = managedScene.mp_scene;
+			mp_threadPool->Submit([scene] { scene->Update(); }, &counter, managedScene.m_worker);
+		}
+		mp_threadPool->Wait(counter);
 	}
 }
@@ -0,0 +1,528 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "deltacodec.h"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_set>
+
+#include "components/scene.h"
+#include "components/transform.h"
+
+namespace dc
+{
+	namespace
+	{
+		enum EChangeMask
+		{
+			CHANGED_PARENT		= 1 << 0,
+			CHANGED_NAME		= 1 << 1,
+			CHANGED_POSITION	= 1 << 2,
+			CHANGED_ROTATION	= 1 << 3,
+			CHANGED_SCALE		= 1 << 4,
+			CHANGED_PAYLOADS	= 1 << 5
+		};
+		
+		template<unsigned int N>
+		const bool Equals(const int32_t (&a)[N], const int32_t (&b)[N])
+		{
+			return std::equal(a, a + N, b);
+		}
+		
+		template<unsigned int N>
+		void WriteValues(CByteWriter& writer, const int32_t (&values)[N])
+		{
+			for(const int32_t value : values)
+			{
+				writer.WriteVarInt(value);
+			}
+		}
+		
+		template<unsigned int N>
+		void ReadValues(CByteReader& reader, int32_t (&values)[N])
+		{
+			for(int32_t& value : values)
+			{
+				value = reader.ReadVarInt();
+			}
+		}
+		
+		// Small changes between ticks turn into small varints
+		template<unsigned int N>
+		void WriteDeltas(CByteWriter& writer, const int32_t (&baseline)[N], const int32_t (&values)[N])
+		{
+			for(unsigned int i = 0; i < N; ++i)
+			{
+				writer.WriteVarInt(values[i] - baseline[i]);
+			}
+		}
+		
+		template<unsigned int N>
+		void ReadDeltas(CByteReader& reader, int32_t (&values)[N])
+		{
+			for(int32_t& value : values)
+			{
+				value += reader.ReadVarInt();
+			}
+		}
+		
+		void WritePayloads(CByteWriter& writer, const TSnapshotPayloadList& payloadList)
+		{
+			writer.WriteVarUInt(payloadList.size());
+			for(const CSnapshotPayload& payload : payloadList)
+			{
+				writer.WriteVarUInt(payload.m_type);
+				writer.WriteBytes(payload.m_data.data(), payload.m_data.size());
+			}
+		}
+		
+		void ReadPayloads(CByteReader& reader, TSnapshotPayloadList& payloadList)
+		{
+			const uint64_t count = reader.ReadVarUInt();
+			payloadList.clear();
+			for(uint64_t i = 0; i < count && !reader.Error(); ++i)
+			{
+				CSnapshotPayload payload;
+				payload.m_type = reader.ReadVarUInt();
+				
+				size_t size;
+				const uint8_t* data = reader.ReadBytes(size);
+				payload.m_data.assign(data, data + size);
+				payloadList.push_back(payload);
+			}
+		}
+	}
+	
+	// ===========================================================
+	// CDeltaEncoder
+	// ===========================================================
+	
+	void CDeltaEncoder::Encode(const CSceneSnapshot& baseline, const CSceneSnapshot& current, CByteWriter& writer)
+	{
+		const size_t startSize = writer.Size();
+		
+		std::vector<uint32_t> removedIdList;
+		std::vector<const CSnapshotEntry*> createdList;
+		std::vector<std::pair<const CSnapshotEntry*, const CSnapshotEntry*>> changedList;
+		
+		// Both entry lists are sorted by id
+		const TSnapshotEntryList& baseEntryList = baseline.Entries();
+		const TSnapshotEntryList& entryList = current.Entries();
+		unsigned int b = 0, c = 0;
+		
+		while(b < baseEntryList.size() || c < entryList.size())
+		{
+			if(c == entryList.size() || (b < baseEntryList.size() && baseEntryList[b].m_id < entryList[c].m_id))
+			{
+				removedIdList.push_back(baseEntryList[b++].m_id);
+			}
+			else if(b == baseEntryList.size() || entryList[c].m_id < baseEntryList[b].m_id)
+			{
+				createdList.push_back(&entryList[c++]);
+			}
+			else
+			{
+				changedList.emplace_back(&baseEntryList[b++], &entryList[c++]);
+			}
+		}
+		
+		writer.WriteVarUInt(baseline.Tick());
+		writer.WriteVarUInt(current.Tick());
+		
+		// Ids are written as increments over the previous one
+		writer.WriteVarUInt(removedIdList.size());
+		uint32_t previousId = 0;
+		for(const uint32_t id : removedIdList)
+		{
+			writer.WriteVarUInt(id - previousId);
+			previousId = id;
+		}
+		
+		writer.WriteVarUInt(createdList.size());
+		previousId = 0;
+		for(const CSnapshotEntry* entry : createdList)
+		{
+			writer.WriteVarUInt(entry->m_id - previousId);
+			previousId = entry->m_id;
+			
+			writer.WriteVarUInt(entry->m_parentId);
+			writer.WriteString(entry->m_name);
+			WriteValues(writer, entry->m_position);
+			WriteValues(writer, entry->m_rotation);
+			WriteValues(writer, entry->m_scale);
+			WritePayloads(writer, entry->m_payloadList);
+		}
+		
+		// The changed count is only known after filtering, so the changes go to their own buffer
+		CByteWriter changesWriter;
+		unsigned int changedCount = 0;
+		previousId = 0;
+		
+		for(const auto& changedEntry : changedList)
+		{
+			const CSnapshotEntry& base = *changedEntry.first;
+			const CSnapshotEntry& entry = *changedEntry.second;
+			
+			uint8_t mask = 0;
+			mask |= base.m_parentId != entry.m_parentId ? CHANGED_PARENT : 0;
+			mask |= base.m_name != entry.m_name ? CHANGED_NAME : 0;
+			mask |= !Equals(base.m_position, entry.m_position) ? CHANGED_POSITION : 0;
+			mask |= !Equals(base.m_rotation, entry.m_rotation) ? CHANGED_ROTATION : 0;
+			mask |= !Equals(base.m_scale, entry.m_scale) ? CHANGED_SCALE : 0;
+			mask |= base.m_payloadList != entry.m_payloadList ? CHANGED_PAYLOADS : 0;
+			
+			if(mask == 0)
+			{
+				continue;
+			}
+			
+			++changedCount;
+			changesWriter.WriteVarUInt(entry.m_id - previousId);
+			previousId = entry.m_id;
+			changesWriter.WriteByte(mask);
+			
+			if(mask & CHANGED_PARENT)	changesWriter.WriteVarUInt(entry.m_parentId);
+			if(mask & CHANGED_NAME)		changesWriter.WriteString(entry.m_name);
+			if(mask & CHANGED_POSITION)	WriteDeltas(changesWriter, base.m_position, entry.m_position);
+			if(mask & CHANGED_ROTATION)	WriteDeltas(changesWriter, base.m_rotation, entry.m_rotation);
+			if(mask & CHANGED_SCALE)	WriteDeltas(changesWriter, base.m_scale, entry.m_scale);
+			if(mask & CHANGED_PAYLOADS)	WritePayloads(changesWriter, entry.m_payloadList);
+		}
+		
+		writer.WriteVarUInt(changedCount);
+		for(const uint8_t byte : changesWriter.Bytes())
+		{
+			writer.WriteByte(byte);
+		}
+		
+		m_lastBytes = writer.Size() - startSize;
+		m_totalBytes += m_lastBytes;
+		++m_encodedCount;
+	}
+	
+	// ===========================================================
+	// CDeltaDecoder
+	// ===========================================================
+	
+	CDeltaDecoder::CDeltaDecoder(CScene& scene, const CQuantization& quantization, const CReplicationRegistry* registry):
+		m_scene(scene),
+		m_quantization(quantization),
+		mp_registry(registry)
+	{}
+	
+	CDeltaDecoder::~CDeltaDecoder()
+	{
+		// Live replicas belong to the scene like any other game object,
+		// removed ones can only be deleted once the scene let them go
+		for(CGameObject* gameObject : m_removedList)
+		{
+			if(!gameObject->Scene())
+			{
+				delete gameObject;
+			}
+		}
+	}
+	
+	CGameObject* CDeltaDecoder::Replica(const uint32_t remoteId) const
+	{
+		const auto& replicaEntryIt = m_replicaTable.find(remoteId);
+		return replicaEntryIt != m_replicaTable.end() ? replicaEntryIt->second.mp_gameObject : 0;
+	}
+	
+	const bool CDeltaDecoder::Apply(const uint8_t* data, const size_t size)
+	{
+		CByteReader reader(data, size);
+		
+		const uint64_t baselineTick = reader.ReadVarUInt();
+		const uint64_t tick = reader.ReadVarUInt();
+		if(reader.Error() || baselineTick != m_state.Tick())
+		{
+			return false;
+		}
+		
+		// Everything is parsed and validated before touching the scene
+		std::vector<uint32_t> removedIdList(reader.ReadVarUInt());
+		uint32_t id = 0;
+		for(uint32_t& removedId : removedIdList)
+		{
+			id += reader.ReadVarUInt();
+			removedId = id;
+			if(!m_state.Find(id))
+			{
+				return false;
+			}
+		}
+		
+		const std::unordered_set<uint32_t> removedIdSet(removedIdList.begin(), removedIdList.end());
+		
+		TSnapshotEntryList createdList(reader.ReadVarUInt());
+		std::unordered_set<uint32_t> createdIdSet;
+		id = 0;
+		for(CSnapshotEntry& entry : createdList)
+		{
+			id += reader.ReadVarUInt();
+			// Ids are never zero, that means no parent, nor created twice or over a live replica
+			if(reader.Error() || !id || !createdIdSet.insert(id).second || (m_state.Find(id) && !removedIdSet.count(id)))
+			{
+				return false;
+			}
+			
+			entry.m_id = id;
+			entry.m_parentId = reader.ReadVarUInt();
+			entry.m_name = reader.ReadString();
+			ReadValues(reader, entry.m_position);
+			ReadValues(reader, entry.m_rotation);
+			ReadValues(reader, entry.m_scale);
+			ReadPayloads(reader, entry.m_payloadList);
+		}
+		
+		std::vector<std::pair<CSnapshotEntry, uint8_t>> changedList(reader.ReadVarUInt());
+		id = 0;
+		for(auto& changedEntry : changedList)
+		{
+			id += reader.ReadVarUInt();
+			const CSnapshotEntry* base = m_state.Find(id);
+			if(!base || reader.Error())
+			{
+				return false;
+			}
+			
+			CSnapshotEntry& entry = changedEntry.first;
+			entry = *base;
+			
+			const uint8_t mask = reader.ReadByte();
+			changedEntry.second = mask;
+			
+			if(mask & CHANGED_PARENT)	entry.m_parentId = reader.ReadVarUInt();
+			if(mask & CHANGED_NAME)		entry.m_name = reader.ReadString();
+			if(mask & CHANGED_POSITION)	ReadDeltas(reader, entry.m_position);
+			if(mask & CHANGED_ROTATION)	ReadDeltas(reader, entry.m_rotation);
+			if(mask & CHANGED_SCALE)	ReadDeltas(reader, entry.m_scale);
+			if(mask & CHANGED_PAYLOADS)	ReadPayloads(reader, entry.m_payloadList);
+		}
+		
+		if(reader.Error() || !reader.AtEnd())
+		{
+			return false;
+		}
+		
+		// Parents have to be a replica that survives this delta or one created by it
+		const auto validParent = [&](const uint32_t parentId)
+		{
+			return !parentId || createdIdSet.count(parentId) || (m_state.Find(parentId) && !removedIdSet.count(parentId));
+		};
+		
+		for(const CSnapshotEntry& entry : createdList)
+		{
+			if(entry.m_parentId == entry.m_id || !validParent(entry.m_parentId))
+			{
+				return false;
+			}
+		}
+		
+		for(const auto& changedEntry : changedList)
+		{
+			const CSnapshotEntry& entry = changedEntry.first;
+			if(removedIdSet.count(entry.m_id) || entry.m_parentId == entry.m_id || !validParent(entry.m_parentId))
+			{
+				return false;
+			}
+		}
+		
+		// Game objects removed by the previous delta can go once the scene is done with them
+		TGOList pendingList;
+		for(CGameObject* gameObject : m_removedList)
+		{
+			if(gameObject->Scene())
+			{
+				pendingList.push_back(gameObject);
+			}
+			else
+			{
+				delete gameObject;
+			}
+		}
+		m_removedList.swap(pendingList);
+		
+		// New state
+		CSceneSnapshot state;
+		state.Tick(tick);
+		TSnapshotEntryList& stateEntryList = state.Entries();
+		stateEntryList.reserve(m_state.Entries().size() + createdList.size() - removedIdList.size());
+		
+		unsigned int c = 0;
+		for(const CSnapshotEntry& entry : m_state.Entries())
+		{
+			if(removedIdSet.count(entry.m_id))
+			{
+				continue;
+			}
+			
+			if(c < changedList.size() && changedList[c].first.m_id == entry.m_id)
+			{
+				stateEntryList.push_back(changedList[c++].first);
+			}
+			else
+			{
+				stateEntryList.push_back(entry);
+			}
+		}
+		
+		stateEntryList.insert(stateEntryList.end(), createdList.begin(), createdList.end());
+		std::sort(stateEntryList.begin(), stateEntryList.end(), [](const CSnapshotEntry& a, const CSnapshotEntry& b)
+		{
+			return a.m_id < b.m_id;
+		});
+		
+		// Created game objects are linked between them before entering the scene,
+		// only the roots of new hierarchies are added, the scene adds their children
+		for(const CSnapshotEntry& entry : createdList)
+		{
+			Create(entry);
+		}
+		
+		for(const CSnapshotEntry& entry : createdList)
+		{
+			if(entry.m_parentId)
+			{
+				CGameObject* parent = Replica(entry.m_parentId);
+				assert(parent && "[CDeltaDecoder::Apply] Unknown parent");
+				Replica(entry.m_id)->Transform()->Parent(parent->Transform());
+			}
+		}
+		
+		for(const CSnapshotEntry& entry : createdList)
+		{
+			if(!createdIdSet.count(entry.m_parentId))
+			{
+				m_scene.Add(Replica(entry.m_id));
+			}
+		}
+		
+		for(const auto& changedEntry : changedList)
+		{
+			const CSnapshotEntry& entry = changedEntry.first;
+			const uint8_t mask = changedEntry.second;
+			
+			CReplica& replica = m_replicaTable[entry.m_id];
+			CGameObject* gameObject = replica.mp_gameObject;
+			
+			if(mask & CHANGED_PARENT)
+			{
+				if(entry.m_parentId)
+				{
+					gameObject->Transform()->Parent(Replica(entry.m_parentId)->Transform());
+				}
+				else
+				{
+					gameObject->Transform()->Detach();
+				}
+			}
+			
+			if(mask & CHANGED_NAME)
+			{
+				replica.m_name = entry.m_name;
+				gameObject->Name(replica.m_name.c_str());
+			}
+			
+			if(mask & (CHANGED_POSITION | CHANGED_ROTATION | CHANGED_SCALE))
+			{
+				ApplyTransform(gameObject, entry);
+			}
+			
+			if(mask & CHANGED_PAYLOADS)
+			{
+				ApplyPayloads(gameObject, entry);
+			}
+		}
+		
+		// Removing a game object removes its hierarchy from the scene, so only the topmost removed ones are removed
+		for(const uint32_t removedId : removedIdList)
+		{
+			CGameObject* gameObject = Replica(removedId);
+			const uint32_t parentId = m_state.Find(removedId)->m_parentId;
+			
+			if(!removedIdSet.count(parentId))
+			{
+				gameObject->Transform()->Detach();
+				m_scene.Remove(gameObject);
+			}
+			
+			m_removedList.push_back(gameObject);
+			m_replicaTable.erase(removedId);
+		}
+		
+		m_state = std::move(state);
+		return true;
+	}
+	
+	CGameObject* CDeltaDecoder::Create(const CSnapshotEntry& entry)
+	{
+		CReplica& replica = m_replicaTable[entry.m_id];
+		replica.m_name = entry.m_name;
+		replica.mp_gameObject = new CGameObject(replica.m_name.c_str());
+		
+		ApplyTransform(replica.mp_gameObject, entry);
+		ApplyPayloads(replica.mp_gameObject, entry);
+		return replica.mp_gameObject;
+	}
+	
+	void CDeltaDecoder::ApplyTransform(CGameObject* gameObject, const CSnapshotEntry& entry)
+	{
+		CTransform* transform = gameObject->Transform();
+		
+		transform->LocalPosition(math::Vector3f(
+			m_quantization.DequantizePosition(entry.m_position[0]),
+			m_quantization.DequantizePosition(entry.m_position[1]),
+			m_quantization.DequantizePosition(entry.m_position[2])));
+		
+		math::Quaternionf rotation;
+		rotation.x = m_quantization.DequantizeRotation(entry.m_rotation[0]);
+		rotation.y = m_quantization.DequantizeRotation(entry.m_rotation[1]);
+		rotation.z = m_quantization.DequantizeRotation(entry.m_rotation[2]);
+		rotation.w = m_quantization.DequantizeRotation(entry.m_rotation[3]);
+		transform->LocalRotation(rotation);
+		
+		transform->LocalScale(math::Vector3f(
+			m_quantization.DequantizeScale(entry.m_scale[0]),
+			m_quantization.DequantizeScale(entry.m_scale[1]),
+			m_quantization.DequantizeScale(entry.m_scale[2])));
+	}
+	
+	void CDeltaDecoder::ApplyPayloads(CGameObject* gameObject, const CSnapshotEntry& entry)
+	{
+		if(!mp_registry)
+		{
+			return;
+		}
+		
+		const CReplicationRegistry::TEntryList& typeList = mp_registry->Entries();
+		for(const CSnapshotPayload& payload : entry.m_payloadList)
+		{
+			if(payload.m_type >= typeList.size())
+			{
+				continue;
+			}
+			
+			const CReplicationRegistry::CEntry& type = typeList[payload.m_type];
+			CComponent* component = gameObject->Components().Find(type.mp_typeName);
+			if(!component)
+			{
+				component = type.m_create(gameObject);
+			}
+			
+			CByteReader reader(payload.m_data.data(), payload.m_data.size());
+			type.m_read(component, reader);
+		}
+	}
+}
@@ -0,0 +1,255 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "scenerecorder.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+#include "components/gameobject.h"
+#include "components/scene.h"
+
+namespace dc
+{
+	const uint32_t CSceneRecorder::MAGIC;
+	const uint32_t CSceneRecorder::VERSION;
+	
+	// ===========================================================
+	// Getter & Setter
+	// ===========================================================
+	
+	TByteList CSceneRecorder::Bytes() const
+	{
+		CByteWriter header;
+		for(unsigned int i = 0; i < 4; ++i)
+		{
+			header.WriteByte(uint8_t(MAGIC >> (i * 8)));
+		}
+		header.WriteVarUInt(VERSION);
+		header.WriteVarUInt(sizeof(math::Matrix4x4f));
+		
+		TByteList byteList(header.Bytes());
+		byteList.insert(byteList.end(), m_writer.Bytes().begin(), m_writer.Bytes().end());
+		return byteList;
+	}
+	
+	// ===========================================================
+	// Constructors
+	// ===========================================================
+	
+	CSceneRecorder::CSceneRecorder():
+		m_nextRecordId(1),
+		m_frameCount(0)
+	{}
+	
+	// ===========================================================
+	// Methods
+	// ===========================================================
+	
+	const bool CSceneRecorder::Save(const char* path) const
+	{
+		std::ofstream file(path, std::ios::binary);
+		if(!file)
+		{
+			return false;
+		}
+		
+		const TByteList byteList = Bytes();
+		file.write((const char*)byteList.data(), byteList.size());
+		return file.good();
+	}
+	
+	void CSceneRecorder::Begin(const CScene& scene)
+	{
+		// Pending ones included, only the roots, Add takes their children
+		TGOList gameObjectList(scene.GameObjects());
+		gameObjectList.insert(gameObjectList.end(), scene.PendingGameObjects().begin(), scene.PendingGameObjects().end());
+		
+		for(CGameObject* gameObject : gameObjectList)
+		{
+			const CTransform* parent = gameObject->Transform()->Parent();
+			if(!parent || parent->GameObject()->Scene() != &scene)
+			{
+				Add(gameObject);
+			}
+		}
+	}
+	
+	void CSceneRecorder::Frame()
+	{
+		m_writer.WriteByte((uint8_t)EReplayOp::Frame);
+		++m_frameCount;
+	}
+	
+	void CSceneRecorder::Add(CGameObject* gameObject)
+	{
+		assert(gameObject && "[CSceneRecorder::Add] game object can't be NULL");
+		
+		// Pre-order, so every parent is written before its children
+		TGOList hierarchyList(1, gameObject);
+		for(unsigned int i = 0; i < hierarchyList.size(); ++i)
+		{
+			CTransform* transform = hierarchyList[i]->Transform();
+			for(auto it = transform->Begin(), end = transform->End(); it != end; ++it)
+			{
+				hierarchyList.push_back((*it)->GameObject());
+			}
+		}
+		
+		m_writer.WriteByte((uint8_t)EReplayOp::Add);
+		m_writer.WriteVarUInt(hierarchyList.size());
+		
+		for(const CGameObject* child : hierarchyList)
+		{
+			const CTransform* transform = child->Transform();
+			
+			m_writer.WriteVarUInt(RecordId(child));
+			m_writer.WriteVarUInt(transform->HasParent() ? RecordId(transform->Parent()) : 0);
+			m_writer.WriteString(child->Name() ? child->Name() : "");
+			m_writer.WriteByte(uint8_t(child->Active()) | uint8_t(transform->Frozen()) << 1);
+			
+			const math::Matrix4x4f& matrix = transform->LocalMatrix();
+			m_writer.WriteBytes((const uint8_t*)&matrix, sizeof(matrix));
+			
+			// The transform is always the first component and comes with the game object
+			const CComponentSlots& components = child->Components();
+			m_writer.WriteVarUInt(components.Size() - 1);
+			for(unsigned int i = 1; i < components.Size(); ++i)
+			{
+				m_writer.WriteString(components.Name(i));
+			}
+		}
+	}
+	
+	void CSceneRecorder::Remove(CGameObject* gameObject)
+	{
+		WriteOp(EReplayOp::Remove, RecordId(gameObject));
+	}
+	
+	void CSceneRecorder::Destroy(CGameObject* gameObject)
+	{
+		WriteOp(EReplayOp::Destroy, RecordId(gameObject));
+	}
+	
+	void CSceneRecorder::AddComponent(const CGameObject* gameObject, const char* name)
+	{
+		WriteOp(EReplayOp::AddComponent, RecordId(gameObject));
+		m_writer.WriteString(name);
+	}
+	
+	void CSceneRecorder::RemoveComponent(const CGameObject* gameObject, const char* name)
+	{
+		WriteOp(EReplayOp::RemoveComponent, RecordId(gameObject));
+		m_writer.WriteString(name);
+	}
+	
+	void CSceneRecorder::Active(const CGameObject* gameObject, const bool active)
+	{
+		WriteOp(EReplayOp::Active, RecordId(gameObject));
+		m_writer.WriteByte(active);
+	}
+	
+	void CSceneRecorder::Parent(const CTransform* child, const CTransform* parent)
+	{
+		WriteOp(EReplayOp::Parent, RecordId(child));
+		m_writer.WriteVarUInt(RecordId(parent));
+	}
+	
+	void CSceneRecorder::RemoveChild(const CTransform* parent, const CTransform* child)
+	{
+		WriteOp(EReplayOp::RemoveChild, RecordId(parent));
+		m_writer.WriteVarUInt(RecordId(child));
+	}
+	
+	void CSceneRecorder::Detach(const CTransform* transform)
+	{
+		WriteOp(EReplayOp::Detach, RecordId(transform));
+	}
+	
+	void CSceneRecorder::Reparent(const TReparentList& reparentList)
+	{
+		m_writer.WriteByte((uint8_t)EReplayOp::Reparent);
+		m_writer.WriteVarUInt(reparentList.size());
+		for(const CReparent& reparent : reparentList)
+		{
+			m_writer.WriteVarUInt(RecordId(reparent.mp_child));
+			m_writer.WriteVarUInt(reparent.mp_parent ? RecordId(reparent.mp_parent) : 0);
+		}
+	}
+	
+	void CSceneRecorder::LocalMatrix(const CTransform* transform, const math::Matrix4x4f& matrix)
+	{
+		WriteOp(EReplayOp::LocalMatrix, RecordId(transform));
+		m_writer.WriteBytes((const uint8_t*)&matrix, sizeof(matrix));
+	}
+	
+	void CSceneRecorder::LocalPosition(const CTransform* transform, const math::Vector3f& position)
+	{
+		WriteOp(EReplayOp::LocalPosition, RecordId(transform));
+		WriteVector(position);
+	}
+	
+	void CSceneRecorder::LocalRotation(const CTransform* transform, const math::Quaternionf& rotation)
+	{
+		WriteOp(EReplayOp::LocalRotation, RecordId(transform));
+		m_writer.WriteFloat(rotation.x);
+		m_writer.WriteFloat(rotation.y);
+		m_writer.WriteFloat(rotation.z);
+		m_writer.WriteFloat(rotation.w);
+	}
+	
+	void CSceneRecorder::LocalScale(const CTransform* transform, const math::Vector3f& scale)
+	{
+		WriteOp(EReplayOp::LocalScale, RecordId(transform));
+		WriteVector(scale);
+	}
+	
+	void CSceneRecorder::Freeze(const CTransform* transform)
+	{
+		WriteOp(EReplayOp::Freeze, RecordId(transform));
+	}
+	
+	void CSceneRecorder::Unfreeze(const CTransform* transform)
+	{
+		WriteOp(EReplayOp::Unfreeze, RecordId(transform));
+	}
+	
+	const uint32_t CSceneRecorder::RecordId(const CGameObject* gameObject)
+	{
+		// Game object ids are never reused, so the map needs no cleaning while recording
+		auto inserted = m_recordIdMap.emplace(gameObject->Id(), m_nextRecordId);
+		if(inserted.second)
+		{
+			++m_nextRecordId;
+		}
+		return inserted.first->second;
+	}
+	
+	const uint32_t CSceneRecorder::RecordId(const CTransform* transform)
+	{
+		return RecordId(transform->GameObject());
+	}
+	
+	void CSceneRecorder::WriteOp(const EReplayOp op, const uint32_t recordId)
+	{
+		m_writer.WriteByte((uint8_t)op);
+		m_writer.WriteVarUInt(recordId);
+	}
+	
+	void CSceneRecorder::WriteVector(const math::Vector3f& vector)
+	{
+		m_writer.WriteFloat(vector.x);
+		m_writer.WriteFloat(vector.y);
+		m_writer.WriteFloat(vector.z);
+	}
+}
@@ -0,0 +1,514 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "scenereplayer.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "components/gameobject.h"
+#include "components/scene.h"
+
+namespace dc
+{
+	// ===========================================================
+	// Getter & Setter
+	// ===========================================================
+	
+	const unsigned int CSceneReplayer::GameObjectCount() const
+	{
+		return m_recordIdMap.size();
+	}
+	
+	// ===========================================================
+	// Constructors
+	// ===========================================================
+	
+	CSceneReplayer::CSceneReplayer(CScene& scene):
+		m_scene(scene),
+		m_cursor(0),
+		m_error(false),
+		m_frame(0)
+	{}
+	
+	CSceneReplayer::~CSceneReplayer()
+	{
+		for(CGameObject* gameObject : m_gameObjectList)
+		{
+			if(gameObject && !gameObject->Scene())
+			{
+				delete gameObject;
+			}
+		}
+	}
+	
+	// ===========================================================
+	// Methods
+	// ===========================================================
+	
+	const bool CSceneReplayer::Load(const TByteList& byteList)
+	{
+		CByteReader reader(byteList.data(), byteList.size());
+		
+		uint32_t magic = 0;
+		for(unsigned int i = 0; i < 4; ++i)
+		{
+			magic |= uint32_t(reader.ReadByte()) << (i * 8);
+		}
+		const uint64_t version = reader.ReadVarUInt();
+		const uint64_t matrixSize = reader.ReadVarUInt();
+		
+		if(reader.Error() || magic != CSceneRecorder::MAGIC || version != CSceneRecorder::VERSION || matrixSize != sizeof(math::Matrix4x4f))
+		{
+			m_error = true;
+			return false;
+		}
+		
+		m_byteList.assign(byteList.end() - reader.Remaining(), byteList.end());
+		m_cursor = 0;
+		m_error = false;
+		return true;
+	}
+	
+	const bool CSceneReplayer::Load(const char* path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if(!file)
+		{
+			m_error = true;
+			return false;
+		}
+		
+		const TByteList byteList((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		return Load(byteList);
+	}
+	
+	const bool CSceneReplayer::Step()
+	{
+		if(m_error)
+		{
+			return false;
+		}
+		
+		const size_t size = m_byteList.size();
+		CByteReader reader(m_byteList.data() + m_cursor, size - m_cursor);
+		while(!reader.AtEnd())
+		{
+			const EReplayOp op = (EReplayOp)reader.ReadByte();
+			if(op == EReplayOp::Frame)
+			{
+				m_cursor = size - reader.Remaining();
+				m_scene.Update();
+				++m_frame;
+				return true;
+			}
+			
+			if(!Apply(op, reader) || reader.Error())
+			{
+				m_error = true;
+				return false;
+			}
+		}
+		
+		// Changes after the last frame mark have no update to run in
+		m_cursor = size;
+		return false;
+	}
+	
+	const bool CSceneReplayer::Apply(const EReplayOp op, CByteReader& reader)
+	{
+		switch(op)
+		{
+			case EReplayOp::Add:
+			{
+				ApplyAdd(reader);
+				break;
+			}
+			case EReplayOp::Remove:
+			{
+				CGameObject* gameObject = LookupInScene(reader.ReadVarUInt());
+				if(gameObject)
+				{
+					m_scene.Remove(gameObject);
+				}
+				break;
+			}
+			case EReplayOp::Destroy:
+			{
+				CGameObject* gameObject = LookupInScene(reader.ReadVarUInt());
+				if(!gameObject)
+				{
+					break;
+				}
+				
+				// The scene deletes the whole hierarchy, it's not ours anymore
+				TGOList hierarchyList(1, gameObject);
+				for(unsigned int i = 0; i < hierarchyList.size(); ++i)
+				{
+					CTransform* transform = hierarchyList[i]->Transform();
+					for(auto it = transform->Begin(), end = transform->End(); it != end; ++it)
+					{
+						hierarchyList.push_back((*it)->GameObject());
+					}
+				}
+				for(CGameObject* child : hierarchyList)
+				{
+					auto recordIdIt = m_recordIdMap.find(child);
+					if(recordIdIt != m_recordIdMap.end())
+					{
+						m_gameObjectList[recordIdIt->second] = 0;
+						m_recordIdMap.erase(recordIdIt);
+					}
+				}
+				m_scene.Destroy(gameObject);
+				break;
+			}
+			case EReplayOp::AddComponent:
+			{
+				CGameObject* gameObject = Lookup(reader.ReadVarUInt());
+				const char* name = Intern(reader);
+				CComponent* component = gameObject ? CreateComponent(name) : 0;
+				if(component)
+				{
+					gameObject->AddComponent(component);
+				}
+				break;
+			}
+			case EReplayOp::RemoveComponent:
+			{
+				CGameObject* gameObject = Lookup(reader.ReadVarUInt());
+				const char* name = Intern(reader);
+				if(gameObject)
+				{
+					// The transform can't go
+					m_error = strcmp(name, CTransform::TypeName()) == 0;
+					if(!m_error)
+					{
+						gameObject->RemoveComponent(name);
+					}
+				}
+				break;
+			}
+			case EReplayOp::Active:
+			{
+				CGameObject* gameObject = Lookup(reader.ReadVarUInt());
+				const bool active = reader.ReadByte() != 0;
+				if(gameObject)
+				{
+					gameObject->Active(active);
+				}
+				break;
+			}
+			case EReplayOp::Parent:
+			{
+				CTransform* child = LookupTransform(reader.ReadVarUInt());
+				CTransform* parent = LookupTransform(reader.ReadVarUInt());
+				if(child && parent && CanParent(child, parent))
+				{
+					child->Parent(parent);
+				}
+				break;
+			}
+			case EReplayOp::RemoveChild:
+			{
+				CTransform* parent = LookupTransform(reader.ReadVarUInt());
+				CTransform* child = LookupTransform(reader.ReadVarUInt());
+				if(parent && child)
+				{
+					m_error = !parent->HasChild(child);
+					if(!m_error)
+					{
+						parent->Remove(child);
+					}
+				}
+				break;
+			}
+			case EReplayOp::Detach:
+			{
+				CTransform* transform = LookupTransform(reader.ReadVarUInt());
+				if(transform)
+				{
+					transform->Detach();
+				}
+				break;
+			}
+			case EReplayOp::Reparent:
+			{
+				TReparentList reparentList(reader.ReadVarUInt());
+				for(CReparent& reparent : reparentList)
+				{
+					reparent.mp_child = LookupTransform(reader.ReadVarUInt());
+					const uint64_t parentId = reader.ReadVarUInt();
+					reparent.mp_parent = parentId ? LookupTransform(parentId) : 0;
+					if(reparent.mp_child && reparent.mp_parent)
+					{
+						CanParent(reparent.mp_child, reparent.mp_parent);
+					}
+				}
+				if(!m_error)
+				{
+					CTransform::Reparent(reparentList);
+				}
+				break;
+			}
+			case EReplayOp::LocalMatrix:
+			{
+				CTransform* transform = LookupTransform(reader.ReadVarUInt());
+				size_t size = 0;
+				const uint8_t* data = reader.ReadBytes(size);
+				if(transform && size == sizeof(math::Matrix4x4f))
+				{
+					math::Matrix4x4f matrix;
+					memcpy(&matrix, data, size);
+					transform->LocalMatrix(matrix);
+				}
+				break;
+			}
+			case EReplayOp::LocalPosition:
+			{
+				CTransform* transform = LookupTransform(reader.ReadVarUInt());
+				const math::Vector3f position = ReadVector(reader);
+				if(transform)
+				{
+					transform->LocalPosition(position);
+				}
+				break;
+			}
+			case EReplayOp::LocalRotation:
+			{
+				CTransform* transform = LookupTransform(reader.ReadVarUInt());
+				math::Quaternionf rotation;
+				rotation.x = reader.ReadFloat();
+				rotation.y = reader.ReadFloat();
+				rotation.z = reader.ReadFloat();
+				rotation.w = reader.ReadFloat();
+				if(transform)
+				{
+					transform->LocalRotation(rotation);
+				}
+				break;
+			}
+			case EReplayOp::LocalScale:
+			{
+				CTransform* transform = LookupTransform(reader.ReadVarUInt());
+				const math::Vector3f scale = ReadVector(reader);
+				if(transform)
+				{
+					transform->LocalScale(scale);
+				}
+				break;
+			}
+			case EReplayOp::Freeze:
+			{
+				CTransform* transform = LookupTransform(reader.ReadVarUInt());
+				if(transform)
+				{
+					transform->Freeze();
+				}
+				break;
+			}
+			case EReplayOp::Unfreeze:
+			{
+				CTransform* transform = LookupTransform(reader.ReadVarUInt());
+				if(transform)
+				{
+					transform->Unfreeze();
+				}
+				break;
+			}
+			default:
+			{
+				return false;
+			}
+		}
+		return !m_error;
+	}
+	
+	void CSceneReplayer::ApplyAdd(CByteReader& reader)
+	{
+		const uint64_t count = reader.ReadVarUInt();
+		if(count == 0 || count > reader.Remaining())
+		{
+			m_error = true;
+			return;
+		}
+		
+		CGameObject* root = 0;
+		TGOList frozenList;
+		for(uint64_t i = 0; i < count && !reader.Error(); ++i)
+		{
+			const uint64_t recordId = reader.ReadVarUInt();
+			const uint64_t parentId = reader.ReadVarUInt();
+			const char* name = Intern(reader);
+			const uint8_t flags = reader.ReadByte();
+			
+			size_t matrixSize = 0;
+			const uint8_t* matrixData = reader.ReadBytes(matrixSize);
+			
+			const uint64_t componentCount = reader.ReadVarUInt();
+			std::vector<const char*> componentNameList;
+			for(uint64_t component = 0; component < componentCount && !reader.Error(); ++component)
+			{
+				componentNameList.push_back(Intern(reader));
+			}
+			
+			if(reader.Error() || recordId == 0 || recordId > m_byteList.size() || matrixSize != sizeof(math::Matrix4x4f))
+			{
+				m_error = true;
+				return;
+			}
+			
+			if(recordId >= m_gameObjectList.size())
+			{
+				m_gameObjectList.resize(recordId + 1, 0);
+			}
+			
+			// Game objects added again are reused as they are, what happened to them out of the scene wasn't recorded
+			CGameObject* gameObject = m_gameObjectList[recordId];
+			if(gameObject && gameObject->Scene())
+			{
+				m_error = true;
+				return;
+			}
+			
+			if(!gameObject)
+			{
+				gameObject = new CGameObject(name);
+				m_gameObjectList[recordId] = gameObject;
+				m_recordIdMap[gameObject] = recordId;
+				
+				for(const char* componentName : componentNameList)
+				{
+					CComponent* component = CreateComponent(componentName);
+					if(component)
+					{
+						gameObject->AddComponent(component);
+					}
+				}
+				
+				math::Matrix4x4f matrix;
+				memcpy(&matrix, matrixData, matrixSize);
+				gameObject->Transform()->LocalMatrix(matrix);
+			}
+			gameObject->Active((flags & 1) != 0);
+			
+			CTransform* transform = gameObject->Transform();
+			if(parentId)
+			{
+				CTransform* parent = LookupTransform(parentId);
+				if(!parent || !CanParent(transform, parent))
+				{
+					return;
+				}
+				transform->Parent(parent);
+			}
+			else
+			{
+				transform->Detach();
+			}
+			
+			if(flags & 2)
+			{
+				frozenList.push_back(gameObject);
+			}
+			
+			root = root ? root : gameObject;
+		}
+		
+		// Freezing goes down the hierarchy, the frozen parents cover their children
+		for(CGameObject* gameObject : frozenList)
+		{
+			CTransform* parent = gameObject->Transform()->Parent();
+			if(!parent || !parent->Frozen())
+			{
+				gameObject->Transform()->Freeze();
+			}
+		}
+		
+		if(!m_error && !reader.Error())
+		{
+			m_scene.Add(root);
+		}
+	}
+	
+	CGameObject* CSceneReplayer::Lookup(const uint64_t recordId)
+	{
+		if(recordId == 0 || recordId >= m_gameObjectList.size() || !m_gameObjectList[recordId])
+		{
+			m_error = true;
+			return 0;
+		}
+		return m_gameObjectList[recordId];
+	}
+	
+	CTransform* CSceneReplayer::LookupTransform(const uint64_t recordId)
+	{
+		CGameObject* gameObject = Lookup(recordId);
+		return gameObject ? gameObject->Transform() : 0;
+	}
+	
+	CGameObject* CSceneReplayer::LookupInScene(const uint64_t recordId)
+	{
+		CGameObject* gameObject = Lookup(recordId);
+		if(gameObject && gameObject->Scene() != &m_scene)
+		{
+			m_error = true;
+			return 0;
+		}
+		return gameObject;
+	}
+	
+	const bool CSceneReplayer::CanParent(const CTransform* child, const CTransform* parent)
+	{
+		for(const CTransform* ancestor = parent; ancestor; ancestor = ancestor->Parent())
+		{
+			if(ancestor == child)
+			{
+				m_error = true;
+				return false;
+			}
+		}
+		return true;
+	}
+	
+	const char* CSceneReplayer::Intern(CByteReader& reader)
+	{
+		return m_nameSet.insert(reader.ReadString()).first->c_str();
+	}
+	
+	CComponent* CSceneReplayer::CreateComponent(const char* name)
+	{
+		// The transform comes with the game object
+		if(strcmp(name, CTransform::TypeName()) == 0)
+		{
+			m_error = true;
+			return 0;
+		}
+		
+		auto creatorIt = m_creatorMap.find(name);
+		if(creatorIt != m_creatorMap.end())
+		{
+			return creatorIt->second();
+		}
+		return new CReplayComponent(name);
+	}
+	
+	const math::Vector3f CSceneReplayer::ReadVector(CByteReader& reader)
+	{
+		const float x = reader.ReadFloat();
+		const float y = reader.ReadFloat();
+		const float z = reader.ReadFloat();
+		return math::Vector3f(x, y, z);
+	}
+}
@@ -0,0 +1,269 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "sharedsceneexporter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#define DC_SHARED_MEMORY
+#endif
+
+#include "components/gameobject.h"
+#include "components/scene.h"
+#include "components/transform.h"
+
+namespace dc
+{
+	const uint32_t CSharedSceneHeader::MAGIC;
+	const uint32_t CSharedSceneHeader::VERSION;
+	const unsigned int CSharedGameObject::NAME_SIZE;
+	const uint32_t CSharedGameObject::NO_PARENT;
+	
+	static_assert(sizeof(math::Matrix4x4f) == sizeof(CSharedGameObject::m_worldMatrix), "The shared matrices must match math::Matrix4x4f");
+	static_assert(CSparseIndex::NONE == CSharedGameObject::NO_PARENT, "Parents missing from the index must read as no parent");
+	
+	// ===========================================================
+	// Constructors
+	// ===========================================================
+	
+	CSharedSceneExporter::CSharedSceneExporter():
+		mp_header(0),
+		mp_entryList(0),
+		m_size(0),
+		mp_scene(0),
+		m_sceneVersion(0),
+		m_hierarchyVersion(0),
+		m_exportTick(0),
+		m_writtenCount(0),
+		m_stamp(0)
+	{}
+	
+	CSharedSceneExporter::~CSharedSceneExporter()
+	{
+		Close();
+	}
+	
+	// ===========================================================
+	// Methods
+	// ===========================================================
+	
+	const bool CSharedSceneExporter::Open(const char* name, const unsigned int capacity)
+	{
+		assert(name && "[CSharedSceneExporter::Open] name can't be NULL");
+		Close();
+		
+#if defined(DC_SHARED_MEMORY)
+		// Readers of a previous region keep it, this one starts clean
+		shm_unlink(name);
+		const int file = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+		if(file < 0)
+		{
+			return false;
+		}
+		
+		const size_t size = sizeof(CSharedSceneHeader) + (size_t)capacity * sizeof(CSharedGameObject);
+		void* memory = ftruncate(file, size) == 0 ? mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+		close(file);
+		if(memory == MAP_FAILED)
+		{
+			shm_unlink(name);
+			return false;
+		}
+		
+		// A new region is zero filled, the magic goes last so readers never see it half made
+		m_name = name;
+		m_size = size;
+		mp_header = new(memory) CSharedSceneHeader();
+		mp_entryList = (CSharedGameObject*)(mp_header + 1);
+		mp_header->m_version = CSharedSceneHeader::VERSION;
+		mp_header->m_capacity = capacity;
+		mp_header->m_entrySize = sizeof(CSharedGameObject);
+		mp_header->m_sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		mp_header->m_magic = CSharedSceneHeader::MAGIC;
+		return true;
+#else
+		(void)capacity;
+		return false;
+#endif
+	}
+	
+	void CSharedSceneExporter::Close()
+	{
+#if defined(DC_SHARED_MEMORY)
+		if(mp_header)
+		{
+			munmap(mp_header, m_size);
+			shm_unlink(m_name.c_str());
+		}
+#endif
+		mp_header = 0;
+		mp_entryList = 0;
+		m_size = 0;
+		mp_scene = 0;
+		m_index = CSparseIndex();
+		m_freeList.clear();
+		m_seenList.clear();
+	}
+	
+	void CSharedSceneExporter::Export(CScene& scene)
+	{
+		if(!mp_header)
+		{
+			return;
+		}
+		
+		// Odd while writing, readers that overlap with it try again
+		const uint64_t sequence = mp_header->m_sequence.load(std::memory_order_relaxed);
+		mp_header->m_sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		
+		m_writtenCount = 0;
+		if(mp_scene != &scene)
+		{
+			Clear();
+			mp_scene = &scene;
+			m_sceneVersion = ~scene.GameObjectsVersion();
+			m_exportTick = 0;
+		}
+		
+		if(m_sceneVersion != scene.GameObjectsVersion() || m_hierarchyVersion != scene.HierarchyVersion())
+		{
+			m_sceneVersion = scene.GameObjectsVersion();
+			m_hierarchyVersion = scene.HierarchyVersion();
+			SyncEntries(scene);
+			++mp_header->m_layoutVersion;
+		}
+		
+		scene.ForEachChanged<CTransform>(m_exportTick, [this, &scene](CTransform* transform)
+		{
+			const unsigned int index = m_index.Get(transform->GameObject()->Id());
+			if(index != CSparseIndex::NONE)
+			{
+				WriteMatrix(mp_entryList[index], transform, scene.Frame());
+				++m_writtenCount;
+			}
+		});
+		
+		mp_header->m_frame = scene.Frame();
+		mp_header->m_sceneCount = scene.GameObjects().size();
+		m_exportTick = scene.Tick();
+		
+		mp_header->m_sequence.store(sequence + 2, std::memory_order_release);
+	}
+	
+	void CSharedSceneExporter::Clear()
+	{
+		for(unsigned int i = 0; i < mp_header->m_count; ++i)
+		{
+			m_index.Clear(mp_entryList[i].m_id);
+			mp_entryList[i].m_id = 0;
+		}
+		mp_header->m_count = 0;
+		m_freeList.clear();
+		m_seenList.clear();
+	}
+	
+	void CSharedSceneExporter::SyncEntries(const CScene& scene)
+	{
+		// Entries stay where they are, so game objects coming and going only write their own
+		++m_stamp;
+		for(const CGameObject* gameObject : scene.GameObjects())
+		{
+			const unsigned int index = m_index.Get(gameObject->Id());
+			if(index != CSparseIndex::NONE)
+			{
+				m_seenList[index] = m_stamp;
+			}
+		}
+		
+		// Entries not seen belong to game objects that left the scene, and may not exist anymore
+		for(unsigned int i = 0; i < mp_header->m_count; ++i)
+		{
+			CSharedGameObject& entry = mp_entryList[i];
+			if(entry.m_id && m_seenList[i] != m_stamp)
+			{
+				m_index.Clear(entry.m_id);
+				entry.m_id = 0;
+				m_freeList.push_back(i);
+			}
+		}
+		
+		for(const CGameObject* gameObject : scene.GameObjects())
+		{
+			unsigned int index = m_index.Get(gameObject->Id());
+			if(index == CSparseIndex::NONE)
+			{
+				if(!m_freeList.empty())
+				{
+					index = m_freeList.back();
+					m_freeList.pop_back();
+				}
+				else if(mp_header->m_count < mp_header->m_capacity)
+				{
+					index = mp_header->m_count++;
+					m_seenList.push_back(m_stamp);
+				}
+				else
+				{
+					continue;
+				}
+				
+				m_index.Set(gameObject->Id(), index);
+				WriteEntry(index, gameObject);
+			}
+		}
+		
+		// Parents may come after their children in the list
+		for(const CGameObject* gameObject : scene.GameObjects())
+		{
+			const unsigned int index = m_index.Get(gameObject->Id());
+			if(index != CSparseIndex::NONE)
+			{
+				const CTransform* parent = gameObject->Transform()->Parent();
+				mp_entryList[index].m_parentIndex = parent ? m_index.Get(parent->GameObject()->Id()) : CSharedGameObject::NO_PARENT;
+			}
+		}
+	}
+	
+	void CSharedSceneExporter::WriteEntry(const unsigned int index, const CGameObject* gameObject)
+	{
+		CSharedGameObject& entry = mp_entryList[index];
+		entry.m_id = gameObject->Id();
+		
+		const char* name = gameObject->Name() ? gameObject->Name() : "";
+		strncpy(entry.m_name, name, CSharedGameObject::NAME_SIZE - 1);
+		entry.m_name[CSharedGameObject::NAME_SIZE - 1] = 0;
+		
+		WriteMatrix(entry, gameObject->Transform(), mp_scene->Frame());
+		++m_writtenCount;
+	}
+	
+	void CSharedSceneExporter::WriteMatrix(CSharedGameObject& entry, const CTransform* transform, const uint64_t frame)
+	{
+		const math::Matrix4x4f& worldMatrix = transform->WorldMatrix();
+		memcpy(entry.m_worldMatrix, &worldMatrix, sizeof(entry.m_worldMatrix));
+		
+		const math::Vector3f position = worldMatrix.Position();
+		entry.m_position[0] = position.x;
+		entry.m_position[1] = position.y;
+		entry.m_position[2] = position.z;
+		entry.m_changedFrame = frame;
+	}
+}
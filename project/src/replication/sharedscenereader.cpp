@@ -0,0 +1,106 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "sharedscenereader.h"
+
+#include <cassert>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#define DC_SHARED_MEMORY
+#endif
+
+namespace dc
+{
+	// ===========================================================
+	// Constructors
+	// ===========================================================
+	
+	CSharedSceneReader::CSharedSceneReader():
+		mp_header(0),
+		mp_entryList(0),
+		m_capacity(0),
+		m_size(0)
+	{}
+	
+	CSharedSceneReader::~CSharedSceneReader()
+	{
+		Close();
+	}
+	
+	// ===========================================================
+	// Methods
+	// ===========================================================
+	
+	const bool CSharedSceneReader::Open(const char* name)
+	{
+		assert(name && "[CSharedSceneReader::Open] name can't be NULL");
+		Close();
+		
+#if defined(DC_SHARED_MEMORY)
+		const int file = shm_open(name, O_RDONLY, 0);
+		if(file < 0)
+		{
+			return false;
+		}
+		
+		struct stat status;
+		const bool sized = fstat(file, &status) == 0 && (size_t)status.st_size >= sizeof(CSharedSceneHeader);
+		void* memory = sized ? mmap(0, status.st_size, PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+		close(file);
+		if(memory == MAP_FAILED)
+		{
+			return false;
+		}
+		
+		const size_t size = status.st_size;
+		const CSharedSceneHeader* header = (const CSharedSceneHeader*)memory;
+		
+		// The magic is written last, the rest is only valid once it's there
+		const bool created = header->m_magic == CSharedSceneHeader::MAGIC;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const bool valid = created && header->m_version == CSharedSceneHeader::VERSION
+			&& header->m_entrySize == sizeof(CSharedGameObject)
+			&& (size - sizeof(CSharedSceneHeader)) / sizeof(CSharedGameObject) >= header->m_capacity;
+		if(!valid)
+		{
+			munmap(memory, size);
+			return false;
+		}
+		
+		mp_header = header;
+		mp_entryList = (const CSharedGameObject*)(header + 1);
+		m_capacity = header->m_capacity;
+		m_size = size;
+		return true;
+#else
+		return false;
+#endif
+	}
+	
+	void CSharedSceneReader::Close()
+	{
+#if defined(DC_SHARED_MEMORY)
+		if(mp_header)
+		{
+			munmap((void*)mp_header, m_size);
+		}
+#endif
+		mp_header = 0;
+		mp_entryList = 0;
+		m_capacity = 0;
+		m_size = 0;
+	}
+}
@@ -0,0 +1,130 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "components/scene.h"
+#include "components/transform.h"
+
+namespace dc
+{
+	// ===========================================================
+	// CQuantization
+	// ===========================================================
+	
+	const int32_t CQuantization::QuantizePosition(const float value) const
+	{
+		return (int32_t)std::lround(value / m_positionStep);
+	}
+	
+	const int32_t CQuantization::QuantizeScale(const float value) const
+	{
+		return (int32_t)std::lround(value / m_scaleStep);
+	}
+	
+	const int32_t CQuantization::QuantizeRotation(const float value) const
+	{
+		assert(m_rotationBits > 1 && m_rotationBits <= 31 && "[CQuantization::QuantizeRotation] Invalid rotation bits");
+		const float range = float((1 << (m_rotationBits - 1)) - 1);
+		const float clamped = std::max(-1.0f, std::min(1.0f, value));
+		return (int32_t)std::lround(clamped * range);
+	}
+	
+	const float CQuantization::DequantizeRotation(const int32_t value) const
+	{
+		const float range = float((1 << (m_rotationBits - 1)) - 1);
+		return value / range;
+	}
+	
+	// ===========================================================
+	// CSceneSnapshot
+	// ===========================================================
+	
+	const CSnapshotEntry* CSceneSnapshot::Find(const uint32_t id) const
+	{
+		const auto& entryIt = std::lower_bound(m_entryList.begin(), m_entryList.end(), id, [](const CSnapshotEntry& entry, const uint32_t id)
+		{
+			return entry.m_id < id;
+		});
+		
+		if(entryIt != m_entryList.end() && entryIt->m_id == id)
+		{
+			return &(*entryIt);
+		}
+		return 0;
+	}
+	
+	void CSceneSnapshot::Capture(const CScene& scene, const CQuantization& quantization, const CReplicationRegistry* registry)
+	{
+		m_tick = scene.Tick();
+		
+		const TGOList& gameObjectList = scene.GameObjects();
+		m_entryList.resize(gameObjectList.size());
+		
+		for(unsigned int i = 0; i < gameObjectList.size(); ++i)
+		{
+			const CGameObject* gameObject = gameObjectList[i];
+			const CTransform* transform = gameObject->Transform();
+			CSnapshotEntry& entry = m_entryList[i];
+			
+			entry.m_id = gameObject->Id();
+			entry.m_parentId = transform->HasParent() ? transform->Parent()->GameObject()->Id() : 0;
+			entry.m_name = gameObject->Name();
+			
+			const math::Vector3f position = transform->LocalPosition();
+			entry.m_position[0] = quantization.QuantizePosition(position.x);
+			entry.m_position[1] = quantization.QuantizePosition(position.y);
+			entry.m_position[2] = quantization.QuantizePosition(position.z);
+			
+			const math::Quaternionf rotation = transform->LocalRotation();
+			entry.m_rotation[0] = quantization.QuantizeRotation(rotation.x);
+			entry.m_rotation[1] = quantization.QuantizeRotation(rotation.y);
+			entry.m_rotation[2] = quantization.QuantizeRotation(rotation.z);
+			entry.m_rotation[3] = quantization.QuantizeRotation(rotation.w);
+			
+			const math::Vector3f scale = transform->LocalScale();
+			entry.m_scale[0] = quantization.QuantizeScale(scale.x);
+			entry.m_scale[1] = quantization.QuantizeScale(scale.y);
+			entry.m_scale[2] = quantization.QuantizeScale(scale.z);
+			
+			entry.m_payloadList.clear();
+			if(registry)
+			{
+				// Only the first component of every registered type is replicated
+				const CComponentSlots& components = gameObject->Components();
+				const CReplicationRegistry::TEntryList& typeList = registry->Entries();
+				
+				for(unsigned int type = 0; type < typeList.size(); ++type)
+				{
+					CComponent* component = components.Find(typeList[type].mp_typeName);
+					if(!component)
+					{
+						continue;
+					}
+					
+					CByteWriter writer;
+					typeList[type].m_write(component, writer);
+					entry.m_payloadList.push_back(CSnapshotPayload { type, writer.Bytes() });
+				}
+			}
+		}
+		
+		std::sort(m_entryList.begin(), m_entryList.end(), [](const CSnapshotEntry& a, const CSnapshotEntry& b)
+		{
+			return a.m_id < b.m_id;
+		});
+	}
+}
@@ -0,0 +1,241 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "interestmanager.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "components/scene.h"
+#include "components/transform.h"
+
+#include "spatialgrid.h"
+
+namespace dc
+{
+	CInterestManager::CInterestManager(const CInterestSettings& settings):
+		m_settings(settings)
+	{
+		assert(settings.m_cellSize > 0.0f && "[CInterestManager::CInterestManager] Cell size must be positive");
+		assert(settings.m_exitRadius >= settings.m_enterRadius && "[CInterestManager::CInterestManager] The exit radius can't be smaller than the enter radius");
+	}
+	
+	const unsigned int CInterestManager::ActiveCellCount() const
+	{
+		unsigned int count = 0;
+		for(const auto& cellEntry : m_cellTable)
+		{
+			count += cellEntry.second.m_active ? 1 : 0;
+		}
+		return count;
+	}
+	
+	const unsigned int CInterestManager::AddObserver(const math::Vector3f& position)
+	{
+		for(unsigned int i = 0; i < m_observerList.size(); ++i)
+		{
+			if(!m_observerList[i].m_used)
+			{
+				m_observerList[i] = CObserver { position, true };
+				return i;
+			}
+		}
+		
+		m_observerList.push_back(CObserver { position, true });
+		return m_observerList.size() - 1;
+	}
+	
+	void CInterestManager::MoveObserver(const unsigned int observerId, const math::Vector3f& position)
+	{
+		assert(observerId < m_observerList.size() && m_observerList[observerId].m_used && "[CInterestManager::MoveObserver] Unknown observer");
+		m_observerList[observerId].m_position = position;
+	}
+	
+	void CInterestManager::RemoveObserver(const unsigned int observerId)
+	{
+		assert(observerId < m_observerList.size() && "[CInterestManager::RemoveObserver] Unknown observer");
+		m_observerList[observerId].m_used = false;
+	}
+	
+	void CInterestManager::Update(CScene& scene, const uint64_t sinceTick)
+	{
+		// Moved roots change cell, moved children just follow whatever their root says
+		scene.ForEachChanged<CTransform>(sinceTick, [this](CTransform* transform)
+		{
+			CGameObject* gameObject = transform->GameObject();
+			if(!transform->HasParent())
+			{
+				Place(gameObject);
+			}
+			else
+			{
+				Unplace(gameObject);
+				gameObject->Active(transform->Root()->GameObject()->Active());
+			}
+		});
+		
+		for(auto& cellEntry : m_cellTable)
+		{
+			CCell& cell = cellEntry.second;
+			const float distance = NearestObserverDistance(cell.m_center);
+			
+			if(!cell.m_active)
+			{
+				if(distance <= m_settings.m_enterRadius)
+				{
+					Activate(cell, true);
+				}
+			}
+			else if(distance > m_settings.m_exitRadius)
+			{
+				if(++cell.m_outsideFrames >= m_settings.m_exitDelayFrames)
+				{
+					Activate(cell, false);
+				}
+			}
+			else
+			{
+				cell.m_outsideFrames = 0;
+			}
+		}
+	}
+	
+	void CInterestManager::Remove(CGameObject* gameObject)
+	{
+		Unplace(gameObject);
+	}
+	
+	void CInterestManager::Place(CGameObject* root)
+	{
+		const math::Vector3f position = root->Transform()->Position();
+		const float inverseCellSize = 1.0f / m_settings.m_cellSize;
+		const int32_t x = (int32_t)std::floor(position.x * inverseCellSize);
+		const int32_t y = (int32_t)std::floor(position.y * inverseCellSize);
+		const int32_t z = (int32_t)std::floor(position.z * inverseCellSize);
+		const uint64_t cellKey = GridCellKey(x, y, z);
+		
+		const auto& rootEntryIt = m_rootCellTable.find(root);
+		if(rootEntryIt != m_rootCellTable.end())
+		{
+			if(rootEntryIt->second == cellKey)
+			{
+				return;
+			}
+			Unplace(root);
+		}
+		
+		auto cellEntryIt = m_cellTable.find(cellKey);
+		if(cellEntryIt == m_cellTable.end())
+		{
+			const math::Vector3f center((x + 0.5f) * m_settings.m_cellSize, (y + 0.5f) * m_settings.m_cellSize, (z + 0.5f) * m_settings.m_cellSize);
+			const bool active = NearestObserverDistance(center) <= m_settings.m_enterRadius;
+			cellEntryIt = m_cellTable.emplace(cellKey, CCell { center, TGOList(), active, 0 }).first;
+		}
+		
+		CCell& cell = cellEntryIt->second;
+		cell.m_rootList.push_back(root);
+		m_rootCellTable[root] = cellKey;
+		
+		if(root->Active() != cell.m_active)
+		{
+			Activate(root, cell.m_active);
+		}
+	}
+	
+	void CInterestManager::Unplace(CGameObject* root)
+	{
+		const auto& rootEntryIt = m_rootCellTable.find(root);
+		if(rootEntryIt == m_rootCellTable.end())
+		{
+			return;
+		}
+		
+		const auto& cellEntryIt = m_cellTable.find(rootEntryIt->second);
+		TGOList& rootList = cellEntryIt->second.m_rootList;
+		
+		const auto& it = std::find(rootList.begin(), rootList.end(), root);
+		*it = rootList.back();
+		rootList.pop_back();
+		
+		if(rootList.empty())
+		{
+			m_cellTable.erase(cellEntryIt);
+		}
+		m_rootCellTable.erase(rootEntryIt);
+	}
+	
+	void CInterestManager::Activate(CCell& cell, const bool active)
+	{
+		cell.m_active = active;
+		cell.m_outsideFrames = 0;
+		
+		for(CGameObject* root : cell.m_rootList)
+		{
+			Activate(root, active);
+		}
+	}
+	
+	void CInterestManager::Activate(CGameObject* root, const bool active)
+	{
+		// Iterative walk, hierarchies can be deep
+		TGOList pendingList(1, root);
+		while(!pendingList.empty())
+		{
+			CGameObject* gameObject = pendingList.back();
+			pendingList.pop_back();
+			
+			if(gameObject->Active() != active)
+			{
+				gameObject->Active(active);
+				
+				if(m_settings.m_notifyComponents)
+				{
+					for(CComponent* component : gameObject->Components())
+					{
+						if(active)
+						{
+							component->Start();
+						}
+						else
+						{
+							component->Sleep();
+						}
+					}
+				}
+			}
+			
+			for(CTransform* child : gameObject->Transform()->Children())
+			{
+				pendingList.push_back(child->GameObject());
+			}
+		}
+	}
+	
+	const float CInterestManager::NearestObserverDistance(const math::Vector3f& position) const
+	{
+		float nearest = std::numeric_limits<float>::max();
+		for(const CObserver& observer : m_observerList)
+		{
+			if(!observer.m_used)
+			{
+				continue;
+			}
+			
+			const float dx = observer.m_position.x - position.x;
+			const float dy = observer.m_position.y - position.y;
+			const float dz = observer.m_position.z - position.z;
+			nearest = std::min(nearest, dx * dx + dy * dy + dz * dz);
+		}
+		return std::sqrt(nearest);
+	}
+}
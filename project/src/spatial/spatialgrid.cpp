@@ -0,0 +1,332 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "spatialgrid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace dc
+{
+	namespace
+	{
+		const float DistanceSquared(const math::Vector3f& a, const math::Vector3f& b)
+		{
+			const float dx = a.x - b.x;
+			const float dy = a.y - b.y;
+			const float dz = a.z - b.z;
+			return dx * dx + dy * dy + dz * dz;
+		}
+		
+		const bool Inside(const math::Vector3f& point, const math::Vector3f& min, const math::Vector3f& max)
+		{
+			return point.x >= min.x && point.x <= max.x
+				&& point.y >= min.y && point.y <= max.y
+				&& point.z >= min.z && point.z <= max.z;
+		}
+	}
+	
+	CSpatialGrid::CSpatialGrid(const float cellSize):
+		m_cellSize(cellSize),
+		m_inverseCellSize(1.0f / cellSize)
+	{
+		assert(cellSize > 0.0f && "[CSpatialGrid::CSpatialGrid] Cell size must be positive");
+		Clear();
+	}
+	
+	void CSpatialGrid::Update(CGameObject* gameObject, const math::Vector3f& position)
+	{
+		assert(gameObject && "[CSpatialGrid::Update] game object can't be NULL");
+		
+		const uint64_t cellKey = CellKey(CellOf(position));
+		const auto& indexEntryIt = m_indexTable.find(gameObject);
+		
+		if(indexEntryIt == m_indexTable.end())
+		{
+			const unsigned int index = m_entryList.size();
+			m_entryList.push_back(CEntry { gameObject, position, cellKey, 0 });
+			m_indexTable[gameObject] = index;
+			AddToCell(index);
+			return;
+		}
+		
+		const unsigned int index = indexEntryIt->second;
+		CEntry& entry = m_entryList[index];
+		entry.m_position = position;
+		
+		if(entry.m_cellKey != cellKey)
+		{
+			RemoveFromCell(index);
+			entry.m_cellKey = cellKey;
+			AddToCell(index);
+		}
+	}
+	
+	void CSpatialGrid::Remove(CGameObject* gameObject)
+	{
+		const auto& indexEntryIt = m_indexTable.find(gameObject);
+		if(indexEntryIt == m_indexTable.end())
+		{
+			return;
+		}
+		
+		const unsigned int index = indexEntryIt->second;
+		const unsigned int lastIndex = m_entryList.size() - 1;
+		RemoveFromCell(index);
+		m_indexTable.erase(indexEntryIt);
+		
+		// The last entry takes the place of the removed one
+		if(index != lastIndex)
+		{
+			CEntry& lastEntry = m_entryList[lastIndex];
+			m_cellTable[lastEntry.m_cellKey][lastEntry.m_cellSlot] = index;
+			m_indexTable[lastEntry.mp_gameObject] = index;
+			m_entryList[index] = lastEntry;
+		}
+		m_entryList.pop_back();
+	}
+	
+	void CSpatialGrid::Clear()
+	{
+		m_entryList.clear();
+		m_indexTable.clear();
+		m_cellTable.clear();
+		
+		m_minCell = CCell { std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max() };
+		m_maxCell = CCell { std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::min() };
+	}
+	
+	void CSpatialGrid::QueryRadius(const math::Vector3f& center, const float radius, TGOList& result) const
+	{
+		const math::Vector3f extent(radius, radius, radius);
+		
+		TIndexList candidates;
+		GatherBox(CellOf(center - extent), CellOf(center + extent), candidates);
+		
+		const float radiusSquared = radius * radius;
+		for(const unsigned int index : candidates)
+		{
+			const CEntry& entry = m_entryList[index];
+			if(DistanceSquared(entry.m_position, center) <= radiusSquared)
+			{
+				result.push_back(entry.mp_gameObject);
+			}
+		}
+	}
+	
+	void CSpatialGrid::QueryBox(const math::Vector3f& min, const math::Vector3f& max, TGOList& result) const
+	{
+		TIndexList candidates;
+		GatherBox(CellOf(min), CellOf(max), candidates);
+		
+		for(const unsigned int index : candidates)
+		{
+			const CEntry& entry = m_entryList[index];
+			if(Inside(entry.m_position, min, max))
+			{
+				result.push_back(entry.mp_gameObject);
+			}
+		}
+	}
+	
+	void CSpatialGrid::QueryNearest(const math::Vector3f& point, const unsigned int k, TGOList& result) const
+	{
+		if(k == 0 || m_entryList.empty())
+		{
+			return;
+		}
+		
+		// Max heap with the best k candidates found so far
+		using TCandidate = std::pair<float, unsigned int>;
+		std::priority_queue<TCandidate> bestList;
+		
+		const CCell center = CellOf(point);
+		const int32_t maxRing = std::max(
+			std::max(std::max(center.x - m_minCell.x, m_maxCell.x - center.x), std::max(center.y - m_minCell.y, m_maxCell.y - center.y)),
+			std::max(center.z - m_minCell.z, m_maxCell.z - center.z));
+		
+		for(int32_t ring = 0; ring <= maxRing; ++ring)
+		{
+			// Only the shell of the cube at this ring distance
+			for(int32_t x = -ring; x <= ring; ++x)
+			{
+				for(int32_t y = -ring; y <= ring; ++y)
+				{
+					const bool onShell = std::abs(x) == ring || std::abs(y) == ring;
+					const int32_t zStep = onShell ? 1 : std::max(1, 2 * ring);
+					
+					for(int32_t z = -ring; z <= ring; z += zStep)
+					{
+						const TIndexList* cell = Cell(center.x + x, center.y + y, center.z + z);
+						if(!cell)
+						{
+							continue;
+						}
+						
+						for(const unsigned int index : *cell)
+						{
+							const float distanceSquared = DistanceSquared(m_entryList[index].m_position, point);
+							if(bestList.size() < k)
+							{
+								bestList.emplace(distanceSquared, index);
+							}
+							else if(distanceSquared < bestList.top().first)
+							{
+								bestList.pop();
+								bestList.emplace(distanceSquared, index);
+							}
+						}
+					}
+				}
+			}
+			
+			// Anything in further rings is at least ring cells away
+			const float ringDistance = ring * m_cellSize;
+			if(bestList.size() == k && bestList.top().first <= ringDistance * ringDistance)
+			{
+				break;
+			}
+		}
+		
+		const size_t first = result.size();
+		result.resize(first + bestList.size());
+		for(size_t i = result.size(); i > first; --i)
+		{
+			result[i - 1] = m_entryList[bestList.top().second].mp_gameObject;
+			bestList.pop();
+		}
+	}
+	
+	void CSpatialGrid::QueryRadius(const TPointList& centers, const float radius, std::vector<TGOList>& results) const
+	{
+		results.resize(centers.size());
+		
+		// Groups the queries by cell so each group gathers its candidates once
+		std::vector<std::pair<uint64_t, unsigned int>> queryList(centers.size());
+		for(unsigned int i = 0; i < centers.size(); ++i)
+		{
+			queryList[i] = std::make_pair(CellKey(CellOf(centers[i])), i);
+		}
+		std::sort(queryList.begin(), queryList.end());
+		
+		const float radiusSquared = radius * radius;
+		const int32_t cellRadius = (int32_t)std::ceil(radius * m_inverseCellSize);
+		TIndexList candidates;
+		
+		for(unsigned int begin = 0; begin < queryList.size();)
+		{
+			unsigned int end = begin + 1;
+			while(end < queryList.size() && queryList[end].first == queryList[begin].first)
+			{
+				++end;
+			}
+			
+			// Every point in the cell is covered by the cell neighbourhood grown by the radius
+			const CCell cell = CellOf(centers[queryList[begin].second]);
+			candidates.clear();
+			GatherBox(CCell { cell.x - cellRadius, cell.y - cellRadius, cell.z - cellRadius }, CCell { cell.x + cellRadius, cell.y + cellRadius, cell.z + cellRadius }, candidates);
+			
+			for(unsigned int q = begin; q < end; ++q)
+			{
+				const unsigned int queryIndex = queryList[q].second;
+				const math::Vector3f& center = centers[queryIndex];
+				TGOList& result = results[queryIndex];
+				
+				for(const unsigned int index : candidates)
+				{
+					const CEntry& entry = m_entryList[index];
+					if(DistanceSquared(entry.m_position, center) <= radiusSquared)
+					{
+						result.push_back(entry.mp_gameObject);
+					}
+				}
+			}
+			
+			begin = end;
+		}
+	}
+	
+	CSpatialGrid::CCell CSpatialGrid::CellOf(const math::Vector3f& position) const
+	{
+		return CCell {
+			(int32_t)std::floor(position.x * m_inverseCellSize),
+			(int32_t)std::floor(position.y * m_inverseCellSize),
+			(int32_t)std::floor(position.z * m_inverseCellSize)
+		};
+	}
+	
+	uint64_t CSpatialGrid::CellKey(const CCell& cell) const
+	{
+		return GridCellKey(cell.x, cell.y, cell.z);
+	}
+	
+	const CSpatialGrid::TIndexList* CSpatialGrid::Cell(const int32_t x, const int32_t y, const int32_t z) const
+	{
+		const auto& cellEntryIt = m_cellTable.find(CellKey(CCell { x, y, z }));
+		return cellEntryIt != m_cellTable.end() ? &cellEntryIt->second : 0;
+	}
+	
+	void CSpatialGrid::GatherBox(const CCell& minCell, const CCell& maxCell, TIndexList& candidates) const
+	{
+		// Never walk further than the occupied cells
+		const int32_t minX = std::max(minCell.x, m_minCell.x), maxX = std::min(maxCell.x, m_maxCell.x);
+		const int32_t minY = std::max(minCell.y, m_minCell.y), maxY = std::min(maxCell.y, m_maxCell.y);
+		const int32_t minZ = std::max(minCell.z, m_minCell.z), maxZ = std::min(maxCell.z, m_maxCell.z);
+		
+		for(int32_t x = minX; x <= maxX; ++x)
+		{
+			for(int32_t y = minY; y <= maxY; ++y)
+			{
+				for(int32_t z = minZ; z <= maxZ; ++z)
+				{
+					const TIndexList* cell = Cell(x, y, z);
+					if(cell)
+					{
+						candidates.insert(candidates.end(), cell->begin(), cell->end());
+					}
+				}
+			}
+		}
+	}
+	
+	void CSpatialGrid::AddToCell(const unsigned int index)
+	{
+		CEntry& entry = m_entryList[index];
+		TIndexList& cell = m_cellTable[entry.m_cellKey];
+		entry.m_cellSlot = cell.size();
+		cell.push_back(index);
+		
+		const CCell coordinates = CellOf(entry.m_position);
+		m_minCell = CCell { std::min(m_minCell.x, coordinates.x), std::min(m_minCell.y, coordinates.y), std::min(m_minCell.z, coordinates.z) };
+		m_maxCell = CCell { std::max(m_maxCell.x, coordinates.x), std::max(m_maxCell.y, coordinates.y), std::max(m_maxCell.z, coordinates.z) };
+	}
+	
+	void CSpatialGrid::RemoveFromCell(const unsigned int index)
+	{
+		const CEntry& entry = m_entryList[index];
+		const auto& cellEntryIt = m_cellTable.find(entry.m_cellKey);
+		TIndexList& cell = cellEntryIt->second;
+		
+		const unsigned int movedIndex = cell.back();
+		cell[entry.m_cellSlot] = movedIndex;
+		m_entryList[movedIndex].m_cellSlot = entry.m_cellSlot;
+		cell.pop_back();
+		
+		if(cell.empty())
+		{
+			m_cellTable.erase(cellEntryIt);
+		}
+	}
+}
@@ -0,0 +1,261 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "threadpool.h"
+
+#include <cassert>
+
+namespace dc
+{
+	// ===========================================================
+	// Static fields / methods
+	// ===========================================================
+	
+	/**
+	 * Worker running the calling thread. Pools may run jobs of each other, so the index
+	 * only means something for the pool it belongs to.
+	 */
+	struct CCurrentWorker
+	{
+		const CThreadPool*	mp_pool;
+		int					m_index;
+	};
+	
+	static thread_local CCurrentWorker s_currentWorker = { 0, CThreadPool::ANY_WORKER };
+	
+	const int CThreadPool::ANY_WORKER;
+	
+	const int CThreadPool::CurrentWorker() const
+	{
+		return s_currentWorker.mp_pool == this ? s_currentWorker.m_index : ANY_WORKER;
+	}
+	
+	// ===========================================================
+	// Constructors
+	// ===========================================================
+	
+	CThreadPool::CThreadPool(const unsigned int workerCount):
+		m_nextWorker(0),
+		m_epoch(0),
+		m_stop(false)
+	{
+		unsigned int count = workerCount;
+		if(count == 0)
+		{
+			count = std::thread::hardware_concurrency();
+		}
+		if(count == 0)
+		{
+			count = 1;
+		}
+		
+		m_workerList.reserve(count);
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			CWorker* worker = new CWorker();
+			worker->m_busy.store(false, std::memory_order_relaxed);
+			m_workerList.emplace_back(worker);
+		}
+		
+		// Every worker exists before any of them starts stealing
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			m_workerList[i]->m_thread = std::thread(&CThreadPool::Run, this, i);
+		}
+	}
+	
+	CThreadPool::~CThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_stop = true;
+		}
+		m_wakeCondition.notify_all();
+		
+		for(auto& worker : m_workerList)
+		{
+			worker->m_thread.join();
+		}
+	}
+	
+	// ===========================================================
+	// Methods
+	// ===========================================================
+	
+	void CThreadPool::Submit(const TJob& job, CJobCounter* counter, const int worker)
+	{
+		assert(job && "[CThreadPool::Submit] Empty job");
+		
+		if(counter)
+		{
+			counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+		}
+		
+		const bool pinned = worker != ANY_WORKER;
+		const unsigned int count = m_workerList.size();
+		const unsigned int index = pinned ? (unsigned int)worker % count : m_nextWorker.fetch_add(1, std::memory_order_relaxed) % count;
+		
+		CWorker& target = *m_workerList[index];
+		{
+			std::lock_guard<std::mutex> lock(target.m_mutex);
+			target.m_jobList.push_back(CJob { job, counter, pinned });
+		}
+		Wake();
+	}
+	
+	void CThreadPool::Wait(CJobCounter& counter)
+	{
+		const int self = CurrentWorker();
+		CJob job;
+		while(!counter.Done())
+		{
+			if(TakeJob(self, job))
+			{
+				Execute(job);
+				continue;
+			}
+			
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			const uint64_t epoch = m_epoch;
+			lock.unlock();
+			
+			// Something may have been queued between the failed take and reading the epoch
+			if(counter.Done() || TakeJob(self, job))
+			{
+				if(job.m_function)
+				{
+					Execute(job);
+				}
+				continue;
+			}
+			
+			lock.lock();
+			m_wakeCondition.wait(lock, [&] { return m_epoch != epoch; });
+		}
+	}
+	
+	void CThreadPool::Run(const unsigned int index)
+	{
+		s_currentWorker.mp_pool = this;
+		s_currentWorker.m_index = index;
+		
+		CJob job;
+		while(true)
+		{
+			if(TakeJob(index, job))
+			{
+				Execute(job);
+				continue;
+			}
+			
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			if(m_stop)
+			{
+				// Leftovers may still sit in the queues
+				lock.unlock();
+				if(TakeJob(index, job))
+				{
+					Execute(job);
+					continue;
+				}
+				return;
+			}
+			const uint64_t epoch = m_epoch;
+			lock.unlock();
+			
+			if(TakeJob(index, job))
+			{
+				Execute(job);
+				continue;
+			}
+			
+			lock.lock();
+			m_wakeCondition.wait(lock, [&] { return m_epoch != epoch || m_stop; });
+		}
+	}
+	
+	const bool CThreadPool::TakeJob(const int self, CJob& job)
+	{
+		const unsigned int count = m_workerList.size();
+		
+		if(self != ANY_WORKER)
+		{
+			CWorker& own = *m_workerList[self];
+			std::lock_guard<std::mutex> lock(own.m_mutex);
+			if(!own.m_jobList.empty())
+			{
+				job = std::move(own.m_jobList.front());
+				own.m_jobList.pop_front();
+				return true;
+			}
+		}
+		
+		// Steal from the back, where the most recently queued work is
+		const unsigned int start = self == ANY_WORKER ? 0 : self + 1;
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const unsigned int index = (start + i) % count;
+			if((int)index == self)
+			{
+				continue;
+			}
+			
+			CWorker& victim = *m_workerList[index];
+			const bool victimBusy = victim.m_busy.load(std::memory_order_relaxed);
+			
+			std::lock_guard<std::mutex> lock(victim.m_mutex);
+			for(auto it = victim.m_jobList.rbegin(); it != victim.m_jobList.rend(); ++it)
+			{
+				if(!it->m_pinned || victimBusy)
+				{
+					job = std::move(*it);
+					victim.m_jobList.erase(std::next(it).base());
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	
+	void CThreadPool::Execute(CJob& job)
+	{
+		// Jobs may nest through Wait, the outermost one clears the flag
+		const int self = CurrentWorker();
+		bool wasBusy = false;
+		if(self != ANY_WORKER)
+		{
+			wasBusy = m_workerList[self]->m_busy.exchange(true, std::memory_order_relaxed);
+		}
+		
+		job.m_function();
+		job.m_function = nullptr;
+		
+		if(self != ANY_WORKER)
+		{
+			m_workerList[self]->m_busy.store(wasBusy, std::memory_order_relaxed);
+		}
+		
+		if(job.mp_counter && job.mp_counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			Wake();
+		}
+	}
+	
+	void CThreadPool::Wake()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			++m_epoch;
+		}
+		m_wakeCondition.notify_all();
+	}
+}
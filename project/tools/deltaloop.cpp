@@ -0,0 +1,245 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * Replicates a server scene into a client scene in the same process through the
+ * delta encoder and decoder, and reports the bytes sent per tick next to what
+ * sending the whole state every tick would cost. Objects move, get hurt, change
+ * parent, spawn and despawn. The client is compared against the server at the end.
+ *
+ * Usage: DCGameObjectDeltaLoop [--roots count] [--children perRoot] [--ticks count]
+ *	[--mutation fractionPerTick] [--churn hierarchiesPerTick] [--seed value]
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "components/scene.h"
+#include "replication/deltacodec.h"
+
+using namespace dc;
+
+namespace
+{
+	// ===========================================================
+	// Replicated component
+	// ===========================================================
+	
+	class CHealth : public CComponent
+	{
+		RTTI_DECLARATIONS(CHealth, CComponent)
+	public:
+		CHealth(): m_health(100) {}
+		
+		int32_t	m_health;
+	};
+	
+	void WriteHealth(const CHealth& health, CByteWriter& writer)	{ writer.WriteVarInt(health.m_health); }
+	void ReadHealth(CHealth& health, CByteReader& reader)			{ health.m_health = reader.ReadVarInt(); }
+	
+	struct CLoopSettings
+	{
+		unsigned int	m_roots = 1000;
+		unsigned int	m_children = 4;
+		unsigned int	m_ticks = 300;
+		float			m_mutation = 0.1f;
+		unsigned int	m_churn = 2;
+		unsigned int	m_seed = 1;
+	};
+	
+	CGameObject* CreateHierarchy(const CLoopSettings& settings, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+		
+		CGameObject* root = new CGameObject("root");
+		root->AddComponent<CHealth>();
+		root->Transform()->LocalPosition(math::Vector3f(position(random), 0.0f, position(random)));
+		
+		for(unsigned int i = 0; i < settings.m_children; ++i)
+		{
+			CGameObject* child = new CGameObject("child");
+			child->Transform()->LocalPosition(math::Vector3f(float(i), 1.0f, 0.0f));
+			child->Transform()->Parent(root->Transform());
+		}
+		return root;
+	}
+	
+	void Mutate(CScene& scene, TGOList& rootList, const CLoopSettings& settings, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+		
+		const unsigned int mutationCount = unsigned(rootList.size() * settings.m_mutation);
+		for(unsigned int i = 0; i < mutationCount; ++i)
+		{
+			CGameObject* root = rootList[random() % rootList.size()];
+			const math::Vector3f position = root->Transform()->LocalPosition();
+			root->Transform()->LocalPosition(math::Vector3f(position.x + step(random), position.y, position.z + step(random)));
+			root->GetComponent<CHealth>()->m_health -= 1;
+		}
+		
+		// A child changes hands
+		if(rootList.size() > 1)
+		{
+			CTransform* from = rootList[random() % rootList.size()]->Transform();
+			CTransform* to = rootList[random() % rootList.size()]->Transform();
+			if(from != to && from->HasChildren())
+			{
+				from->Children().back()->Parent(to);
+			}
+		}
+		
+		for(unsigned int i = 0; i < settings.m_churn && !rootList.empty(); ++i)
+		{
+			const unsigned int index = random() % rootList.size();
+			scene.Destroy(rootList[index]);
+			rootList[index] = rootList.back();
+			rootList.pop_back();
+		}
+		
+		for(unsigned int i = 0; i < settings.m_churn; ++i)
+		{
+			rootList.push_back(CreateHierarchy(settings, random));
+			scene.Add(rootList.back());
+		}
+	}
+	
+	const unsigned int CountMismatches(const CSceneSnapshot& server, const CDeltaDecoder& decoder, const CScene& client, const CQuantization& quantization, const CReplicationRegistry& registry)
+	{
+		CSceneSnapshot replica;
+		replica.Capture(client, quantization, &registry);
+		
+		unsigned int mismatchCount = replica.Entries().size() != server.Entries().size();
+		for(const CSnapshotEntry& entry : server.Entries())
+		{
+			const CGameObject* gameObject = decoder.Replica(entry.m_id);
+			const CSnapshotEntry* replicaEntry = gameObject ? replica.Find(gameObject->Id()) : 0;
+			if(!replicaEntry)
+			{
+				++mismatchCount;
+				continue;
+			}
+			
+			const CGameObject* parent = entry.m_parentId ? decoder.Replica(entry.m_parentId) : 0;
+			const uint32_t parentId = parent ? parent->Id() : 0;
+			
+			if(replicaEntry->m_parentId != parentId
+				|| replicaEntry->m_name != entry.m_name
+				|| !std::equal(entry.m_position, entry.m_position + 3, replicaEntry->m_position)
+				|| !std::equal(entry.m_rotation, entry.m_rotation + 4, replicaEntry->m_rotation)
+				|| !std::equal(entry.m_scale, entry.m_scale + 3, replicaEntry->m_scale)
+				|| replicaEntry->m_payloadList != entry.m_payloadList)
+			{
+				++mismatchCount;
+			}
+		}
+		return mismatchCount;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CLoopSettings settings;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--roots") == 0 && i + 1 < argc)				settings.m_roots = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--children") == 0 && i + 1 < argc)		settings.m_children = std::max(0, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)		settings.m_ticks = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--mutation") == 0 && i + 1 < argc)		settings.m_mutation = std::min(1.0, std::max(0.0, atof(argv[++i])));
+		else if(strcmp(argv[i], "--churn") == 0 && i + 1 < argc)		settings.m_churn = std::max(0, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)			settings.m_seed = atoi(argv[++i]);
+		else
+		{
+			std::cerr << "Usage: DCGameObjectDeltaLoop [--roots count] [--children perRoot] [--ticks count]" << std::endl
+				<< "\t[--mutation fractionPerTick] [--churn hierarchiesPerTick] [--seed value]" << std::endl;
+			return 1;
+		}
+	}
+	
+	std::mt19937 random(settings.m_seed);
+	
+	CReplicationRegistry registry;
+	registry.Register<CHealth>(&WriteHealth, &ReadHealth);
+	const CQuantization quantization;
+	
+	CScene server("server");
+	CScene client("client");
+	
+	TGOList rootList;
+	for(unsigned int i = 0; i < settings.m_roots; ++i)
+	{
+		rootList.push_back(CreateHierarchy(settings, random));
+		server.Add(rootList.back());
+	}
+	server.Update();
+	
+	CDeltaEncoder encoder;
+	CDeltaDecoder decoder(client, quantization, &registry);
+	
+	const CSceneSnapshot empty;
+	CSceneSnapshot baseline;
+	CSceneSnapshot current;
+	
+	uint64_t fullBytes = 0;
+	uint64_t deltaBytes = 0;
+	size_t maxDeltaBytes = 0;
+	size_t initialBytes = 0;
+	
+	for(unsigned int tick = 0; tick < settings.m_ticks; ++tick)
+	{
+		if(tick)
+		{
+			Mutate(server, rootList, settings, random);
+		}
+		server.Update();
+		current.Capture(server, quantization, &registry);
+		
+		// What resending the whole state would cost
+		CByteWriter fullWriter;
+		CDeltaEncoder().Encode(empty, current, fullWriter);
+		
+		CByteWriter writer;
+		encoder.Encode(baseline, current, writer);
+		if(!decoder.Apply(writer.Bytes().data(), writer.Size()))
+		{
+			std::cerr << "Tick " << tick << " could not be applied" << std::endl;
+			return 1;
+		}
+		client.Update();
+		baseline = current;
+		
+		if(tick)
+		{
+			fullBytes += fullWriter.Size();
+			deltaBytes += writer.Size();
+			maxDeltaBytes = std::max(maxDeltaBytes, writer.Size());
+		}
+		else
+		{
+			initialBytes = writer.Size();
+		}
+	}
+	
+	const unsigned int mismatchCount = CountMismatches(current, decoder, client, quantization, registry);
+	const unsigned int deltaTicks = std::max(1u, settings.m_ticks - 1);
+	
+	std::cout << "game objects " << current.Entries().size() << "\tticks " << settings.m_ticks << std::endl
+		<< "initial state " << initialBytes << " bytes" << std::endl
+		<< "delta " << deltaBytes / deltaTicks << " bytes/tick (max " << maxDeltaBytes << ")"
+		<< "\tfull " << fullBytes / deltaTicks << " bytes/tick" << std::endl
+		<< "mismatches " << mismatchCount << std::endl;
+	
+	return mismatchCount ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//
+//  frametimes.h
+//  DCPP
+//
+//  Created by Jorge López on 19/10/26.
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace dc
+{
+	using TFrameTimeList = std::vector<uint64_t>;
+	
+	/**
+	 * Prints total, mean, p50, p95, p99 and max of frame times given in nanoseconds
+	 */
+	inline void PrintFrameTimes(std::ostream& output, const TFrameTimeList& frameTimeList)
+	{
+		if(frameTimeList.empty())
+		{
+			output << "no frames" << std::endl;
+			return;
+		}
+		
+		TFrameTimeList sortedList(frameTimeList);
+		std::sort(sortedList.begin(), sortedList.end());
+		
+		uint64_t totalNs = 0;
+		for(const uint64_t frameTime : sortedList)
+		{
+			totalNs += frameTime;
+		}
+		
+		auto percentileMs = [&sortedList](const double percentile)
+		{
+			const size_t index = std::min(sortedList.size() - 1, (size_t)(percentile * sortedList.size()));
+			return sortedList[index] / 1e6;
+		};
+		
+		output << "total " << totalNs / 1e6 << " ms, mean " << totalNs / 1e6 / sortedList.size()
+			<< " ms, p50 " << percentileMs(0.5)
+			<< " ms, p95 " << percentileMs(0.95)
+			<< " ms, p99 " << percentileMs(0.99)
+			<< " ms, max " << sortedList.back() / 1e6 << " ms" << std::endl;
+	}
+}
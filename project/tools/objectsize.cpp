@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * Prints the size of a game object and its parts, and how many heap allocations a game
+ * object costs, bare and with a few components. The components themselves are left out
+ * of the counts, only what the game object allocates to hold them is in.
+ *
+ * Usage: DCGameObjectObjectSize [--objects count]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "components/gameobject.h"
+
+using namespace dc;
+
+// ===========================================================
+// Allocation counting
+// ===========================================================
+
+namespace
+{
+	std::atomic<uint64_t> s_allocationCount(0);
+	std::atomic<uint64_t> s_allocationBytes(0);
+}
+
+void* operator new(size_t size)
+{
+	s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	s_allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	
+	void* pointer = malloc(size ? size : 1);
+	if(!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	free(pointer);
+}
+
+namespace
+{
+	class CSizeComponent : public CComponent
+	{
+		RTTI_DECLARATIONS(CSizeComponent, CComponent)
+	};
+	
+	/**
+	 * Allocations and bytes per game object with the given number of components, not counting the components
+	 */
+	void Measure(const unsigned int objects, const unsigned int components)
+	{
+		std::vector<CGameObject*> gameObjectList;
+		gameObjectList.reserve(objects);
+		
+		const uint64_t countAtStart = s_allocationCount.load(std::memory_order_relaxed);
+		const uint64_t bytesAtStart = s_allocationBytes.load(std::memory_order_relaxed);
+		for(unsigned int i = 0; i < objects; ++i)
+		{
+			CGameObject* gameObject = new CGameObject("size");
+			for(unsigned int j = 0; j < components; ++j)
+			{
+				gameObject->AddComponent<CSizeComponent>();
+			}
+			gameObjectList.push_back(gameObject);
+		}
+		const uint64_t count = s_allocationCount.load(std::memory_order_relaxed) - countAtStart - uint64_t(objects) * components;
+		const uint64_t bytes = s_allocationBytes.load(std::memory_order_relaxed) - bytesAtStart - uint64_t(objects) * components * sizeof(CSizeComponent);
+		
+		for(CGameObject* gameObject : gameObjectList)
+		{
+			delete gameObject;
+		}
+		
+		std::cout << components << " components\t" << double(count) / objects << " allocations\t"
+			<< double(bytes) / objects << " bytes per game object" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int objects = 1000;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--objects") == 0 && i + 1 < argc)	objects = std::max(1, atoi(argv[++i]));
+		else
+		{
+			std::cerr << "Usage: DCGameObjectObjectSize [--objects count]" << std::endl;
+			return 1;
+		}
+	}
+	
+	std::cout << "sizeof(CGameObject) " << sizeof(CGameObject) << std::endl
+		<< "sizeof(CTransform) " << sizeof(CTransform) << std::endl
+		<< "sizeof(CComponentSlots) " << sizeof(CComponentSlots) << std::endl;
+	
+	for(unsigned int components = 0; components <= CComponentSlots::INLINE_CAPACITY + 2; ++components)
+	{
+		Measure(objects, components);
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * Replays a CSceneRecorder capture headlessly and reports the frame times, so captured
+ * workloads can be profiled and builds compared on the same input.
+ *
+ * Usage: DCGameObjectReplay capture [--repeat count] [--trace output.json] [--summary]
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "frametimes.h"
+
+#include "components/scene.h"
+#include "debug/profiler.h"
+#include "replication/scenereplayer.h"
+
+using namespace dc;
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cerr << "Usage: DCGameObjectReplay capture [--repeat count] [--trace output.json] [--summary]" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+	
+	const char* capturePath = argv[1];
+	const char* tracePath = 0;
+	unsigned int repeat = 1;
+	bool summary = false;
+	
+	for(int i = 2; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+		{
+			repeat = std::max(1, atoi(argv[++i]));
+		}
+		else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			tracePath = argv[++i];
+		}
+		else if(strcmp(argv[i], "--summary") == 0)
+		{
+			summary = true;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	
+	TFrameTimeList frameTimeList;
+	unsigned int gameObjectCount = 0;
+	
+	for(unsigned int run = 0; run < repeat; ++run)
+	{
+		CScene scene(capturePath);
+		CSceneReplayer replayer(scene);
+		if(!replayer.Load(capturePath))
+		{
+			std::cerr << capturePath << " isn't a capture this build can replay" << std::endl;
+			return 1;
+		}
+		
+		for(;;)
+		{
+			const uint64_t startNs = CProfiler::NowNs();
+			if(!replayer.Step())
+			{
+				break;
+			}
+			frameTimeList.push_back(CProfiler::NowNs() - startNs);
+			
+			// Draining every frame keeps the thread buffers from dropping samples
+			CProfiler::Instance().Collect();
+		}
+		
+		if(replayer.Error())
+		{
+			std::cerr << capturePath << " is broken after frame " << replayer.Frame() << std::endl;
+			return 1;
+		}
+		gameObjectCount = replayer.GameObjectCount();
+	}
+	
+	if(frameTimeList.empty())
+	{
+		std::cerr << capturePath << " has no frames" << std::endl;
+		return 1;
+	}
+	
+	std::cout << "frames " << frameTimeList.size() / repeat << " x " << repeat
+		<< ", game objects " << gameObjectCount << std::endl;
+	PrintFrameTimes(std::cout, frameTimeList);
+	
+	if(summary)
+	{
+		CProfiler::Instance().PrintSummary(std::cout);
+	}
+	
+	if(tracePath && !CProfiler::Instance().ExportChromeTrace(tracePath))
+	{
+		std::cerr << "Can't write " << tracePath << std::endl;
+		return 1;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,175 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * Maps the region of a CSharedSceneExporter and prints its game objects, or follows the
+ * exports printing how many entries every one of them changed.
+ *
+ * Usage: DCGameObjectSharedDump name [--rows count] [--watch exports]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "replication/sharedscenereader.h"
+
+using namespace dc;
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cerr << "Usage: DCGameObjectSharedDump name [--rows count] [--watch exports]" << std::endl;
+	}
+	
+	/**
+	 * The exporter may not have created the region yet
+	 */
+	const bool OpenWaiting(CSharedSceneReader& reader, const char* name)
+	{
+		for(unsigned int attempt = 0; attempt < 500; ++attempt)
+		{
+			if(reader.Open(name))
+			{
+				return true;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return false;
+	}
+	
+	const int Dump(const CSharedSceneReader& reader, const unsigned int rows)
+	{
+		uint64_t frame = 0;
+		unsigned int count = 0;
+		unsigned int sceneCount = 0;
+		std::vector<CSharedGameObject> entryList;
+		
+		const bool read = reader.Read([&](const CSharedSceneHeader& header, const CSharedGameObject* entries, const unsigned int entryCount)
+		{
+			frame = header.m_frame;
+			count = entryCount;
+			sceneCount = header.m_sceneCount;
+			entryList.assign(entries, entries + entryCount);
+		});
+		
+		if(!read)
+		{
+			std::cerr << "The exporter kept writing, try again" << std::endl;
+			return 1;
+		}
+		
+		std::cout << "frame " << frame << ", " << count << " entries for " << sceneCount << " game objects" << std::endl;
+		for(unsigned int i = 0, printed = 0; i < entryList.size() && printed < rows; ++i)
+		{
+			const CSharedGameObject& entry = entryList[i];
+			if(!entry.m_id)
+			{
+				continue;
+			}
+			++printed;
+			
+			std::cout << i << "\tid " << entry.m_id << "\tparent ";
+			if(entry.m_parentIndex == CSharedGameObject::NO_PARENT)
+			{
+				std::cout << "-";
+			}
+			else
+			{
+				std::cout << entry.m_parentIndex;
+			}
+			std::cout << "\t(" << entry.m_position[0] << ", " << entry.m_position[1] << ", " << entry.m_position[2] << ")\t"
+				<< entry.m_name << std::endl;
+		}
+		return 0;
+	}
+	
+	const int Watch(const CSharedSceneReader& reader, const unsigned int exports)
+	{
+		uint64_t lastExport = reader.ExportCount();
+		for(unsigned int seen = 0; seen < exports;)
+		{
+			if(reader.ExportCount() == lastExport)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+			
+			uint64_t frame = 0;
+			unsigned int count = 0;
+			unsigned int changed = 0;
+			const bool read = reader.Read([&](const CSharedSceneHeader& header, const CSharedGameObject* entries, const unsigned int entryCount)
+			{
+				frame = header.m_frame;
+				count = 0;
+				changed = 0;
+				for(unsigned int i = 0; i < entryCount; ++i)
+				{
+					count += entries[i].m_id != 0;
+					changed += entries[i].m_id && entries[i].m_changedFrame == frame;
+				}
+			});
+			
+			lastExport = reader.ExportCount();
+			if(read)
+			{
+				std::cout << "frame " << frame << ": " << changed << " of " << count << " changed" << std::endl;
+				++seen;
+			}
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+	
+	const char* name = argv[1];
+	unsigned int rows = 20;
+	unsigned int exports = 0;
+	
+	for(int i = 2; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--rows") == 0 && i + 1 < argc)
+		{
+			rows = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--watch") == 0 && i + 1 < argc)
+		{
+			exports = atoi(argv[++i]);
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	
+	CSharedSceneReader reader;
+	if(!OpenWaiting(reader, name))
+	{
+		std::cerr << "Can't map " << name << std::endl;
+		return 1;
+	}
+	
+	return exports ? Watch(reader, exports) : Dump(reader, rows);
+}
@@ -0,0 +1,258 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * Reader threads follow the world snapshots a scene publishes while it updates and churns
+ * its game objects. Every game object is moved to the same place each frame, derived from
+ * the frame, so a snapshot is whole when all its matrices are equal and match its epoch.
+ * Readers check that, check it again after holding the snapshot for a while, and check
+ * that epochs never go back. Any failure makes the run exit with 1.
+ *
+ * Usage: DCGameObjectSnapshotStress [--objects count] [--readers threads] [--frames count]
+ *	[--churn gameObjectsPerFrame] [--seed value]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "components/scene.h"
+
+using namespace dc;
+
+namespace
+{
+	// ===========================================================
+	// Frame driven movement
+	// ===========================================================
+	
+	/**
+	 * Frame being updated, only written by the scene thread between updates
+	 */
+	unsigned int s_frame = 0;
+	
+	const math::Vector3f FramePosition(const unsigned int frame)
+	{
+		const float value = (float)frame;
+		return math::Vector3f(value, -value, 2.0f * value);
+	}
+	
+	class CFrameMover : public CComponent
+	{
+		RTTI_DECLARATIONS(CFrameMover, CComponent)
+	public:
+		void Update() override
+		{
+			GameObject()->Transform()->LocalPosition(FramePosition(s_frame));
+		}
+	};
+	
+	// ===========================================================
+	// Settings
+	// ===========================================================
+	
+	struct CSnapshotStressSettings
+	{
+		unsigned int	m_objects = 10000;
+		unsigned int	m_readers = 4;
+		unsigned int	m_frames = 2000;
+		unsigned int	m_churn = 50;
+		unsigned int	m_seed = 1;
+	};
+	
+	// ===========================================================
+	// Readers
+	// ===========================================================
+	
+	struct CReaderResult
+	{
+		uint64_t	m_snapshots = 0;	// Different snapshots checked
+		uint64_t	m_torn = 0;			// Matrices differing from the rest or from their epoch
+		uint64_t	m_changed = 0;		// Snapshots that changed while held
+		uint64_t	m_regressions = 0;	// Epochs older than one already seen
+		uint64_t	m_badIndices = 0;	// Game objects not found at their own index
+	};
+	
+	/**
+	 * Number of matrices that don't belong to the snapshot epoch
+	 */
+	const uint64_t CountTorn(const CWorldSnapshot& snapshot)
+	{
+		const TMatrixList& matrixList = snapshot.Matrices();
+		if(matrixList.empty())
+		{
+			return 0;
+		}
+		
+		const math::Vector3f expected = FramePosition((unsigned int)snapshot.Epoch());
+		const math::Vector3f position = matrixList.front().Position();
+		uint64_t torn = position.x != expected.x || position.y != expected.y || position.z != expected.z;
+		
+		for(unsigned int i = 1; i < matrixList.size(); ++i)
+		{
+			torn += memcmp(&matrixList[i], &matrixList.front(), sizeof(math::Matrix4x4f)) != 0;
+		}
+		return torn;
+	}
+	
+	void Read(const CScene& scene, const std::atomic<bool>& done, CReaderResult& result)
+	{
+		uint64_t lastEpoch = 0;
+		const CWorldSnapshot* lastSnapshot = 0;
+		
+		while(!done.load(std::memory_order_acquire))
+		{
+			TWorldSnapshotPtr snapshot = scene.WorldSnapshot();
+			if(!snapshot || (snapshot.get() == lastSnapshot && snapshot->Epoch() == lastEpoch))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			
+			if(snapshot->Epoch() < lastEpoch)
+			{
+				++result.m_regressions;
+			}
+			lastEpoch = std::max(lastEpoch, snapshot->Epoch());
+			lastSnapshot = snapshot.get();
+			++result.m_snapshots;
+			
+			const uint64_t epoch = snapshot->Epoch();
+			const uint64_t torn = CountTorn(*snapshot);
+			result.m_torn += torn;
+			
+			const TGOList& gameObjectList = snapshot->GameObjects();
+			if(gameObjectList.size() != snapshot->Size())
+			{
+				++result.m_badIndices;
+			}
+			else
+			{
+				for(unsigned int i = 0; i < gameObjectList.size(); i += 97)
+				{
+					result.m_badIndices += snapshot->IndexOf(gameObjectList[i]) != i;
+				}
+			}
+			
+			// Held while the scene publishes a few more, nothing may recycle it under the reader
+			std::this_thread::yield();
+			if(snapshot->Epoch() != epoch || CountTorn(*snapshot) != torn)
+			{
+				++result.m_changed;
+			}
+		}
+	}
+	
+	// ===========================================================
+	// Scene
+	// ===========================================================
+	
+	CGameObject* CreateGameObject(const unsigned int frame)
+	{
+		// Placed where the first update it may miss would put it
+		CGameObject* gameObject = new CGameObject("snapshot");
+		gameObject->AddComponent<CFrameMover>();
+		gameObject->Transform()->LocalPosition(FramePosition(frame));
+		return gameObject;
+	}
+	
+	const bool Run(const CSnapshotStressSettings& settings)
+	{
+		std::mt19937 random(settings.m_seed);
+		
+		CScene scene("snapshot stress");
+		scene.PublishWorldSnapshots(true);
+		
+		TGOList gameObjectList;
+		for(unsigned int i = 0; i < settings.m_objects; ++i)
+		{
+			gameObjectList.push_back(CreateGameObject(0));
+			scene.Add(gameObjectList.back());
+		}
+		
+		std::atomic<bool> done(false);
+		std::vector<CReaderResult> resultList(settings.m_readers);
+		std::vector<std::thread> readerList;
+		for(unsigned int i = 0; i < settings.m_readers; ++i)
+		{
+			readerList.emplace_back(Read, std::cref(scene), std::cref(done), std::ref(resultList[i]));
+		}
+		
+		for(s_frame = 0; s_frame < settings.m_frames; ++s_frame)
+		{
+			scene.Update();
+			
+			// Some go and as many come, so the index tables are rebuilt as well
+			for(unsigned int i = 0; i < settings.m_churn && !gameObjectList.empty(); ++i)
+			{
+				const unsigned int index = random() % gameObjectList.size();
+				scene.Destroy(gameObjectList[index]);
+				gameObjectList[index] = CreateGameObject(s_frame + 1);
+				scene.Add(gameObjectList[index]);
+			}
+		}
+		
+		done.store(true, std::memory_order_release);
+		for(std::thread& reader : readerList)
+		{
+			reader.join();
+		}
+		
+		CReaderResult total;
+		for(const CReaderResult& result : resultList)
+		{
+			total.m_snapshots += result.m_snapshots;
+			total.m_torn += result.m_torn;
+			total.m_changed += result.m_changed;
+			total.m_regressions += result.m_regressions;
+			total.m_badIndices += result.m_badIndices;
+		}
+		
+		std::cout << settings.m_frames << " frames, " << settings.m_readers << " readers, " << total.m_snapshots << " snapshots checked" << std::endl
+			<< "torn matrices " << total.m_torn << ", changed while held " << total.m_changed
+			<< ", epoch regressions " << total.m_regressions << ", bad indices " << total.m_badIndices << std::endl;
+		
+		return total.m_snapshots > 0 && total.m_torn == 0 && total.m_changed == 0 && total.m_regressions == 0 && total.m_badIndices == 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CSnapshotStressSettings settings;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--objects") == 0 && i + 1 < argc)			settings.m_objects = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--readers") == 0 && i + 1 < argc)		settings.m_readers = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)		settings.m_frames = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--churn") == 0 && i + 1 < argc)		settings.m_churn = std::max(0, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)			settings.m_seed = atoi(argv[++i]);
+		else
+		{
+			std::cerr << "Usage: DCGameObjectSnapshotStress [--objects count] [--readers threads] [--frames count]" << std::endl
+				<< "\t[--churn gameObjectsPerFrame] [--seed value]" << std::endl;
+			return 1;
+		}
+	}
+	
+	if(!Run(settings))
+	{
+		std::cerr << "FAILED" << std::endl;
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}
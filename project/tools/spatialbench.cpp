@@ -0,0 +1,282 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * Times the spatial grid against a linear scan over every position for radius, box and
+ * nearest queries, at 10k, 100k and 1M game objects. Positions are spread uniformly with
+ * the same density at every count, so the grid answers about as many game objects per
+ * query each time. Both must find the same game objects, a mismatch fails the run.
+ *
+ * Usage: DCGameObjectSpatialBench [--queries count] [--radius value] [--nearest k]
+ *	[--cell size] [--spacing value] [--seed value]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "debug/profiler.h"
+#include "spatial/spatialgrid.h"
+
+using namespace dc;
+
+namespace
+{
+	// ===========================================================
+	// Settings
+	// ===========================================================
+	
+	struct CSpatialBenchSettings
+	{
+		unsigned int	m_queries = 200;
+		float			m_radius = 10.0f;
+		unsigned int	m_nearest = 8;
+		float			m_cellSize = 10.0f;
+		float			m_spacing = 4.0f;	// Side of the cube holding one game object on average
+		unsigned int	m_seed = 1;
+	};
+	
+	struct CPositionEntry
+	{
+		CGameObject*	mp_gameObject;
+		math::Vector3f	m_position;
+	};
+	
+	using TPositionList = std::vector<CPositionEntry>;
+	using TPositionTable = std::unordered_map<const CGameObject*, math::Vector3f>;
+	
+	const double ElapsedNs(const uint64_t startNs)
+	{
+		return (double)(CProfiler::NowNs() - startNs);
+	}
+	
+	const float DistanceSquared(const math::Vector3f& a, const math::Vector3f& b)
+	{
+		const float dx = a.x - b.x;
+		const float dy = a.y - b.y;
+		const float dz = a.z - b.z;
+		return dx * dx + dy * dy + dz * dz;
+	}
+	
+	// ===========================================================
+	// Linear scan
+	// ===========================================================
+	
+	void ScanRadius(const TPositionList& positionList, const math::Vector3f& center, const float radius, TGOList& result)
+	{
+		const float radiusSquared = radius * radius;
+		for(const CPositionEntry& entry : positionList)
+		{
+			if(DistanceSquared(entry.m_position, center) <= radiusSquared)
+			{
+				result.push_back(entry.mp_gameObject);
+			}
+		}
+	}
+	
+	void ScanBox(const TPositionList& positionList, const math::Vector3f& min, const math::Vector3f& max, TGOList& result)
+	{
+		for(const CPositionEntry& entry : positionList)
+		{
+			const math::Vector3f& point = entry.m_position;
+			if(point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z && point.z <= max.z)
+			{
+				result.push_back(entry.mp_gameObject);
+			}
+		}
+	}
+	
+	void ScanNearest(const TPositionList& positionList, const math::Vector3f& point, const unsigned int k, std::vector<std::pair<float, CGameObject*>>& distanceList, TGOList& result)
+	{
+		distanceList.clear();
+		for(const CPositionEntry& entry : positionList)
+		{
+			distanceList.emplace_back(DistanceSquared(entry.m_position, point), entry.mp_gameObject);
+		}
+		
+		const unsigned int count = std::min<unsigned int>(k, distanceList.size());
+		std::partial_sort(distanceList.begin(), distanceList.begin() + count, distanceList.end());
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			result.push_back(distanceList[i].second);
+		}
+	}
+	
+	// ===========================================================
+	// Comparison
+	// ===========================================================
+	
+	const bool SameGameObjects(TGOList& gridResult, TGOList& scanResult)
+	{
+		std::sort(gridResult.begin(), gridResult.end());
+		std::sort(scanResult.begin(), scanResult.end());
+		return gridResult == scanResult;
+	}
+	
+	/**
+	 * Nearest results may differ on ties, only the distances have to match
+	 */
+	const bool SameDistances(const TGOList& gridResult, const TGOList& scanResult, const TPositionTable& positionTable, const math::Vector3f& point)
+	{
+		if(gridResult.size() != scanResult.size())
+		{
+			return false;
+		}
+		
+		for(unsigned int i = 0; i < gridResult.size(); ++i)
+		{
+			const float gridDistance = DistanceSquared(positionTable.at(gridResult[i]), point);
+			const float scanDistance = DistanceSquared(positionTable.at(scanResult[i]), point);
+			if(std::abs(gridDistance - scanDistance) > 1e-3f * std::max(1.0f, scanDistance))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	
+	// ===========================================================
+	// Benchmark
+	// ===========================================================
+	
+	const bool Run(const unsigned int count, const CSpatialBenchSettings& settings)
+	{
+		std::mt19937 random(settings.m_seed);
+		
+		const float extent = settings.m_spacing * std::cbrt((float)count);
+		std::uniform_real_distribution<float> coordinate(0.0f, extent);
+		
+		TPositionList positionList;
+		TPositionTable positionTable;
+		positionList.reserve(count);
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			positionList.push_back(CPositionEntry { new CGameObject("spatial"), math::Vector3f(coordinate(random), coordinate(random), coordinate(random)) });
+			positionTable[positionList.back().mp_gameObject] = positionList.back().m_position;
+		}
+		
+		CSpatialGrid grid(settings.m_cellSize);
+		uint64_t startNs = CProfiler::NowNs();
+		for(const CPositionEntry& entry : positionList)
+		{
+			grid.Update(entry.mp_gameObject, entry.m_position);
+		}
+		const double buildMs = ElapsedNs(startNs) / 1e6;
+		
+		TPointList pointList;
+		for(unsigned int i = 0; i < settings.m_queries; ++i)
+		{
+			pointList.push_back(math::Vector3f(coordinate(random), coordinate(random), coordinate(random)));
+		}
+		const math::Vector3f halfSize(settings.m_radius, settings.m_radius, settings.m_radius);
+		
+		unsigned int mismatches = 0;
+		uint64_t found[3] = { 0, 0, 0 };
+		double gridNs[3] = { 0.0, 0.0, 0.0 };
+		double scanNs[3] = { 0.0, 0.0, 0.0 };
+		
+		TGOList gridResult;
+		TGOList scanResult;
+		std::vector<std::pair<float, CGameObject*>> distanceList;
+		distanceList.reserve(count);
+		
+		for(const math::Vector3f& point : pointList)
+		{
+			gridResult.clear();
+			scanResult.clear();
+			startNs = CProfiler::NowNs();
+			grid.QueryRadius(point, settings.m_radius, gridResult);
+			gridNs[0] += ElapsedNs(startNs);
+			startNs = CProfiler::NowNs();
+			ScanRadius(positionList, point, settings.m_radius, scanResult);
+			scanNs[0] += ElapsedNs(startNs);
+			found[0] += scanResult.size();
+			mismatches += !SameGameObjects(gridResult, scanResult);
+			
+			gridResult.clear();
+			scanResult.clear();
+			startNs = CProfiler::NowNs();
+			grid.QueryBox(point - halfSize, point + halfSize, gridResult);
+			gridNs[1] += ElapsedNs(startNs);
+			startNs = CProfiler::NowNs();
+			ScanBox(positionList, point - halfSize, point + halfSize, scanResult);
+			scanNs[1] += ElapsedNs(startNs);
+			found[1] += scanResult.size();
+			mismatches += !SameGameObjects(gridResult, scanResult);
+			
+			gridResult.clear();
+			scanResult.clear();
+			startNs = CProfiler::NowNs();
+			grid.QueryNearest(point, settings.m_nearest, gridResult);
+			gridNs[2] += ElapsedNs(startNs);
+			startNs = CProfiler::NowNs();
+			ScanNearest(positionList, point, settings.m_nearest, distanceList, scanResult);
+			scanNs[2] += ElapsedNs(startNs);
+			found[2] += scanResult.size();
+			mismatches += !SameDistances(gridResult, scanResult, positionTable, point);
+		}
+		
+		const char* queryNames[3] = { "radius", "box", "nearest" };
+		std::cout << count << " game objects, grid built in " << buildMs << " ms" << std::endl;
+		for(unsigned int i = 0; i < 3; ++i)
+		{
+			const double gridUs = gridNs[i] / settings.m_queries / 1e3;
+			const double scanUs = scanNs[i] / settings.m_queries / 1e3;
+			std::cout << "\t" << queryNames[i] << "\tgrid " << gridUs << " us\tscan " << scanUs << " us\tx"
+				<< scanUs / gridUs << "\t(" << double(found[i]) / settings.m_queries << " found)" << std::endl;
+		}
+		
+		for(const CPositionEntry& entry : positionList)
+		{
+			delete entry.mp_gameObject;
+		}
+		
+		if(mismatches)
+		{
+			std::cerr << "\t" << mismatches << " queries differ from the linear scan" << std::endl;
+		}
+		return mismatches == 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CSpatialBenchSettings settings;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--queries") == 0 && i + 1 < argc)			settings.m_queries = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--radius") == 0 && i + 1 < argc)		settings.m_radius = (float)atof(argv[++i]);
+		else if(strcmp(argv[i], "--nearest") == 0 && i + 1 < argc)		settings.m_nearest = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--cell") == 0 && i + 1 < argc)			settings.m_cellSize = (float)atof(argv[++i]);
+		else if(strcmp(argv[i], "--spacing") == 0 && i + 1 < argc)		settings.m_spacing = (float)atof(argv[++i]);
+		else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)			settings.m_seed = atoi(argv[++i]);
+		else
+		{
+			std::cerr << "Usage: DCGameObjectSpatialBench [--queries count] [--radius value] [--nearest k]" << std::endl
+				<< "\t[--cell size] [--spacing value] [--seed value]" << std::endl;
+			return 1;
+		}
+	}
+	
+	const unsigned int countList[] = { 10000, 100000, 1000000 };
+	bool passed = true;
+	for(const unsigned int count : countList)
+	{
+		passed = Run(count, settings) && passed;
+	}
+	return passed ? 0 : 1;
+}
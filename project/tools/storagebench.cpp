@@ -0,0 +1,147 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * Compares the component storage policies on the same workload: adding components to a
+ * scene, updating them, finding them by game object and removing a share of them.
+ * The heap is fragmented on purpose before the components are created.
+ *
+ * Usage: DCGameObjectStorageBench [--count components] [--frames count] [--seed value]
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "components/scene.h"
+#include "debug/profiler.h"
+
+using namespace dc;
+
+namespace
+{
+	// ===========================================================
+	// The same component under every policy
+	// ===========================================================
+	
+#define DC_BENCH_COMPONENT(Type, Storage) \
+	class Type : public CComponent \
+	{ \
+		RTTI_DECLARATIONS(Type, CComponent) \
+		DC_COMPONENT_STORAGE(Type, Storage) \
+	public: \
+		Type(): m_value(0.0f), m_step(1.0f) {} \
+		void Update() override { m_value += m_step; } \
+		\
+	private: \
+		float	m_value; \
+		float	m_step; \
+		char	m_payload[40]; \
+	};
+	
+	DC_BENCH_COMPONENT(CPointerListComponent, PointerList)
+	DC_BENCH_COMPONENT(CDenseComponent, Dense)
+	DC_BENCH_COMPONENT(CSparseComponent, Sparse)
+	
+	struct CBenchSettings
+	{
+		unsigned int	m_count = 100000;
+		unsigned int	m_frames = 100;
+		unsigned int	m_seed = 1;
+	};
+	
+	const double ElapsedMs(const uint64_t startNs)
+	{
+		return (CProfiler::NowNs() - startNs) / 1e6;
+	}
+	
+	template<typename CT>
+	void Run(const char* name, const CBenchSettings& settings)
+	{
+		std::mt19937 random(settings.m_seed);
+		
+		// Other allocations between the components, as in a real heap
+		std::vector<std::unique_ptr<char[]>> fragmentList;
+		TGOList gameObjectList;
+		for(unsigned int i = 0; i < settings.m_count; ++i)
+		{
+			CGameObject* gameObject = new CGameObject("bench");
+			gameObject->AddComponent<CT>();
+			gameObjectList.push_back(gameObject);
+			fragmentList.emplace_back(new char[16 + random() % 256]);
+		}
+		std::shuffle(gameObjectList.begin(), gameObjectList.end(), random);
+		
+		CScene scene(name);
+		
+		uint64_t startNs = CProfiler::NowNs();
+		for(CGameObject* gameObject : gameObjectList)
+		{
+			scene.Add(gameObject);
+		}
+		scene.Update();
+		const double addMs = ElapsedMs(startNs);
+		
+		startNs = CProfiler::NowNs();
+		for(unsigned int frame = 0; frame < settings.m_frames; ++frame)
+		{
+			scene.Update();
+		}
+		const double updateNs = ElapsedMs(startNs) * 1e6 / settings.m_frames / settings.m_count;
+		
+		unsigned int found = 0;
+		startNs = CProfiler::NowNs();
+		for(unsigned int i = 0; i < settings.m_count; ++i)
+		{
+			found += scene.FindComponent<CT>(gameObjectList[random() % gameObjectList.size()]) != 0;
+		}
+		const double findNs = ElapsedMs(startNs) * 1e6 / settings.m_count;
+		
+		// A tenth of them goes away, spread over the whole list
+		std::shuffle(gameObjectList.begin(), gameObjectList.end(), random);
+		startNs = CProfiler::NowNs();
+		for(unsigned int i = 0; i < settings.m_count / 10; ++i)
+		{
+			scene.Destroy(gameObjectList[i]);
+		}
+		scene.Update();
+		const double removeMs = ElapsedMs(startNs);
+		
+		std::cout << name << "\tadd " << addMs << " ms\tupdate " << updateNs << " ns/component\tfind "
+			<< findNs << " ns (" << found << " found)\tremove " << removeMs << " ms" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CBenchSettings settings;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--count") == 0 && i + 1 < argc)			settings.m_count = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)	settings.m_frames = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)		settings.m_seed = atoi(argv[++i]);
+		else
+		{
+			std::cerr << "Usage: DCGameObjectStorageBench [--count components] [--frames count] [--seed value]" << std::endl;
+			return 1;
+		}
+	}
+	
+	Run<CPointerListComponent>("pointer list", settings);
+	Run<CDenseComponent>("dense", settings);
+	Run<CSparseComponent>("sparse", settings);
+	return 0;
+}
@@ -0,0 +1,398 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Jorge López González
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * Generates a synthetic scene and runs it for a number of frames, reporting the frame time
+ * percentiles, the allocations per frame and the peak resident memory, so regressions in the
+ * tail latency of a whole frame become visible.
+ *
+ * A frame is the churn (destroying and spawning hierarchies), the transform writes and CScene::Update.
+ *
+ * Usage: DCGameObjectStress [--objects count] [--depth levels] [--fanout children]
+ *	[--components perObject] [--mix idle:ticker:mover] [--churn hierarchiesPerFrame]
+ *	[--mutation fractionPerFrame] [--frames count] [--warmup count] [--seed value]
+ *	[--compaction gameObjectsPerFrame] [--export sharedMemoryName]
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <sys/resource.h>
+#endif
+
+#include "frametimes.h"
+
+#include "components/scene.h"
+#include "debug/profiler.h"
+#include "replication/sharedsceneexporter.h"
+
+using namespace dc;
+
+// ===========================================================
+// Allocation counting
+// ===========================================================
+
+namespace
+{
+	std::atomic<uint64_t> s_allocationCount(0);
+	std::atomic<uint64_t> s_allocationBytes(0);
+}
+
+void* operator new(size_t size)
+{
+	s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	s_allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	
+	void* pointer = malloc(size ? size : 1);
+	if(!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	free(pointer);
+}
+
+namespace
+{
+	// ===========================================================
+	// Synthetic components
+	// ===========================================================
+	
+	class CStressIdle : public CComponent
+	{
+		RTTI_DECLARATIONS(CStressIdle, CComponent)
+	};
+	
+	class CStressTicker : public CComponent
+	{
+		RTTI_DECLARATIONS(CStressTicker, CComponent)
+	public:
+		CStressTicker(): m_ticks(0) {}
+		void Update() override { ++m_ticks; }
+		
+	private:
+		unsigned int m_ticks;
+	};
+	
+	class CStressMover : public CComponent
+	{
+		RTTI_DECLARATIONS(CStressMover, CComponent)
+	public:
+		CStressMover(): m_step(0.0f) {}
+		void Update() override
+		{
+			m_step += 0.01f;
+			GameObject()->Transform()->LocalPosition(math::Vector3f(m_step, 0.0f, 0.0f));
+		}
+		
+	private:
+		float m_step;
+	};
+	
+	// ===========================================================
+	// Settings
+	// ===========================================================
+	
+	struct CStressSettings
+	{
+		unsigned int	m_objects = 10000;
+		unsigned int	m_depth = 3;
+		unsigned int	m_fanout = 4;
+		unsigned int	m_components = 2;
+		unsigned int	m_mix[3] = { 1, 1, 1 };		// Weights of idle, ticker and mover
+		unsigned int	m_churn = 4;
+		float			m_mutation = 0.1f;
+		unsigned int	m_frames = 1000;
+		unsigned int	m_warmup = 10;
+		unsigned int	m_seed = 1;
+		unsigned int	m_compaction = 0;
+		const char*		mp_exportName = 0;
+	};
+	
+	void PrintUsage()
+	{
+		std::cerr << "Usage: DCGameObjectStress [--objects count] [--depth levels] [--fanout children]" << std::endl
+			<< "\t[--components perObject] [--mix idle:ticker:mover] [--churn hierarchiesPerFrame]" << std::endl
+			<< "\t[--mutation fractionPerFrame] [--frames count] [--warmup count] [--seed value]" << std::endl
+			<< "\t[--compaction gameObjectsPerFrame] [--export sharedMemoryName]" << std::endl;
+	}
+	
+	const bool ParseSettings(int argc, char** argv, CStressSettings& settings)
+	{
+		for(int i = 1; i < argc; ++i)
+		{
+			if(i + 1 >= argc)
+			{
+				return false;
+			}
+			
+			const char* option = argv[i];
+			const char* value = argv[++i];
+			if(strcmp(option, "--objects") == 0)			settings.m_objects = atoi(value);
+			else if(strcmp(option, "--depth") == 0)			settings.m_depth = atoi(value);
+			else if(strcmp(option, "--fanout") == 0)		settings.m_fanout = atoi(value);
+			else if(strcmp(option, "--components") == 0)	settings.m_components = atoi(value);
+			else if(strcmp(option, "--churn") == 0)			settings.m_churn = atoi(value);
+			else if(strcmp(option, "--mutation") == 0)		settings.m_mutation = (float)atof(value);
+			else if(strcmp(option, "--frames") == 0)		settings.m_frames = atoi(value);
+			else if(strcmp(option, "--warmup") == 0)		settings.m_warmup = atoi(value);
+			else if(strcmp(option, "--seed") == 0)			settings.m_seed = atoi(value);
+			else if(strcmp(option, "--compaction") == 0)	settings.m_compaction = atoi(value);
+			else if(strcmp(option, "--export") == 0)		settings.mp_exportName = value;
+			else if(strcmp(option, "--mix") == 0)
+			{
+				if(sscanf(value, "%u:%u:%u", &settings.m_mix[0], &settings.m_mix[1], &settings.m_mix[2]) != 3)
+				{
+					return false;
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+		
+		return settings.m_depth > 0 && settings.m_fanout > 0 && settings.m_frames > 0
+			&& (settings.m_mix[0] + settings.m_mix[1] + settings.m_mix[2]) > 0;
+	}
+	
+	// ===========================================================
+	// Scene generation
+	// ===========================================================
+	
+	struct CHierarchy
+	{
+		CGameObject*	mp_root;
+		TTransformList	m_transformList;
+	};
+	
+	class CStressScene
+	{
+	public:
+		CStressScene(const CStressSettings& settings):
+			m_settings(settings),
+			m_scene("stress"),
+			m_random(settings.m_seed),
+			m_componentDistribution({ (double)settings.m_mix[0], (double)settings.m_mix[1], (double)settings.m_mix[2] })
+		{}
+		
+		CScene& Scene() { return m_scene; }
+		const unsigned int HierarchyCount() const { return m_hierarchyList.size(); }
+		
+		void Spawn()
+		{
+			CHierarchy hierarchy;
+			hierarchy.mp_root = Create(0, m_settings.m_depth, hierarchy.m_transformList);
+			m_scene.Add(hierarchy.mp_root);
+			m_hierarchyList.push_back(std::move(hierarchy));
+		}
+		
+		void Despawn()
+		{
+			if(m_hierarchyList.empty())
+			{
+				return;
+			}
+			
+			const size_t index = m_random() % m_hierarchyList.size();
+			m_scene.Destroy(m_hierarchyList[index].mp_root);
+			
+			m_hierarchyList[index] = std::move(m_hierarchyList.back());
+			m_hierarchyList.pop_back();
+		}
+		
+		void Mutate(const unsigned int count)
+		{
+			for(unsigned int i = 0; i < count && !m_hierarchyList.empty(); ++i)
+			{
+				const TTransformList& transformList = m_hierarchyList[m_random() % m_hierarchyList.size()].m_transformList;
+				CTransform* transform = transformList[m_random() % transformList.size()];
+				transform->LocalPosition(math::Vector3f((float)(m_random() % 100), 0.0f, 0.0f));
+			}
+		}
+		
+	private:
+		CGameObject* Create(CTransform* parent, const unsigned int depth, TTransformList& transformList)
+		{
+			CGameObject* gameObject = new CGameObject("stress");
+			for(unsigned int i = 0; i < m_settings.m_components; ++i)
+			{
+				switch(m_componentDistribution(m_random))
+				{
+					case 0:		gameObject->AddComponent<CStressIdle>(); break;
+					case 1:		gameObject->AddComponent<CStressTicker>(); break;
+					default:	gameObject->AddComponent<CStressMover>(); break;
+				}
+			}
+			
+			if(parent)
+			{
+				gameObject->Transform()->Parent(parent);
+			}
+			transformList.push_back(gameObject->Transform());
+			
+			if(depth > 1)
+			{
+				for(unsigned int i = 0; i < m_settings.m_fanout; ++i)
+				{
+					Create(gameObject->Transform(), depth - 1, transformList);
+				}
+			}
+			return gameObject;
+		}
+		
+	private:
+		const CStressSettings&				m_settings;
+		CScene								m_scene;
+		std::mt19937						m_random;
+		std::discrete_distribution<int>		m_componentDistribution;
+		std::vector<CHierarchy>				m_hierarchyList;
+	};
+	
+	/**
+	 * Peak resident set size in megabytes, 0 when the platform doesn't tell
+	 */
+	const double PeakResidentMB()
+	{
+#if defined(__APPLE__)
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss / (1024.0 * 1024.0);
+#elif defined(__unix__)
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss / 1024.0;
+#else
+		return 0.0;
+#endif
+	}
+	
+	void PrintLocality(std::ostream& stream, const char* label, const CLocality& locality)
+	{
+		stream << "locality " << label << ": near " << locality.m_nearFraction
+			<< ", forward " << locality.m_forwardFraction
+			<< ", parent first " << locality.m_parentFirstFraction << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CStressSettings settings;
+	if(!ParseSettings(argc, argv, settings))
+	{
+		PrintUsage();
+		return 1;
+	}
+	
+	unsigned int hierarchySize = 0;
+	for(unsigned int level = 0, width = 1; level < settings.m_depth; ++level, width *= settings.m_fanout)
+	{
+		hierarchySize += width;
+	}
+	const unsigned int hierarchyCount = std::max(1u, settings.m_objects / hierarchySize);
+	const unsigned int mutationCount = (unsigned int)(settings.m_mutation * hierarchyCount * hierarchySize);
+	
+	CStressScene stressScene(settings);
+	for(unsigned int i = 0; i < hierarchyCount; ++i)
+	{
+		stressScene.Spawn();
+	}
+	
+	std::cout << "scene " << hierarchyCount * hierarchySize << " game objects in " << hierarchyCount
+		<< " hierarchies of " << hierarchySize << " (depth " << settings.m_depth << ", fan-out " << settings.m_fanout << "), "
+		<< settings.m_components << " components each" << std::endl;
+	std::cout << "per frame " << settings.m_churn << " hierarchies destroyed and spawned, "
+		<< mutationCount << " transform writes" << std::endl;
+	
+	stressScene.Scene().CompactionBudget(settings.m_compaction);
+	
+	CSharedSceneExporter exporter;
+	if(settings.mp_exportName)
+	{
+		if(!exporter.Open(settings.mp_exportName, hierarchyCount * hierarchySize))
+		{
+			std::cerr << "Can't create the shared memory " << settings.mp_exportName << std::endl;
+			return 1;
+		}
+		stressScene.Scene().Export(&exporter);
+	}
+	stressScene.Scene().Update();
+	const CLocality localityAtStart = stressScene.Scene().Locality();
+	
+	TFrameTimeList frameTimeList;
+	frameTimeList.reserve(settings.m_frames);
+	uint64_t allocationCount = 0;
+	uint64_t allocationBytes = 0;
+	uint64_t maxFrameAllocations = 0;
+	
+	for(unsigned int frame = 0; frame < settings.m_warmup + settings.m_frames; ++frame)
+	{
+		const uint64_t countAtStart = s_allocationCount.load(std::memory_order_relaxed);
+		const uint64_t bytesAtStart = s_allocationBytes.load(std::memory_order_relaxed);
+		const uint64_t startNs = CProfiler::NowNs();
+		
+		for(unsigned int i = 0; i < settings.m_churn; ++i)
+		{
+			stressScene.Despawn();
+			stressScene.Spawn();
+		}
+		stressScene.Mutate(mutationCount);
+		stressScene.Scene().Update();
+		
+		const uint64_t frameNs = CProfiler::NowNs() - startNs;
+		const uint64_t frameAllocations = s_allocationCount.load(std::memory_order_relaxed) - countAtStart;
+		const uint64_t frameBytes = s_allocationBytes.load(std::memory_order_relaxed) - bytesAtStart;
+		
+		if(frame >= settings.m_warmup)
+		{
+			frameTimeList.push_back(frameNs);
+			allocationCount += frameAllocations;
+			allocationBytes += frameBytes;
+			maxFrameAllocations = std::max(maxFrameAllocations, frameAllocations);
+		}
+	}
+	
+	std::cout << "frames " << settings.m_frames << " (+" << settings.m_warmup << " warm-up)" << std::endl;
+	PrintFrameTimes(std::cout, frameTimeList);
+	std::cout << "allocations " << (double)allocationCount / settings.m_frames << " per frame ("
+		<< (double)allocationBytes / settings.m_frames << " bytes), max " << maxFrameAllocations << " in a frame" << std::endl;
+	std::cout << "peak RSS " << PeakResidentMB() << " MB" << std::endl;
+	PrintLocality(std::cout, "at start", localityAtStart);
+	PrintLocality(std::cout, "at end", stressScene.Scene().Locality());
+	if(settings.m_compaction)
+	{
+		std::cout << "compaction passes " << stressScene.Scene().CompactionPasses() << std::endl;
+	}
+	
+	return 0;
+}